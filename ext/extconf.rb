@@ -3,6 +3,22 @@ require 'mkmf'
 dir_config('lpsolve')
 $libs = append_library($libs, "m -ldl -llpsolve55 -lm")
 
+# Writing models to Ruby Strings and IO objects goes through a
+# callback-backed FILE *. Without either of these we fall back to a
+# temporary file.
+have_func('fopencookie', 'stdio.h') or have_func('funopen', 'stdio.h')
+
+# Optional transparent compression of model files: ".gz" needs zlib and
+# ".zst" needs libzstd.
+have_library('z', 'gzopen', 'zlib.h')
+have_library('zstd', 'ZSTD_compressStream2', 'zstd.h')
+
+# Binary model snapshots are memory-mapped when possible.
+have_header('sys/mman.h')
+
+# LPSolve.read_many parses files on several native threads.
+have_header('pthread.h')
+
 config_file = File.join(File.dirname(__FILE__), 'config_options.rb')
 load config_file if File.exist?(config_file)
 
@@ -100,6 +100,17 @@ init_lpsolve_constants()
   rb_define_const(rb_cLPSolve, "NODE_STRONGINIT", 
 		  INT2FIX(NODE_STRONGINIT));
 
+  /* Branching directions, for set_var_branch() */
+  rb_define_const(rb_cLPSolve, "BRANCH_CEILING",   INT2FIX(BRANCH_CEILING));
+  rb_define_const(rb_cLPSolve, "BRANCH_FLOOR",     INT2FIX(BRANCH_FLOOR));
+  rb_define_const(rb_cLPSolve, "BRANCH_AUTOMATIC", INT2FIX(BRANCH_AUTOMATIC));
+  rb_define_const(rb_cLPSolve, "BRANCH_DEFAULT",   INT2FIX(BRANCH_DEFAULT));
+
+  /* Kinds of branching variable, passed to put_bb_nodefunc() blocks */
+  rb_define_const(rb_cLPSolve, "BB_INT", INT2FIX(BB_INT));
+  rb_define_const(rb_cLPSolve, "BB_SC",  INT2FIX(BB_SC));
+  rb_define_const(rb_cLPSolve, "BB_SOS", INT2FIX(BB_SOS));
+
   /* Presolve constants used in a bitmask */
   rb_define_const(rb_cLPSolve, "PRESOLVE_NONE",        INT2FIX(PRESOLVE_NONE));
   rb_define_const(rb_cLPSolve, "PRESOLVE_ROWS",        INT2FIX(PRESOLVE_ROWS));
@@ -155,6 +166,15 @@ init_lpsolve_constants()
   rb_define_const(rb_cLPSolve, "SIMPLEX_DUAL_DUAL",   
 		  INT2FIX(SIMPLEX_DUAL_DUAL));
 
+  /* Events for put_msgfunc. */
+  rb_define_const(rb_cLPSolve, "MSG_PRESOLVE",     INT2FIX(MSG_PRESOLVE));
+  rb_define_const(rb_cLPSolve, "MSG_LPFEASIBLE",   INT2FIX(MSG_LPFEASIBLE));
+  rb_define_const(rb_cLPSolve, "MSG_LPOPTIMAL",    INT2FIX(MSG_LPOPTIMAL));
+  rb_define_const(rb_cLPSolve, "MSG_MILPFEASIBLE", 
+		  INT2FIX(MSG_MILPFEASIBLE));
+  rb_define_const(rb_cLPSolve, "MSG_MILPEQUAL",    INT2FIX(MSG_MILPEQUAL));
+  rb_define_const(rb_cLPSolve, "MSG_MILPBETTER",   INT2FIX(MSG_MILPBETTER));
+
   /* Solve return codes. */
   rb_define_const(rb_cLPSolve, "NOMEMORY",    INT2FIX(NOMEMORY));
   rb_define_const(rb_cLPSolve, "OPTIMAL",     INT2FIX(OPTIMAL));
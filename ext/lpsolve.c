@@ -14,9 +14,30 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <ruby.h>
+#include <ruby/thread.h>
 #include <stdio.h>
 #include <lpsolve/lp_lib.h>
 #include <lpsolve/lp_report.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 /** \file lpsolve.c
  *
@@ -294,7 +315,13 @@ if (NULL == lp) return Qnil;                    \
     return Qtrue;                                               \
   }
 
-#define LPSOLVE_SET_VARTYPE(fn)                                         \
+/** \def LPSOLVE_SET_VARTYPE
+
+   A macro used in defining a Ruby method which sets a boolean type
+   flag of a column. \a kind is the undo_kind_t the change is recorded
+   as inside a transaction.
+*/
+#define LPSOLVE_SET_VARTYPE(fn, kind)                                   \
 static VALUE                                                            \
  lpsolve_ ## fn (VALUE self, VALUE column_num,  VALUE new_bool)         \
 {                                                                       \
@@ -304,898 +331,3456 @@ static VALUE                                                            \
            "%s: Parameter is not a boolean or nil.\n",                  \
            __FUNCTION__);                                               \
     return Qfalse;                                                      \
+  } else if (!index_ok(lp, __FUNCTION__, -1, FIX2INT(column_num))) {   \
+    return Qfalse;                                                      \
   } else {                                                              \
-    RETURN_BOOL(fn(lp, FIX2INT(column_num), Qtrue == new_bool));        \
+    journal_note(self, lp, kind, 0, FIX2INT(column_num));               \
+    RETURN_BOOL(journal_done(self, fn(lp, FIX2INT(column_num),          \
+                                      Qtrue == new_bool), 1));          \
   }                                                                     \
 }
 
 
-static VALUE
-lpsolve_set_binary (VALUE self, VALUE column_num,       VALUE new_bool)
+/** \def LPSOLVE_STREAM_BUFSIZE
+
+   Size of the stdio buffer used on streams that feed a Ruby String or
+   IO object, or a compressor. Output is handed on in chunks of at
+   most this many bytes.
+*/
+#define LPSOLVE_STREAM_BUFSIZE (64 * 1024)
+
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#define HAVE_COOKIE_STREAMS 1
+#endif
+
+/** Callbacks behind a FILE * made by cookie_fopen(). Callbacks for a
+    direction the stream is not opened in may be \a NULL. read and
+    write return the number of bytes transferred, or -1 on error; close
+    returns 0 on success.
+*/
+typedef struct {
+  long (*read)(void *cookie, char *buf, long size);
+  long (*write)(void *cookie, const char *buf, long size);
+  int  (*close)(void *cookie);
+} cookie_funcs_t;
+
+#ifdef HAVE_COOKIE_STREAMS
+typedef struct {
+  void *cookie;
+  const cookie_funcs_t *funcs;
+} cookie_t;
+
+#if defined(HAVE_FOPENCOOKIE)
+static ssize_t
+cookie_read(void *p_cookie, char *buf, size_t size)
 {
-  INIT_LP;
-  if (new_bool != Qtrue && new_bool != Qfalse && new_bool != Qnil) {
-    report(lp, IMPORTANT,
-           "%s: Parameter is not a boolean or nil.\n",
-           __FUNCTION__);
-    return Qfalse;
-  } else {
-    RETURN_BOOL(set_binary(lp, FIX2INT(column_num), Qtrue == new_bool));
-  }
+  cookie_t *p = (cookie_t *) p_cookie;
+  return p->funcs->read(p->cookie, buf, (long) size);
 }
 
+static ssize_t
+cookie_write(void *p_cookie, const char *buf, size_t size)
+{
+  cookie_t *p = (cookie_t *) p_cookie;
+  long written = p->funcs->write(p->cookie, buf, (long) size);
+  /* fopencookie() expects 0, not -1, for a failed write. */
+  return written < 0 ? 0 : written;
+}
+#else
+static int
+cookie_read(void *p_cookie, char *buf, int size)
+{
+  cookie_t *p = (cookie_t *) p_cookie;
+  return (int) p->funcs->read(p->cookie, buf, size);
+}
 
-/** Holder for LPSolve class object. A singleton value. */
-VALUE rb_cLPSolve;
+static int
+cookie_write(void *p_cookie, const char *buf, int size)
+{
+  cookie_t *p = (cookie_t *) p_cookie;
+  return (int) p->funcs->write(p->cookie, buf, size);
+}
+#endif
 
-static void lpsolve_free(void *lp);
+static int
+cookie_close(void *p_cookie)
+{
+  cookie_t *p = (cookie_t *) p_cookie;
+  int rc = (NULL != p->funcs->close) ? p->funcs->close(p->cookie) : 0;
+  free(p);
+  return rc;
+}
+#endif /* HAVE_COOKIE_STREAMS */
 
-/** 
- A wrapper for add_constraintex.
+/** Open a stdio stream whose reads or writes are served by \a funcs
+    on \a cookie. \a mode is "r" or "w". When the stream is closed,
+    funcs->close is called on \a cookie.
 
- Adds a constraint. These routines will perform much better when
- lpsolve_set_add_rowmode() is called before adding constraints.
+    @return the stream, or \a NULL if it could not be created or if
+    the platform lacks fopencookie() and funopen().
+*/
+static FILE *
+cookie_fopen(void *cookie, const char *mode, const cookie_funcs_t *funcs)
+{
+#ifdef HAVE_COOKIE_STREAMS
+  FILE *fp;
+  cookie_t *p = malloc(sizeof(cookie_t));
+  MYBOOL b_read = ('r' == mode[0]);
+  if (NULL == p) return NULL;
+  p->cookie = cookie;
+  p->funcs  = funcs;
+#if defined(HAVE_FOPENCOOKIE)
+  {
+    cookie_io_functions_t io_funcs;
+    memset(&io_funcs, 0, sizeof(io_funcs));
+    if (b_read) io_funcs.read = cookie_read;
+    else        io_funcs.write = cookie_write;
+    io_funcs.close = cookie_close;
+    fp = fopencookie(p, mode, io_funcs);
+  }
+#else
+  fp = funopen(p, b_read ? cookie_read : NULL, b_read ? NULL : cookie_write,
+               NULL, cookie_close);
+#endif
+  if (NULL == fp) {
+    free(p);
+    return NULL;
+  }
+  setvbuf(fp, NULL, _IOFBF, LPSOLVE_STREAM_BUFSIZE);
+  return fp;
+#else
+  return NULL;
+#endif
+}
 
- @param self self
- @param name The name of the constraint or \a nil if no name.
+/** State behind a FILE * whose output goes to a Ruby String or to
+    an object that responds to write(), e.g. an IO or StringIO.
+*/
+typedef struct {
+  VALUE target;     /**< String to append to or IO-like object. */
+  int   state;      /**< rb_protect() state of a failed write, or 0. */
+  MYBOOL detached;  /**< If true, output is silently dropped. */
+} rbstream_t;
 
- @param row_coeffs A list of tuples. The first entry of the tuple is
- the column number which should be in the range 0..columns-1; the
- second entry in the tuple should be the coefficient value.
+static VALUE
+rbstream_call_write(VALUE args)
+{
+  VALUE *p_args = (VALUE *) args;
+  return rb_funcall(p_args[0], rb_intern("write"), 1, p_args[1]);
+}
 
- @param constr_type The constraint type. Should be one of 
- \a LPSolve::LE, \a LPSolve::EQ, \a LPSolve::GE.
+static VALUE
+rbstream_call_append(VALUE args)
+{
+  VALUE *p_args = (VALUE *) args;
+  return rb_str_append(p_args[0], p_args[1]);
+}
 
- @param rh The right-hand-side constant, a number.
+/* Pass size bytes of buf on to the Ruby target. Exceptions raised by
+   the target, by its write() or by appending to a String that has
+   been frozen, must not unwind through stdio and lp_solve, so they
+   are caught here, remembered and re-raised by rbstream_close().
+*/
+static long
+rbstream_write(void *cookie, const char *buf, long size)
+{
+  rbstream_t *p_rbs = (rbstream_t *) cookie;
+  VALUE args[2];
+  if (p_rbs->state) return -1;
+  if (p_rbs->detached) return size;
+  args[0] = p_rbs->target;
+  args[1] = rb_str_new(buf, size);
+  rb_protect((TYPE(p_rbs->target) == T_STRING) ? rbstream_call_append 
+             : rbstream_call_write, (VALUE) args, &p_rbs->state);
+  if (p_rbs->state) return -1;
+  return size;
+}
 
- @return number of rows, (the row number of the constraint added) if
- successful or \a nil on error.
+static const cookie_funcs_t rbstream_funcs = {NULL, rbstream_write, NULL};
+
+/** Open a write stream whose output goes to \a target, a Ruby String
+    or an object responding to write(). \a p_rbs must stay valid until
+    rbstream_close() is called and \a target must be reachable by the
+    garbage collector while the stream is open.
 
+    @return the stream or \a NULL if it could not be created.
 */
-static VALUE 
-lpsolve_add_constraintex(VALUE self, VALUE name, VALUE row_coeffs, 
-                         VALUE constr_type, VALUE rh) 
+static FILE *
+rbstream_open(rbstream_t *p_rbs, VALUE target)
 {
-  int i_constr_type = FIX2INT(constr_type);
-  REAL r_rh = NUM2DBL(rh);
-  REAL *row = NULL;
-  int *colno = NULL;
-  long int i, count;
-  VALUE ret = Qnil;
-  MYBOOL b_ret;
-  VALUE *p_row_coeff = NULL;
+  p_rbs->target   = target;
+  p_rbs->state    = 0;
+  p_rbs->detached = FALSE;
+#ifdef HAVE_COOKIE_STREAMS
+  return cookie_fopen(p_rbs, "w", &rbstream_funcs);
+#else
+  /* Spool to a temporary file; rbstream_close() copies it to target. */
+  return tmpfile();
+#endif
+}
 
-  INIT_LP;
+/** Flush and close a stream opened by rbstream_open(). If the
+    target's write() raised an exception, it is re-raised here, after
+    the stream has been closed.
 
-  if (TYPE(name) != T_STRING && name != Qnil) {
-    report(lp, IMPORTANT, 
-           "%s: constraint name, parameter 1, should be nil or a string.\n", 
-           __FUNCTION__);
-    return Qnil;
-  }
+    @return 0 if all output was delivered, EOF otherwise.
+*/
+static int
+rbstream_close(rbstream_t *p_rbs, FILE *fp)
+{
+  int rc;
+#ifndef HAVE_COOKIE_STREAMS
+  char buf[BUFSIZ];
+  size_t len;
+  fflush(fp);
+  rewind(fp);
+  while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+    if (rbstream_write(p_rbs, buf, len) < 0) break;
+#endif
+  rc = fclose(fp);
+  if (p_rbs->state) rb_jump_tag(p_rbs->state);
+  return rc;
+}
 
-  if (TYPE(row_coeffs) != T_ARRAY) {
-    report(lp, IMPORTANT, 
-           "%s: row coefficients, parameter 2 is not an array.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
+/** Compression of a model file, as told by its file name suffix. */
+typedef enum {
+  COMPRESS_NONE,   /**< Plain text file. */
+  COMPRESS_GZIP,   /**< ".gz": zlib/gzip. */
+  COMPRESS_ZSTD    /**< ".zst": Zstandard. */
+} compression_t;
 
-  if (TYPE(constr_type) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: constraint type, parameter 3, is not a number.\n", 
-           __FUNCTION__);
-    return Qnil;
-  }
+static compression_t
+compression_of(const char *filename)
+{
+  size_t len = strlen(filename);
+  if (len > 3 && 0 == strcmp(filename + len - 3, ".gz"))
+    return COMPRESS_GZIP;
+  if (len > 4 && 0 == strcmp(filename + len - 4, ".zst"))
+    return COMPRESS_ZSTD;
+  return COMPRESS_NONE;
+}
 
-  switch (i_constr_type) {
-  case EQ:
-  case GE:
-  case LE: break;
-  default:
-    report(lp, IMPORTANT, 
-           "%s: constraint type, parameter 3, should be LE, EQ, or GE.\n", 
-           __FUNCTION__);
-    return Qnil;
-  }
-  
-  /***FIXME: combine common parts of this with add_constraintex ****/
-  count   = RARRAY_LEN(row_coeffs);
+/** What this build lacks to open \a filename, e.g. "zlib" for a ".gz"
+    file when built without zlib, or \a NULL if it can be opened. */
+static const char *
+compression_missing(const char *filename)
+{
+  compression_t compression = compression_of(filename);
+  if (COMPRESS_NONE == compression) return NULL;
+#ifndef HAVE_COOKIE_STREAMS
+  return "fopencookie() or funopen()";
+#else
+#ifndef HAVE_LIBZ
+  if (COMPRESS_GZIP == compression) return "zlib";
+#endif
+#ifndef HAVE_LIBZSTD
+  if (COMPRESS_ZSTD == compression) return "Zstandard";
+#endif
+  return NULL;
+#endif
+}
 
-  if (0 == count)  {
-    report(lp, IMPORTANT, 
-           "%s: row coefficients array has to have at least one item.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
+#ifdef HAVE_LIBZ
+static long
+gzfile_read(void *cookie, char *buf, long size)
+{
+  return gzread((gzFile) cookie, buf, (unsigned int) size);
+}
 
-  colno   = ALLOC_N(int, count);
-  row     = ALLOC_N(REAL, count);
+static long
+gzfile_write(void *cookie, const char *buf, long size)
+{
+  int written = gzwrite((gzFile) cookie, buf, (unsigned int) size);
+  return (written > 0) ? written : -1;
+}
 
-  p_row_coeff = RARRAY_PTR(row_coeffs);
-  for (i = 0; i < count; i++) {
-    int i_col;
-    if (TYPE(*p_row_coeff) != T_ARRAY) {
-      report(lp, IMPORTANT, 
-             "%s: row coeffient element %d is not an array.\n", 
-             __FUNCTION__, i);
-      goto done;
-    }
-    if (RARRAY_LEN(*p_row_coeff) != 2) {
-      report(lp, IMPORTANT, 
-             "%s: row coeffient element %d is not an array tuple.\n", 
-             __FUNCTION__, i);
-      goto done;
-    } else {
-      VALUE *tuple = RARRAY_PTR(*p_row_coeff);
-      if (TYPE(tuple[0]) != T_FIXNUM) {
-        report(lp, IMPORTANT, 
-               "%s: Column number, first element, of row coefficients at " \
-               "tuple %d is not a integer.\n", __FUNCTION__, i);
-        goto done;
-      }
-      switch (TYPE(tuple[1])) {
-      case T_FIXNUM:
-      case T_FLOAT: break;
-      default:
-        report(lp, IMPORTANT, 
-               "%s: Coefficient value, second element, of row coeffients at "
-               "tuple %d is not an integer.\n", __FUNCTION__, i);
-        goto done;
-      }
+static int
+gzfile_close(void *cookie)
+{
+  return (Z_OK == gzclose((gzFile) cookie)) ? 0 : EOF;
+}
 
-      i_col = FIX2INT(tuple[0]);
-      if (i_col <= 0 || i_col > lp->columns) {
-        report(lp, IMPORTANT, 
-               "%s: Column number, first element, of row coeffients at " \
-               "tuple %d, value %d, is not in the range 1..%d\n", 
-               __FUNCTION__, i, i_col, lp->columns);
-        goto done;
-      }
-      colno[i] = i_col;
-      row[i]   = NUM2DBL(tuple[1]);
-    }
-    p_row_coeff++;
+static const cookie_funcs_t gzfile_funcs = {
+  gzfile_read, gzfile_write, gzfile_close
+};
+#endif /* HAVE_LIBZ */
+
+#ifdef HAVE_LIBZSTD
+/** A Zstandard stream over a plain FILE *. Only one of dctx and cctx
+    is used, depending on the direction the file was opened in. */
+typedef struct {
+  FILE *raw;
+  ZSTD_DCtx *dctx;
+  ZSTD_CCtx *cctx;
+  void *buf;             /**< compressed-side buffer */
+  size_t buf_size;
+  ZSTD_inBuffer in;      /**< unread compressed input (reading) */
+} zstdfile_t;
+
+static long
+zstdfile_read(void *cookie, char *buf, long size)
+{
+  zstdfile_t *p = (zstdfile_t *) cookie;
+  ZSTD_outBuffer out;
+  out.dst  = buf;
+  out.size = size;
+  out.pos  = 0;
+  for (;;) {
+    size_t rc = ZSTD_decompressStream(p->dctx, &out, &p->in);
+    if (ZSTD_isError(rc)) return -1;
+    if (out.pos > 0) return (long) out.pos;
+    if (p->in.pos < p->in.size) continue;
+    p->in.size = fread(p->buf, 1, p->buf_size, p->raw);
+    p->in.pos  = 0;
+    if (0 == p->in.size) return ferror(p->raw) ? -1 : 0;
   }
+}
 
-  b_ret = add_constraintex(lp, count, row, colno, i_constr_type, r_rh);
-  if (b_ret) {
-    ret = INT2FIX(lp->rows);
-    if (name != Qnil) 
-      set_row_name(lp, lp->rows, RSTRING_PTR(name));
-  }
+/* Compress in_buf with the given end directive and write out what
+   comes out. */
+static MYBOOL
+zstdfile_compress(zstdfile_t *p, ZSTD_inBuffer *in, ZSTD_EndDirective mode)
+{
+  size_t remaining;
+  do {
+    ZSTD_outBuffer out;
+    out.dst  = p->buf;
+    out.size = p->buf_size;
+    out.pos  = 0;
+    remaining = ZSTD_compressStream2(p->cctx, &out, in, mode);
+    if (ZSTD_isError(remaining)) return FALSE;
+    if (fwrite(p->buf, 1, out.pos, p->raw) != out.pos) return FALSE;
+  } while ((ZSTD_e_end == mode) ? (remaining > 0) : (in->pos < in->size));
+  return TRUE;
+}
 
- done:
-  free(row);
-  free(colno);
-  return ret;
+static long
+zstdfile_write(void *cookie, const char *buf, long size)
+{
+  ZSTD_inBuffer in;
+  in.src  = buf;
+  in.size = size;
+  in.pos  = 0;
+  return zstdfile_compress((zstdfile_t *) cookie, &in, ZSTD_e_continue)
+    ? size : -1;
 }
 
-/** 
- A wrapper for add_SOS.
+static int
+zstdfile_close(void *cookie)
+{
+  zstdfile_t *p = (zstdfile_t *) cookie;
+  int rc = 0;
+  if (NULL != p->cctx) {
+    ZSTD_inBuffer in = {NULL, 0, 0};
+    if (!zstdfile_compress(p, &in, ZSTD_e_end)) rc = EOF;
+    ZSTD_freeCCtx(p->cctx);
+  }
+  if (NULL != p->dctx) ZSTD_freeDCtx(p->dctx);
+  if (0 != fclose(p->raw)) rc = EOF;
+  free(p->buf);
+  free(p);
+  return rc;
+}
 
- Adds an SOS constraint. A Special Ordered Set of Type n is a way of
- indicating that at most n of a set of variables may be nonzero.
+static const cookie_funcs_t zstdfile_funcs = {
+  zstdfile_read, zstdfile_write, zstdfile_close
+};
 
- @param self self
- @param name The name of the SOS constraint.
+static zstdfile_t *
+zstdfile_open(const char *filename, MYBOOL b_read)
+{
+  zstdfile_t *p = calloc(1, sizeof(zstdfile_t));
+  if (NULL == p) return NULL;
+  p->raw = fopen(filename, b_read ? "rb" : "wb");
+  if (b_read) {
+    p->dctx     = ZSTD_createDCtx();
+    p->buf_size = ZSTD_DStreamInSize();
+  } else {
+    p->cctx     = ZSTD_createCCtx();
+    p->buf_size = ZSTD_CStreamOutSize();
+  }
+  p->buf   = malloc(p->buf_size);
+  p->in.src = p->buf;
+  if (NULL == p->raw || NULL == p->buf || (NULL == p->dctx && NULL == p->cctx)) {
+    if (NULL != p->raw) fclose(p->raw);
+    ZSTD_freeDCtx(p->dctx);
+    ZSTD_freeCCtx(p->cctx);
+    free(p->buf);
+    free(p);
+    return NULL;
+  }
+  return p;
+}
+#endif /* HAVE_LIBZSTD */
 
- @param sos_type The type of the SOS constraint, 1 means "at most 1" 2
- means "at most 2".  Must be >= 1.
- @param priority Priority of the SOS constraint in the SOS set.
- @param sos_vars  A list of tuples of column numbers and weights
+/** Open a model file for reading (\a mode "r") or writing ("w"). A
+    ".gz" or ".zst" file is decompressed or compressed on the fly as it
+    is read or written, so it never needs to be inflated on disk.
 
+    @return the stream, or \a NULL if the file cannot be opened or its
+    compression is not supported by this build.
 */
-static VALUE 
-lpsolve_add_SOS(VALUE self, VALUE name, VALUE sos_type, VALUE priority, 
-                VALUE sos_vars) 
+static FILE *
+model_fopen(const char *filename, const char *mode)
 {
-  int i_sos_type = FIX2INT(sos_type);
-  int i_priority = FIX2INT(priority);
-  int *vars = NULL;
-  double *weights = NULL;
-  long int i, count;
-  VALUE *p_sos_var;
-  VALUE ret = Qnil;
-  int i_ret = 0;
-
-  INIT_LP;
-  
-  if (TYPE(sos_type) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: SOS type, parameter 2, is not a number.\n", __FUNCTION__);
-    return Qnil;
-  }
-  
-  if (TYPE(priority) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: priority, parameter 3, not a number.\n", __FUNCTION__);
-    return Qnil;
-  }
-  if (TYPE(name) != T_STRING) {
-    report(lp, IMPORTANT, "%s: name is not a string.\n", __FUNCTION__);
-    return Qnil;
+  MYBOOL b_read = ('r' == mode[0]);
+  switch (compression_of(filename)) {
+#ifdef HAVE_LIBZ
+  case COMPRESS_GZIP: {
+    FILE *fp;
+    gzFile gz = gzopen(filename, b_read ? "rb" : "wb");
+    if (NULL == gz) return NULL;
+    fp = cookie_fopen(gz, mode, &gzfile_funcs);
+    if (NULL == fp) gzclose(gz);
+    return fp;
   }
-  if (i_sos_type < 1) {
-    report(lp, IMPORTANT, "%s: SOS type (%ld) is less than 1.\n",
-           __FUNCTION__, i_sos_type);
-    return Qnil;
+#endif
+#ifdef HAVE_LIBZSTD
+  case COMPRESS_ZSTD: {
+    FILE *fp;
+    zstdfile_t *p = zstdfile_open(filename, b_read);
+    if (NULL == p) return NULL;
+    fp = cookie_fopen(p, mode, &zstdfile_funcs);
+    if (NULL == fp) zstdfile_close(p);
+    return fp;
   }
-  
-  if (TYPE(sos_vars) != T_ARRAY) {
-    report(lp, IMPORTANT, "%s: SOS vars is not an array.\n", __FUNCTION__);
-    return Qnil;
+#endif
+  case COMPRESS_NONE:
+    return fopen(filename, mode);
+  default:
+    return NULL;
   }
+}
 
-  count   = RARRAY_LEN(sos_vars);
+/** Model file formats for read_model() and write_model(). */
+typedef enum {
+  MODEL_LP,    /**< lp_solve LP format */
+  MODEL_MPS    /**< fixed MPS format */
+} model_format_t;
 
-  if (0 == count)  {
-    report(lp, IMPORTANT, 
-           "%s: SOS vars array has to have at least one item.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
-
-  vars    = ALLOC_N(int, count);
-  weights = ALLOC_N(double, count);
-
-  p_sos_var = RARRAY_PTR(sos_vars);
-  for (i = 0; i < count; i++) {
-    if (TYPE(*p_sos_var) != T_ARRAY) {
-      report(lp, IMPORTANT, 
-             "%s: SOS vars element %d is not an array.\n", __FUNCTION__, i);
-      goto done;
-    }
-    if (RARRAY_LEN(*p_sos_var) != 2) {
-      report(lp, IMPORTANT, 
-             "%s: SOS vars element %d is not an array tuple.\n", __FUNCTION__,
-             i);
-      goto done;
-    } else {
-      VALUE *tuple = RARRAY_PTR(*p_sos_var);
-      if (TYPE(tuple[0]) != T_FIXNUM) {
-        report(lp, IMPORTANT, 
-               "%s: First element of SOS vars at tuple %d " \
-               "is not a integer.\n",  __FUNCTION__, i);
-        goto done;
-      }
-      if (TYPE(tuple[1]) != T_FIXNUM) {
-        report(lp, IMPORTANT, 
-               "%s: Second element of SOS vars at tuple %d " \
-               "is not an integer.\n", __FUNCTION__, i);
-        goto done;
-      }
-      vars[i] = FIX2INT(tuple[0]);
-      weights[i] = FIX2INT(tuple[1]);
-    }
-    p_sos_var++;
-  }
-  i_ret = add_SOS(lp, RSTRING_PTR(name), i_sos_type, i_priority, 
-                  count, vars, weights);
-  if (i_ret != 0)
-    ret = INT2FIX(i_ret);
-
- done:
-  free(vars);
-  free(weights);
-  return ret;
+/* Parse a model in \a format from \a fp. */
+static lprec *
+parse_model(FILE *fp, model_format_t format, int verbosity, char *lp_name)
+{
+  if (MODEL_LP == format) return read_lp(fp, verbosity, lp_name);
+  return read_mps(fp, verbosity);
 }
 
-/** Allocate a Ruby container for a lprec * pointer. Ruby may call
-    this routine directly under various circumstances such as when
-    doing data marshalling. However usually the most common case is
-    when new() is called.  Here, after the call to lpsolve_alloc(),
-    Ruby will call lpsolve_initialize(). 
+/** Read a model from \a filename, which may be compressed; see
+    model_fopen(). This uses no Ruby API.
+
+    @return the new lprec or \a NULL on error.
 */
-static VALUE 
-lpsolve_alloc(VALUE klass) 
+static lprec *
+read_model(const char *filename, model_format_t format, int verbosity,
+           char *lp_name)
 {
-  VALUE obj;
-  obj = Data_Wrap_Struct(klass, 0, lpsolve_free, NULL);
-  return obj;
+  lprec *lp;
+  FILE *fp = model_fopen(filename, "r");
+  if (NULL == fp) return NULL;
+  lp = parse_model(fp, format, verbosity, lp_name);
+  fclose(fp);
+  return lp;
 }
 
-/** A wrapper for default_basis().
+/** Write the model to \a filename in \a format, compressing it if the
+    file name asks for that; see model_fopen().
 
-    Sets the starting base to an all slack basis (the default simplex
-    starting basis).
-    
-    @param self self
-    @return \a true unless we have an error.
+    @return \a TRUE if the whole model was written.
 */
-static VALUE lpsolve_default_basis(VALUE self);
-LPSOLVE_0_IN_STATUS_OUT(default_basis)
-
-/** A wrapper for del_column().
-
-    @param self self
-    @param column_num column number
+static MYBOOL
+write_model(lprec *lp, const char *filename, model_format_t format)
+{
+  MYBOOL b_ret;
+  const char *psz_missing = compression_missing(filename);
+  FILE *fp;
+  if (NULL != psz_missing) {
+    report(lp, IMPORTANT, "%s: Cannot compress %s: built without %s.\n",
+           __FUNCTION__, filename, psz_missing);
+    return FALSE;
+  }
+  fp = model_fopen(filename, "w");
+  if (NULL == fp) {
+    report(lp, IMPORTANT, "%s: Cannot open %s for writing.\n",
+           __FUNCTION__, filename);
+    return FALSE;
+  }
+  b_ret = (MODEL_LP == format) ? write_LP(lp, fp) : write_MPS(lp, fp);
+  if (0 != fclose(fp)) b_ret = FALSE;
+  return b_ret;
+}
 
-    @return \a true if the operation was successful. false indicates an
-    error.  An error occurs when column is not between 1 and the number
-    of columns in the lp.  Note that row entry mode must be off, else
-    this function also fails.
+/** Run \a writer, e.g. write_LP(), sending its output to \a target, a
+    Ruby String or an object responding to write().
 
-    @see lpsolve_set_add_rowmode()
+    @return \a TRUE if the model was written completely.
 */
-static VALUE lpsolve_del_column(VALUE self, VALUE column_num);
-LPSOLVE_1_IN_BOOL_OUT(del_column, T_FIXNUM, "an integer", FIX2INT);
-
-/** A wrapper for del_constraint()
-
-  del_constraint returns true if the operation was successful. 
-
-  @param self self
-  @param row_num row number
+static MYBOOL
+write_model_rb(lprec *lp, MYBOOL (*writer)(lprec *, FILE *), VALUE target)
+{
+  rbstream_t rbs;
+  MYBOOL b_ret;
+  FILE *fp = rbstream_open(&rbs, target);
+  if (NULL == fp) {
+    report(lp, IMPORTANT, "%s: Cannot open an output stream.\n",
+           __FUNCTION__);
+    return FALSE;
+  }
+  b_ret = writer(lp, fp);
+  if (0 != rbstream_close(&rbs, fp)) b_ret = FALSE;
+  return b_ret;
+}
 
-  @return a \a false value indicates an error.  An error occurs when
-  row_num is not between 1 and the number of rows self.  Note that row
-  entry mode must be off, else this function also fails. @see
-  lpsolve_set_add_rowmode().
+/* Native binary model snapshots.
+
+   A snapshot is a header followed by sections, each padded to a
+   multiple of 8 bytes so that arrays can be used straight out of a
+   memory-mapped file:
+
+     int  col_start[columns+1]      CSC column starts into the next two
+     int  row_index[nz]             row numbers; row 0 is the objective
+     REAL value[nz]
+     REAL rh[rows+1]                rh[0] is the objective constant
+     REAL rh_range[rows+1]
+     int  constr_type[rows+1]
+     REAL lowbo[columns+1]
+     REAL upbo[columns+1]
+     char col_type[columns+1]       SNAPSHOT_INT | SNAPSHOT_SEMICONT
+     int  int_params[n_int_params]
+     REAL real_params[n_real_params]
+     int  row_name[rows+1]          offsets into names, -1 if unnamed
+     int  col_name[columns+1]
+     char names[names_size]         NUL-terminated strings
+     SOS records, sos_size bytes in all. Each is
+       int [4] {name offset, type, priority, count},
+       int members[count], REAL weights[count]
+
+   Integers and reals are stored in the writer's native format; the
+   header records enough to refuse a snapshot from an incompatible
+   machine. Readers ignore parameters past the ones they know, so
+   parameters can be appended without bumping the version.
 */
-static VALUE lpsolve_del_constraint(VALUE self, VALUE row_num);
-LPSOLVE_1_IN_BOOL_OUT(del_constraint, T_FIXNUM, "an integer", FIX2INT);
-
+#define SNAPSHOT_MAGIC    "LPSNAP\r\n"
+#define SNAPSHOT_VERSION  1
+#define SNAPSHOT_ORDER    0x01020304
+#define SNAPSHOT_ALIGN(n) (((n) + 7) & ~((size_t) 7))
+
+#define SNAPSHOT_MAXIM    1   /**< header flag: maximize */
+#define SNAPSHOT_INT      1   /**< col_type flag */
+#define SNAPSHOT_SEMICONT 2   /**< col_type flag */
+
+typedef struct {
+  char magic[8];
+  int  version;
+  int  byte_order;
+  int  int_size;
+  int  real_size;
+  int  rows;
+  int  columns;
+  int  nz;
+  int  flags;
+  int  n_int_params;
+  int  n_real_params;
+  int  names_size;
+  int  lp_name;       /**< offset into names, -1 if none */
+  int  sos_count;
+  int  sos_size;
+} snapshot_header_t;
+
+/* Index of each saved parameter in int_params[] or real_params[]. */
+enum {
+  SNAP_VERBOSE, SNAP_SCALING, SNAP_SIMPLEXTYPE, SNAP_PRESOLVE,
+  SNAP_PRESOLVELOOPS, SNAP_BB_RULE, SNAP_BB_DEPTHLIMIT, SNAP_FLOORFIRST,
+  SNAP_IMPROVE, SNAP_PIVOTING, SNAP_MAXPIVOT, SNAP_SOLUTIONLIMIT,
+  SNAP_BREAK_AT_FIRST,
+  SNAP_N_INT_PARAMS
+};
+enum {
+  SNAP_INFINITE, SNAP_EPSINT, SNAP_EPSB, SNAP_EPSD, SNAP_EPSEL,
+  SNAP_EPSPIVOT, SNAP_MIP_GAP_ABS, SNAP_MIP_GAP_REL, SNAP_SCALELIMIT,
+  SNAP_BREAK_AT_VALUE, SNAP_NEGRANGE, SNAP_TIMEOUT,
+  SNAP_N_REAL_PARAMS
+};
+
+/* Read the solver parameters saved in a snapshot. */
+static void
+snapshot_get_params(lprec *lp, int *int_params, REAL *real_params)
+{
+  int_params[SNAP_VERBOSE]        = get_verbose(lp);
+  int_params[SNAP_SCALING]        = get_scaling(lp);
+  int_params[SNAP_SIMPLEXTYPE]    = get_simplextype(lp);
+  int_params[SNAP_PRESOLVE]       = get_presolve(lp);
+  int_params[SNAP_PRESOLVELOOPS]  = get_presolveloops(lp);
+  int_params[SNAP_BB_RULE]        = get_bb_rule(lp);
+  int_params[SNAP_BB_DEPTHLIMIT]  = get_bb_depthlimit(lp);
+  int_params[SNAP_FLOORFIRST]     = get_floorfirst(lp);
+  int_params[SNAP_IMPROVE]        = get_improve(lp);
+  int_params[SNAP_PIVOTING]       = get_pivoting(lp);
+  int_params[SNAP_MAXPIVOT]       = get_maxpivot(lp);
+  int_params[SNAP_SOLUTIONLIMIT]  = get_solutionlimit(lp);
+  int_params[SNAP_BREAK_AT_FIRST] = is_break_at_first(lp);
+  real_params[SNAP_INFINITE]       = get_infinite(lp);
+  real_params[SNAP_EPSINT]         = get_epsint(lp);
+  real_params[SNAP_EPSB]           = get_epsb(lp);
+  real_params[SNAP_EPSD]           = get_epsd(lp);
+  real_params[SNAP_EPSEL]          = get_epsel(lp);
+  real_params[SNAP_EPSPIVOT]       = get_epspivot(lp);
+  real_params[SNAP_MIP_GAP_ABS]    = get_mip_gap(lp, TRUE);
+  real_params[SNAP_MIP_GAP_REL]    = get_mip_gap(lp, FALSE);
+  real_params[SNAP_SCALELIMIT]     = get_scalelimit(lp);
+  real_params[SNAP_BREAK_AT_VALUE] = get_break_at_value(lp);
+  real_params[SNAP_NEGRANGE]       = get_negrange(lp);
+  real_params[SNAP_TIMEOUT]        = get_timeout(lp);
+}
 
+/* Apply the solver parameters read by snapshot_get_params(). */
 static void
-lpsolve_free(void *lp) 
+snapshot_set_params(lprec *lp, const int *int_params, const REAL *real_params)
 {
-#if DEBUG_GC
-  printf("lpsolve_free called\n");
-#endif
-  if (NULL != lp) delete_lp((lprec *)lp);
+  set_verbose(lp, int_params[SNAP_VERBOSE]);
+  set_scaling(lp, int_params[SNAP_SCALING]);
+  set_simplextype(lp, int_params[SNAP_SIMPLEXTYPE]);
+  set_presolve(lp, int_params[SNAP_PRESOLVE], 
+               int_params[SNAP_PRESOLVELOOPS]);
+  set_bb_rule(lp, int_params[SNAP_BB_RULE]);
+  set_bb_depthlimit(lp, int_params[SNAP_BB_DEPTHLIMIT]);
+  set_floorfirst(lp, int_params[SNAP_FLOORFIRST]);
+  set_improve(lp, int_params[SNAP_IMPROVE]);
+  set_pivoting(lp, int_params[SNAP_PIVOTING]);
+  set_maxpivot(lp, int_params[SNAP_MAXPIVOT]);
+  set_solutionlimit(lp, int_params[SNAP_SOLUTIONLIMIT]);
+  set_break_at_first(lp, (MYBOOL) int_params[SNAP_BREAK_AT_FIRST]);
+  set_epsint(lp, real_params[SNAP_EPSINT]);
+  set_epsb(lp, real_params[SNAP_EPSB]);
+  set_epsd(lp, real_params[SNAP_EPSD]);
+  set_epsel(lp, real_params[SNAP_EPSEL]);
+  set_epspivot(lp, real_params[SNAP_EPSPIVOT]);
+  set_mip_gap(lp, TRUE, real_params[SNAP_MIP_GAP_ABS]);
+  set_mip_gap(lp, FALSE, real_params[SNAP_MIP_GAP_REL]);
+  set_scalelimit(lp, real_params[SNAP_SCALELIMIT]);
+  set_break_at_value(lp, real_params[SNAP_BREAK_AT_VALUE]);
+  set_negrange(lp, real_params[SNAP_NEGRANGE]);
+  set_timeout(lp, (long) real_params[SNAP_TIMEOUT]);
 }
 
-/** A wrapper for get_bb_depthlimit(lprec *lp);
+/* Return the name explicitly given to row (is_row) or column i, or
+   NULL if it only has a default name like R1 or C1. */
+static char *
+explicit_name(lprec *lp, MYBOOL is_row, int i)
+{
+  hashelem **names = is_row ? lp->row_name : lp->col_name;
+  if (!lp->names_used || NULL == names || NULL == names[i] 
+      || NULL == names[i]->name)
+    return NULL;
+  return names[i]->name;
+}
 
-   get_bb_depthlimit returns the maximum branch-and-bound depth. 
+/* Write bytes from p followed by zero padding to a multiple of 8. */
+static MYBOOL
+snapshot_put(FILE *fp, const void *p, size_t bytes)
+{
+  static const char zeros[8] = {0};
+  size_t pad = SNAPSHOT_ALIGN(bytes) - bytes;
+  if (bytes > 0 && fwrite(p, 1, bytes, fp) != bytes) return FALSE;
+  return (0 == pad) || (fwrite(zeros, 1, pad, fp) == pad);
+}
 
-   Parameters
+/* Append a name to the pool of names and return its offset, or -1
+   for a NULL name. */
+static int
+snapshot_add_name(char **p_pool, int *p_size, int *p_alloc, const char *name)
+{
+  int offset = *p_size;
+  int len;
+  if (NULL == name) return -1;
+  len = strlen(name) + 1;
+  if (*p_size + len > *p_alloc) {
+    *p_alloc = 2 * (*p_size + len);
+    REALLOC_N(*p_pool, char, *p_alloc);
+  }
+  memcpy(*p_pool + offset, name, len);
+  *p_size += len;
+  return offset;
+}
 
-   lp
+/** Write a snapshot of the model, its parameters included, to \a fp.
 
-   Pointer to previously created lp model. See return value of make_lp, copy_lp, read_lp, read_LP, read_mps, read_freemps, read_MPS, read_freeMPS, read_XLI
+    @return \a TRUE unless there was a write error.
+*/
+static MYBOOL
+snapshot_write(lprec *lp, FILE *fp)
+{
+  snapshot_header_t header;
+  int rows = get_Nrows(lp);
+  int columns = get_Ncolumns(lp);
+  int max_nz = get_nonzeros(lp) + columns;
+  int *col_start  = ALLOC_N(int, columns + 1);
+  int *row_index  = ALLOC_N(int, max_nz + rows + 1);
+  REAL *value     = ALLOC_N(REAL, max_nz + rows + 1);
+  REAL *rows_buf  = ALLOC_N(REAL, 2 * (rows + 1));
+  int *constr_type = ALLOC_N(int, rows + 1);
+  int *row_ibuf   = ALLOC_N(int, rows + columns + 2);
+  REAL *col_buf   = ALLOC_N(REAL, 2 * (columns + 1));
+  char *col_type  = ALLOC_N(char, columns + 1);
+  int int_params[SNAP_N_INT_PARAMS];
+  REAL real_params[SNAP_N_REAL_PARAMS];
+  int names_alloc = 256, names_size = 0;
+  char *names = ALLOC_N(char, names_alloc);
+  size_t sos_alloc = 256, sos_size = 0;
+  char *sos = ALLOC_N(char, sos_alloc);
+  int sos_count = (NULL != lp->SOS) ? lp->SOS->sos_count : 0;
+  int i, j, nz = 0;
+  MYBOOL b_ret = TRUE;
+
+  /* Matrix, column by column; get_columnex() packs the nonzeros. */
+  col_start[0] = 0;
+  for (j = 1; j <= columns; j++) {
+    nz += get_columnex(lp, j, value + nz, row_index + nz);
+    col_start[j] = nz;
+  }
 
-   Remarks
-   
-   The get_bb_depthlimit function returns the maximum branch-and-bound
-   depth.  This is only useful if there are integer, semi-continious
-   or SOS variables in the model so that the branch-and-bound
-   algorithm must be used to solve them. The branch-and-bound
-   algorithm will not go deeper than this level. When 0 then there is
-   no limit to the depth. Limiting the depth will speed up solving
-   time, but there is a chance that the found solution is not the most
-   optimal one. Be aware of this. It can also result in not finding a
-   solution at all. A positive value means that the depth is
-   absolute. NOTE: in the standard lpsolve an absolute depth is
-   *added* to the number of SOS vars and semi-continuous vars. In a
-   hacked version of lpsolve, absolute is, well, absolute.
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version       = SNAPSHOT_VERSION;
+  header.byte_order    = SNAPSHOT_ORDER;
+  header.int_size      = sizeof(int);
+  header.real_size     = sizeof(REAL);
+  header.rows          = rows;
+  header.columns       = columns;
+  header.nz            = nz;
+  header.flags         = is_maxim(lp) ? SNAPSHOT_MAXIM : 0;
+  header.n_int_params  = SNAP_N_INT_PARAMS;
+  header.n_real_params = SNAP_N_REAL_PARAMS;
+  header.sos_count     = sos_count;
+
+  /* Names go into a pool so they can be read in place. */
+  header.lp_name = snapshot_add_name(&names, &names_size, &names_alloc,
+                                     get_lp_name(lp));
+  for (i = 0; i <= rows; i++)
+    row_ibuf[i] = snapshot_add_name(&names, &names_size, &names_alloc,
+                                    explicit_name(lp, TRUE, i));
+  for (j = 0; j <= columns; j++)
+    row_ibuf[rows + 1 + j] = 
+      snapshot_add_name(&names, &names_size, &names_alloc,
+                        explicit_name(lp, FALSE, j));
+
+  for (i = 0; i < sos_count; i++) {
+    SOSrec *rec = lp->SOS->sos_list[i];
+    int count = rec->size;
+    int head[4];
+    size_t need = SNAPSHOT_ALIGN(sizeof(head)) 
+      + SNAPSHOT_ALIGN(count * sizeof(int)) + count * sizeof(REAL);
+    head[0] = snapshot_add_name(&names, &names_size, &names_alloc, rec->name);
+    head[1] = rec->type;
+    head[2] = rec->priority;
+    head[3] = count;
+    if (sos_size + need > sos_alloc) {
+      sos_alloc = 2 * (sos_size + need);
+      REALLOC_N(sos, char, sos_alloc);
+    }
+    memset(sos + sos_size, 0, need);
+    memcpy(sos + sos_size, head, sizeof(head));
+    sos_size += SNAPSHOT_ALIGN(sizeof(head));
+    memcpy(sos + sos_size, rec->members + 1, count * sizeof(int));
+    sos_size += SNAPSHOT_ALIGN(count * sizeof(int));
+    memcpy(sos + sos_size, rec->weights + 1, count * sizeof(REAL));
+    sos_size += count * sizeof(REAL);
+  }
+  header.names_size = names_size;
+  header.sos_size   = (int) sos_size;
 
-   A negative value means a relative B&B depth limit. The
-   "order" of a MIP problem is defined to be 2x the number of binary
-   variables plus the number of SC and SOS variables. A relative value
-   of -x results in a maximum depth of x times the order of the MIP
-   problem.  The default is -50.  The get_bb_rule function returns the
-   branch-and-bound rule for choosing which non-integer variable is to
-   be selected. This rule can influence solving times
-   considerably. Depending on the model one rule can be best and for
-   another model another rule.  The default is NODE_PSEUDONONINTSELECT
-   + NODE_GREEDYMODE + NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
+  snapshot_get_params(lp, int_params, real_params);
 
-    @param self self
-    @return  Returns the branch-and-bound rule.
-*/
-static VALUE lpsolve_get_bb_depthlimit(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_bb_depthlimit);
+  b_ret = snapshot_put(fp, &header, sizeof(header))
+    && snapshot_put(fp, col_start, (columns + 1) * sizeof(int))
+    && snapshot_put(fp, row_index, nz * sizeof(int))
+    && snapshot_put(fp, value, nz * sizeof(REAL));
 
-/** A wrapper for get_bb_rule().
+  /* Row data */
+  for (i = 0; b_ret && i <= rows; i++) {
+    rows_buf[i] = get_rh(lp, i);
+    rows_buf[rows + 1 + i] = (i > 0) ? get_rh_range(lp, i) : 0;
+  }
+  b_ret = b_ret && snapshot_put(fp, rows_buf, (rows + 1) * sizeof(REAL))
+    && snapshot_put(fp, rows_buf + rows + 1, (rows + 1) * sizeof(REAL));
+  constr_type[0] = FR;
+  for (i = 1; i <= rows; i++) constr_type[i] = get_constr_type(lp, i);
+  b_ret = b_ret && snapshot_put(fp, constr_type, (rows + 1) * sizeof(int));
+
+  /* Column data */
+  for (j = 0; b_ret && j <= columns; j++) {
+    col_buf[j] = (j > 0) ? get_lowbo(lp, j) : 0;
+    col_buf[columns + 1 + j] = (j > 0) ? get_upbo(lp, j) : 0;
+    col_type[j] = 0;
+    if (j > 0 && is_int(lp, j))      col_type[j] |= SNAPSHOT_INT;
+    if (j > 0 && is_semicont(lp, j)) col_type[j] |= SNAPSHOT_SEMICONT;
+  }
+  b_ret = b_ret
+    && snapshot_put(fp, col_buf, (columns + 1) * sizeof(REAL))
+    && snapshot_put(fp, col_buf + columns + 1, (columns + 1) * sizeof(REAL))
+    && snapshot_put(fp, col_type, columns + 1)
+    && snapshot_put(fp, int_params, sizeof(int_params))
+    && snapshot_put(fp, real_params, sizeof(real_params))
+    && snapshot_put(fp, row_ibuf, (rows + 1) * sizeof(int))
+    && snapshot_put(fp, row_ibuf + rows + 1, (columns + 1) * sizeof(int))
+    && snapshot_put(fp, names, names_size)
+    && snapshot_put(fp, sos, sos_size);
+
+  free(col_start);
+  free(row_index);
+  free(value);
+  free(rows_buf);
+  free(constr_type);
+  free(row_ibuf);
+  free(col_buf);
+  free(col_type);
+  free(names);
+  free(sos);
+  return b_ret;
+}
 
-    The get_bb_rule function returns the branch-and-bound rule for
-    choosing which non-integer variable is to be selected. This rule
-    can influence solving times considerably. Depending on the model
-    one rule can be best and for another model another rule.  The
-    default is NODE_PSEUDONONINTSELECT + NODE_GREEDYMODE +
-    NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
+/* A bounds-checked cursor over a snapshot in memory. */
+typedef struct {
+  char *base;
+  size_t size;
+  size_t pos;
+} snapshot_reader_t;
+
+/* Return the next section of count items of item_size bytes, or NULL
+   if the snapshot is too short. */
+static void *
+snapshot_take(snapshot_reader_t *p_r, size_t count, size_t item_size)
+{
+  void *p;
+  size_t bytes;
+  if (item_size > 0 && count > ((size_t) -1) / item_size) return NULL;
+  bytes = count * item_size;
+  if (bytes > p_r->size - p_r->pos) return NULL;
+  p = p_r->base + p_r->pos;
+  p_r->pos = SNAPSHOT_ALIGN(p_r->pos + bytes);
+  if (p_r->pos > p_r->size) p_r->pos = p_r->size;
+  return p;
+}
 
-    @param self self
-    @return  Returns the branch-and-bound rule.
+/* The name at offset in the pool, or NULL if unnamed or out of range. */
+static char *
+snapshot_name(char *names, int names_size, int offset)
+{
+  if (offset < 0 || offset >= names_size) return NULL;
+  return names + offset;
+}
 
-*/
-static VALUE lpsolve_get_bb_rule(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_bb_rule);
+/* Whether offset is -1 (unnamed) or the start of a name in the pool. */
+static MYBOOL
+snapshot_name_ok(int names_size, int offset)
+{
+  return -1 == offset || (offset >= 0 && offset < names_size);
+}
 
-/** A wrapper for get_col_name().
+/* Check the SOS records of the snapshot before anything is built from
+   them: every record must be complete, of a known type, and name
+   existing columns. */
+static MYBOOL
+snapshot_check_sos(snapshot_header_t *h, char *sos, int columns)
+{
+  snapshot_reader_t r;
+  int i, k;
+  r.base = sos;
+  r.size = h->sos_size;
+  r.pos  = 0;
+  for (i = 0; i < h->sos_count; i++) {
+    int *head = snapshot_take(&r, 4, sizeof(int));
+    int *members;
+    if (NULL == head || head[1] < 1 || head[3] < 0 || head[3] > columns
+        || !snapshot_name_ok(h->names_size, head[0]))
+      return FALSE;
+    members = snapshot_take(&r, head[3], sizeof(int));
+    if (NULL == members || NULL == snapshot_take(&r, head[3], sizeof(REAL)))
+      return FALSE;
+    for (k = 0; k < head[3]; k++)
+      if (members[k] < 1 || members[k] > columns) return FALSE;
+  }
+  return TRUE;
+}
 
-    get_col_name() returns the name of the specified column.  The
-    difference between get_col_name and get_origcol_name is only
-    visible when a presolve (set_presolve) was done. Presolve can
-    result in deletion of columns in the model. In get_col_name(),
-    column specifies the column number after presolve was done.
+/** Build an lprec from the snapshot of \a size bytes at \a buf. The
+    buffer must be 8-byte aligned and writable; it is not kept.  This
+    uses no Ruby API.
 
-    @return the string name. A value of \a nil indicates an error. 
+    @return the new lprec, or \a NULL with \a *p_error set to a
+    description of the problem.
 */
-static VALUE 
-lpsolve_get_col_name(VALUE self, VALUE column_num) 
+static lprec *
+snapshot_read(char *buf, size_t size, const char **p_error)
 {
-  char *psz_col_name;
-  INIT_LP;
+  snapshot_reader_t r;
+  snapshot_header_t *h;
+  int *col_start, *row_index, *constr_type, *int_params, *row_name;
+  int *col_name;
+  REAL *value, *rh, *rh_range, *lowbo, *upbo, *real_params;
+  char *col_type, *names, *sos;
+  lprec *lp;
+  int i, j, rows, columns;
+
+  r.base = buf;
+  r.size = size;
+  r.pos  = 0;
+  h = snapshot_take(&r, 1, sizeof(snapshot_header_t));
+  if (NULL == h || 0 != memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(h->magic))) {
+    *p_error = "not an lpsolve snapshot";
+    return NULL;
+  }
+  if (h->version != SNAPSHOT_VERSION) {
+    *p_error = "unsupported snapshot version";
+    return NULL;
+  }
+  if (h->byte_order != SNAPSHOT_ORDER || h->int_size != sizeof(int) 
+      || h->real_size != sizeof(REAL)) {
+    *p_error = "snapshot was written on an incompatible machine";
+    return NULL;
+  }
+  rows    = h->rows;
+  columns = h->columns;
+  *p_error = "snapshot is truncated or corrupt";
+  if (rows < 0 || columns < 0 || h->nz < 0 || h->names_size < 0
+      || h->sos_count < 0 || h->sos_size < 0
+      || h->n_int_params < SNAP_N_INT_PARAMS
+      || h->n_real_params < SNAP_N_REAL_PARAMS)
+    return NULL;
+
+  col_start   = snapshot_take(&r, columns + 1, sizeof(int));
+  row_index   = snapshot_take(&r, h->nz, sizeof(int));
+  value       = snapshot_take(&r, h->nz, sizeof(REAL));
+  rh          = snapshot_take(&r, rows + 1, sizeof(REAL));
+  rh_range    = snapshot_take(&r, rows + 1, sizeof(REAL));
+  constr_type = snapshot_take(&r, rows + 1, sizeof(int));
+  lowbo       = snapshot_take(&r, columns + 1, sizeof(REAL));
+  upbo        = snapshot_take(&r, columns + 1, sizeof(REAL));
+  col_type    = snapshot_take(&r, columns + 1, 1);
+  int_params  = snapshot_take(&r, h->n_int_params, sizeof(int));
+  real_params = snapshot_take(&r, h->n_real_params, sizeof(REAL));
+  row_name    = snapshot_take(&r, rows + 1, sizeof(int));
+  col_name    = snapshot_take(&r, columns + 1, sizeof(int));
+  names       = snapshot_take(&r, h->names_size, 1);
+  sos         = snapshot_take(&r, h->sos_size, 1);
+  if (NULL == col_start || NULL == row_index || NULL == value
+      || NULL == rh || NULL == rh_range || NULL == constr_type
+      || NULL == lowbo || NULL == upbo || NULL == col_type
+      || NULL == int_params || NULL == real_params || NULL == row_name
+      || NULL == col_name || NULL == names || NULL == sos)
+    return NULL;
+  if (h->names_size > 0 && '\0' != names[h->names_size - 1])
+    return NULL;
+  if (0 != col_start[0] || h->nz != col_start[columns])
+    return NULL;
+  for (j = 1; j <= columns; j++)
+    if (col_start[j] < col_start[j-1]) return NULL;
+  for (i = 0; i < h->nz; i++)
+    if (row_index[i] < 0 || row_index[i] > rows) return NULL;
+  for (i = 1; i <= rows; i++)
+    if (constr_type[i] < FR || constr_type[i] > EQ) return NULL;
+  for (j = 1; j <= columns; j++)
+    if (0 != (col_type[j] & ~(SNAPSHOT_INT | SNAPSHOT_SEMICONT))) 
+      return NULL;
+  if (!snapshot_name_ok(h->names_size, h->lp_name)) return NULL;
+  for (i = 0; i <= rows; i++)
+    if (!snapshot_name_ok(h->names_size, row_name[i])) return NULL;
+  for (j = 0; j <= columns; j++)
+    if (!snapshot_name_ok(h->names_size, col_name[j])) return NULL;
+  if (!snapshot_check_sos(h, sos, columns)) return NULL;
+
+  lp = make_lp(rows, 0);
+  if (NULL == lp) {
+    *p_error = "not enough memory";
+    return NULL;
+  }
+  set_infinite(lp, real_params[SNAP_INFINITE]);
+  resize_lp(lp, rows, columns);
+  /* Set row types while the matrix is still empty; that is cheap. */
+  for (i = 1; i <= rows; i++)
+    set_constr_type(lp, i, constr_type[i]);
+  for (j = 1; j <= columns; j++) {
+    int start = col_start[j-1];
+    if (!add_columnex(lp, col_start[j] - start, value + start, 
+                      row_index + start)) {
+      delete_lp(lp);
+      *p_error = "could not add a column";
+      return NULL;
+    }
+  }
+  set_rh_vec(lp, rh);
+  set_rh(lp, 0, rh[0]);
+  for (i = 1; i <= rows; i++) {
+    if (fabs(rh_range[i]) < lp->infinite)
+      set_rh_range(lp, i, rh_range[i]);
+  }
+  for (j = 1; j <= columns; j++) {
+    if (col_type[j] & SNAPSHOT_INT) set_int(lp, j, TRUE);
+    set_bounds(lp, j, lowbo[j], upbo[j]);
+    if (col_type[j] & SNAPSHOT_SEMICONT) set_semicont(lp, j, TRUE);
+  }
+  set_sense(lp, (h->flags & SNAPSHOT_MAXIM) != 0);
 
-  if (TYPE(column_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not an integer.\n", 
-           __FUNCTION__);
-    return Qnil;
+  if (h->lp_name >= 0)
+    set_lp_name(lp, snapshot_name(names, h->names_size, h->lp_name));
+  for (i = 0; i <= rows; i++) {
+    char *name = snapshot_name(names, h->names_size, row_name[i]);
+    if (NULL != name) set_row_name(lp, i, name);
+  }
+  for (j = 0; j <= columns; j++) {
+    char *name = snapshot_name(names, h->names_size, col_name[j]);
+    if (NULL != name) set_col_name(lp, j, name);
   }
 
-  psz_col_name = get_col_name(lp, FIX2INT(column_num));
-  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
-}
+  /* Checked by snapshot_check_sos() above. */
+  r.base = sos;
+  r.size = h->sos_size;
+  r.pos  = 0;
+  for (i = 0; i < h->sos_count; i++) {
+    int *head = snapshot_take(&r, 4, sizeof(int));
+    int *members = snapshot_take(&r, head[3], sizeof(int));
+    REAL *weights = snapshot_take(&r, head[3], sizeof(REAL));
+    if (0 == add_SOS(lp, snapshot_name(names, h->names_size, head[0]), 
+                     head[1], head[2], head[3], members, weights)) {
+      delete_lp(lp);
+      *p_error = "could not add an SOS constraint";
+      return NULL;
+    }
+  }
 
-/** get_col_num(). - Not in API  (yet)
+  snapshot_set_params(lp, int_params, real_params);
 
-    get_col_num() returns the column number for the specified column
-    name.  
+  *p_error = NULL;
+  return lp;
+}
 
-    @return the column number. A value of \a nil indicates an error. 
+/** Map (or failing that, read) the snapshot file \a filename into
+    memory and build an lprec from it. This uses no Ruby API.
+
+    @return the new lprec, or \a NULL with \a *p_error set.
 */
-static VALUE 
-lpsolve_get_col_num(VALUE self, VALUE column_name) 
+static lprec *
+snapshot_load(const char *filename, const char **p_error)
 {
-  INIT_LP;
-  
-  if (TYPE(column_name) != T_STRING) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not a string.\n", 
-           __FUNCTION__);
-    return Qnil;
+  lprec *lp = NULL;
+  struct stat st;
+  char *buf;
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0 || 0 != fstat(fd, &st)) {
+    *p_error = strerror(errno);
+    if (fd >= 0) close(fd);
+    return NULL;
+  }
+#ifdef HAVE_SYS_MMAN_H
+  /* Private and writable: lp_solve gets non-const arrays. Nothing is
+     written back to the file. */
+  buf = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (MAP_FAILED != buf) {
+    lp = snapshot_read(buf, st.st_size, p_error);
+    munmap(buf, st.st_size);
+    close(fd);
+    return lp;
+  }
+#endif
+  /* malloc() memory is suitably aligned for snapshot_read(). */
+  buf = malloc(st.st_size > 0 ? st.st_size : 1);
+  if (NULL == buf) {
+    *p_error = "not enough memory";
+  } else if (read(fd, buf, st.st_size) != st.st_size) {
+    *p_error = "could not read snapshot";
   } else {
-    int retval = get_col_num(lp, RSTRING_PTR(column_name));
-    return (-1 == retval) ? Qnil : INT2FIX(retval);
+    lp = snapshot_read(buf, st.st_size, p_error);
   }
+  free(buf);
+  close(fd);
+  return lp;
 }
 
-/** A wrapper for get_column().
+/** Build an lprec from a snapshot held in the Ruby String \a str. The
+    bytes are copied to an aligned buffer first. This uses no Ruby API
+    other than reading the string.
 
-  Get all column elements from the matrix for a given column number.
+    @return the new lprec, or \a NULL with \a *p_error set.
+*/
+static lprec *
+snapshot_read_string(VALUE str, const char **p_error)
+{
+  lprec *lp;
+  long len = RSTRING_LEN(str);
+  char *buf = malloc(len > 0 ? len : 1);
+  if (NULL == buf) {
+    *p_error = "not enough memory";
+    return NULL;
+  }
+  memcpy(buf, RSTRING_PTR(str), len);
+  lp = snapshot_read(buf, len, p_error);
+  free(buf);
+  return lp;
+}
 
-  @param self self
+/* Solution export, see lpsolve_write_solution(). */
 
-  @param column_num the column number that you want. The value must be
-  between 1 and the number of columns.
+/** Output formats of write_solution(). */
+typedef enum {
+  SOLUTION_CSV,     /**< Comma-separated values with a header line. */
+  SOLUTION_NDJSON,  /**< One JSON object per line. */
+  SOLUTION_BINARY   /**< Header followed by native double arrays. */
+} solution_format_t;
 
-  @return an array of the column values. The size of the array is 
-  the number of rows + 1. \a Nil is returned if there was an error.
+/** Parts of the solution that write_solution() can include. */
+#define SOLUTION_PRIMAL        1  /**< Variable values. */
+#define SOLUTION_REDUCED_COST  2  /**< Variable reduced costs. */
+#define SOLUTION_ACTIVITY      4  /**< Constraint activities. */
+#define SOLUTION_DUAL          8  /**< Constraint duals. */
+#define SOLUTION_SLACK        16  /**< Right-hand side minus activity. */
+
+#define SOLUTION_VARIABLES   (SOLUTION_PRIMAL | SOLUTION_REDUCED_COST)
+#define SOLUTION_CONSTRAINTS (SOLUTION_ACTIVITY | SOLUTION_DUAL | SOLUTION_SLACK)
+
+#define SOLUTION_MAGIC   "LPSOLN\r\n"
+#define SOLUTION_VERSION 1
+
+/** Header of the binary solution format. It is followed by the
+    included arrays as native doubles, in this order: primal values
+    and reduced costs (one per column), activities, duals and slacks
+    (one per row).
 */
-static VALUE
-lpsolve_get_column(VALUE self, VALUE column_num) 
+typedef struct {
+  char magic[8];    /**< SOLUTION_MAGIC */
+  int  version;     /**< SOLUTION_VERSION */
+  int  byte_order;  /**< SNAPSHOT_ORDER as written by this machine */
+  int  include;     /**< SOLUTION_* flags of the arrays present */
+  int  columns;
+  int  rows;
+  int  status;      /**< Return code of the last solve() */
+  double objective;
+} solution_header_t;
+
+/* Print a number so that it reads back exactly; JSON has no infinity
+   or NaN, so those become null there. */
+static void
+solution_put_num(FILE *fp, REAL val, solution_format_t format)
 {
-  unsigned int i_column = FIX2INT(column_num);
-  unsigned int i_rows;
-  REAL *p_column;
-  INIT_LP;
-  
-  i_rows =  get_Nrows(lp); /* Yep, Nrows, not Ncolumns. */
-  p_column = ALLOC_N(REAL, i_rows + 1);
-  
-  if (!get_column(lp, i_column, p_column)) {
-    free(p_column);
-    return Qnil;
+  if (isfinite(val))
+    fprintf(fp, "%.17g", val);
+  else if (SOLUTION_NDJSON == format)
+    fputs("null", fp);
+  else
+    fputs(isnan(val) ? "nan" : (val > 0 ? "inf" : "-inf"), fp);
+}
+
+static void
+solution_put_name(FILE *fp, const char *name, solution_format_t format)
+{
+  const char *p;
+  MYBOOL b_quote = (SOLUTION_NDJSON == format);
+  if (SOLUTION_CSV == format)
+    b_quote = (NULL != strpbrk(name, ",\"\r\n"));
+  if (!b_quote) {
+    fputs(name, fp);
+    return;
+  }
+  putc('"', fp);
+  for (p = name; *p; p++) {
+    unsigned char c = (unsigned char) *p;
+    if ('"' == c)
+      fputs((SOLUTION_CSV == format) ? "\"\"" : "\\\"", fp);
+    else if (SOLUTION_NDJSON == format && '\\' == c)
+      fputs("\\\\", fp);
+    else if (SOLUTION_NDJSON == format && c < 0x20)
+      fprintf(fp, "\\u%04x", c);
+    else
+      putc(c, fp);
+  }
+  putc('"', fp);
+}
+
+/* Write one record of a text format. Fields not in include are left
+   empty (CSV) or omitted (NDJSON). */
+static void
+solution_put_record(FILE *fp, solution_format_t format, int include,
+                    const char *type, int index, const char *name,
+                    REAL value, REAL dual, REAL slack, MYBOOL b_row)
+{
+  int value_flag = b_row ? SOLUTION_ACTIVITY : SOLUTION_PRIMAL;
+  int dual_flag  = b_row ? SOLUTION_DUAL : SOLUTION_REDUCED_COST;
+  if (SOLUTION_CSV == format) {
+    fprintf(fp, "%s,%d,", type, index);
+    solution_put_name(fp, name, format);
+    putc(',', fp);
+    if (include & value_flag) solution_put_num(fp, value, format);
+    putc(',', fp);
+    if (include & dual_flag) solution_put_num(fp, dual, format);
+    putc(',', fp);
+    if (b_row && (include & SOLUTION_SLACK)) 
+      solution_put_num(fp, slack, format);
+    putc('\n', fp);
   } else {
-    VALUE ret_ary = rb_ary_new2(i_rows+1);
-    unsigned int i;
-    for (i=0; i<=i_rows; i++) {
-      rb_ary_push(ret_ary, rb_float_new(p_column[i]));
+    fprintf(fp, "{\"type\":\"%s\",\"index\":%d,\"name\":", type, index);
+    solution_put_name(fp, name, format);
+    if (include & value_flag) {
+      fputs(",\"value\":", fp);
+      solution_put_num(fp, value, format);
     }
-    free(p_column);
-    return ret_ary;
+    if (include & dual_flag) {
+      fputs(b_row ? ",\"dual\":" : ",\"reduced_cost\":", fp);
+      solution_put_num(fp, dual, format);
+    }
+    if (b_row && (include & SOLUTION_SLACK)) {
+      fputs(",\"slack\":", fp);
+      solution_put_num(fp, slack, format);
+    }
+    fputs("}\n", fp);
   }
-  
 }
 
-/** A wrapper for get_infinite().
+static MYBOOL
+solution_put_array(FILE *fp, const REAL *p_values, int n)
+{
+  int i;
+  if (sizeof(REAL) == sizeof(double))
+    return n == (int) fwrite(p_values, sizeof(double), n, fp);
+  for (i = 0; i < n; i++) {
+    double val = (double) p_values[i];
+    if (1 != fwrite(&val, sizeof(val), 1, fp)) return FALSE;
+  }
+  return TRUE;
+}
 
-    @param self self
-    @return Returns the value of "infinite".
+/** Whether the duals and reduced costs of the last solve can be had.
+    lp_solve reports it when they cannot; that is silenced here, as
+    this is only a question. */
+static MYBOOL
+solution_has_duals(lprec *lp)
+{
+  REAL *p_duals;
+  int verbose = get_verbose(lp);
+  MYBOOL b_ret;
+  set_verbose(lp, NEUTRAL);
+  b_ret = get_ptr_sensitivity_rhs(lp, &p_duals, NULL, NULL);
+  set_verbose(lp, verbose);
+  return b_ret;
+}
+
+/** Whether the last solve of \a self left what \a include asks for;
+    if not, report why on behalf of \a psz_fn. Writers check this
+    before opening their output, so that a call that fails does not
+    truncate an existing file.
 */
-static VALUE lpsolve_get_infinite(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_infinite);
+static MYBOOL
+solution_ready(VALUE self, lprec *lp, int include, const char *psz_fn)
+{
+  VALUE status = rb_ivar_get(self, rb_intern("@status"));
+  REAL *p_vec;
+  if (!FIXNUM_P(status) || SOLVE_NOT_CALLED == FIX2INT(status)
+      || !get_ptr_variables(lp, &p_vec)
+      || !get_ptr_constraints(lp, &p_vec)) {
+    report(lp, IMPORTANT, "%s: No solution available.\n", psz_fn);
+    return FALSE;
+  }
+  if ((include & (SOLUTION_DUAL | SOLUTION_REDUCED_COST))
+      && !get_ptr_sensitivity_rhs(lp, &p_vec, NULL, NULL)) {
+    report(lp, IMPORTANT,
+           "%s: No duals; call set_sensitivity(true) before solve.\n",
+           psz_fn);
+    return FALSE;
+  }
+  return TRUE;
+}
 
-/** A wrapper for get_lowbo().
+/** Write the parts of the last solution given by \a include straight
+    from lp_solve's result arrays to \a fp. Duals and reduced costs
+    need sensitivity analysis to have been turned on before solving.
 
-   Returns the upper bound on the variable identified by column.
-   Setting a bound on a variable is the way to go instead of adding an
-   extra constraint (row) to the model. Setting a bound doesn't
-   increase the model size that means that the model stays smaller and
-   will be solved faster.  The default upper bound of a variable is
-   infinity (well not quite. It is a very big number. The value of
-   lpsolve_get_infinite().
+    @return \a TRUE if everything was written.
+*/
+static MYBOOL
+solution_write(lprec *lp, FILE *fp, solution_format_t format, int include,
+               int status)
+{
+  int rows = get_Nrows(lp), columns = get_Ncolumns(lp);
+  int i;
+  REAL *p_variables = NULL, *p_constraints = NULL, *p_duals = NULL;
+  REAL *p_slacks = NULL;
+
+  if (!get_ptr_variables(lp, &p_variables)
+      || !get_ptr_constraints(lp, &p_constraints)) {
+    report(lp, IMPORTANT, "%s: No solution available.\n", __FUNCTION__);
+    return FALSE;
+  }
+  if ((include & (SOLUTION_DUAL | SOLUTION_REDUCED_COST))
+      && !get_ptr_sensitivity_rhs(lp, &p_duals, NULL, NULL)) {
+    report(lp, IMPORTANT,
+           "%s: No duals; call set_sensitivity(true) before solve.\n",
+           __FUNCTION__);
+    return FALSE;
+  }
 
-   @param self self
+  if (SOLUTION_BINARY == format) {
+    solution_header_t header;
+    MYBOOL b_ok;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SOLUTION_MAGIC, sizeof(header.magic));
+    header.version    = SOLUTION_VERSION;
+    header.byte_order = SNAPSHOT_ORDER;
+    header.include    = include;
+    header.columns    = columns;
+    header.rows       = rows;
+    header.status     = status;
+    header.objective  = get_objective(lp);
+    b_ok = (1 == fwrite(&header, sizeof(header), 1, fp));
+    if (b_ok && (include & SOLUTION_PRIMAL))
+      b_ok = solution_put_array(fp, p_variables, columns);
+    if (b_ok && (include & SOLUTION_REDUCED_COST))
+      b_ok = solution_put_array(fp, p_duals + rows, columns);
+    if (b_ok && (include & SOLUTION_ACTIVITY))
+      b_ok = solution_put_array(fp, p_constraints, rows);
+    if (b_ok && (include & SOLUTION_DUAL))
+      b_ok = solution_put_array(fp, p_duals, rows);
+    if (b_ok && (include & SOLUTION_SLACK)) {
+      p_slacks = malloc(sizeof(REAL) * (rows + 1));
+      if (NULL == p_slacks) return FALSE;
+      for (i = 0; i < rows; i++)
+        p_slacks[i] = get_rh(lp, i + 1) - p_constraints[i];
+      b_ok = solution_put_array(fp, p_slacks, rows);
+      free(p_slacks);
+    }
+    return b_ok && !ferror(fp);
+  }
 
-   @param column_num the column number of the variable. It must be
-   between 1 and the number of columns in the lp.
+  if (SOLUTION_CSV == format)
+    fputs("type,index,name,value,dual,slack\n", fp);
+  if (include & SOLUTION_VARIABLES)
+    for (i = 1; i <= columns; i++)
+      solution_put_record(fp, format, include, "var", i, get_col_name(lp, i),
+                          p_variables[i - 1], 
+                          p_duals ? p_duals[rows + i - 1] : 0.0, 0.0, FALSE);
+  if (include & SOLUTION_CONSTRAINTS)
+    for (i = 1; i <= rows; i++)
+      solution_put_record(fp, format, include, "row", i, get_row_name(lp, i),
+                          p_constraints[i - 1],
+                          p_duals ? p_duals[i - 1] : 0.0, 
+                          get_rh(lp, i) - p_constraints[i - 1], TRUE);
+  return !ferror(fp);
+}
+
+/* Apache Arrow IPC file export, see lpsolve_write_arrow().
 
+   An Arrow file is "ARROW1\0\0", a stream of messages (the schema,
+   then record batches), an end-of-stream marker, a footer locating
+   the batches, the footer length and "ARROW1". Each message is a
+   0xFFFFFFFF marker, the length of its metadata, the metadata as a
+   FlatBuffer and a body holding the column buffers. The small
+   FlatBuffer encoder below lays objects out front to back, so that
+   every offset points forward as the format requires. Everything is
+   little-endian.
 */
 
-static VALUE lpsolve_get_lowbo(VALUE self, VALUE column_num);
-LPSOLVE_1_IN_NUM_OUT(get_lowbo, T_FIXNUM, "an integer", FIX2INT);
+/** A FlatBuffer under construction. */
+typedef struct {
+  unsigned char *buf;
+  size_t len;
+  size_t cap;
+  MYBOOL failed;   /**< Set if we ran out of memory. */
+} fb_t;
+
+/** A table field for fb_table(). */
+typedef struct {
+  int size;          /**< 0 if absent, else 1, 2, 4 or 8 bytes. */
+  MYBOOL b_offset;   /**< An offset, set later with fb_patch(). */
+  uint64_t value;    /**< Value of a scalar field. */
+  size_t slot;       /**< Set to the position of the field. */
+} fb_field_t;
+
+#define FB_MAX_FIELDS 8
+
+/* Append n bytes, zero-filled unless p is given, and return their
+   position. */
+static size_t
+fb_put(fb_t *p_fb, const void *p, size_t n)
+{
+  size_t pos = p_fb->len;
+  if (p_fb->failed) return 0;
+  if (pos + n > p_fb->cap) {
+    size_t cap = (p_fb->cap > 0) ? p_fb->cap : 1024;
+    unsigned char *buf;
+    while (cap < pos + n) cap *= 2;
+    buf = realloc(p_fb->buf, cap);
+    if (NULL == buf) {
+      p_fb->failed = TRUE;
+      return 0;
+    }
+    p_fb->buf = buf;
+    p_fb->cap = cap;
+  }
+  if (NULL != p) memcpy(p_fb->buf + pos, p, n);
+  else           memset(p_fb->buf + pos, 0, n);
+  p_fb->len += n;
+  return pos;
+}
 
-/** A wrapper for get_lp_name().
+/* Pad with zeros until the length is rem modulo align. */
+static void
+fb_pad(fb_t *p_fb, size_t align, size_t rem)
+{
+  while (!p_fb->failed && p_fb->len % align != rem)
+    fb_put(p_fb, NULL, 1);
+}
 
-    @return the name of the lp. The doc says the default name is
-    "Unnamed", but in fact we seem to return "".
-*/
-static VALUE
-lpsolve_get_lp_name(VALUE self) 
+/* Point the offset field at slot to target. */
+static void
+fb_patch(fb_t *p_fb, size_t slot, size_t target)
 {
-  char *psz_lp_name;
-  INIT_LP;
-  psz_lp_name = get_lp_name(lp);
-  return psz_lp_name ? rb_str_new2(psz_lp_name) : rb_str_new2("Unnamed");
+  uint32_t offset = (uint32_t) (target - slot);
+  if (!p_fb->failed) memcpy(p_fb->buf + slot, &offset, sizeof(offset));
 }
 
-/** 
-    A wrapper for get_Ncolumns().
+/* Write a table with its vtable just in front of it. Fields are laid
+   out largest first after the 4-byte vtable offset, and the table
+   starts at 4 modulo 8, so every field is aligned.
 
-    Return the number of columns (variables) in the lp object. Note
-    that the number of columns can change when a presolve is done or
-    when negative variables are split in a positive and a negative
-    part.  Therefore it is advisable to use this function to determine
-    how many columns there are in the lp instead of relying one's own
-    count.
+   @return the position of the table. */
+static size_t
+fb_table(fb_t *p_fb, fb_field_t *fields, int n)
+{
+  uint16_t vtable[2 + FB_MAX_FIELDS];
+  size_t vtable_size = (2 + n) * sizeof(uint16_t), table;
+  int32_t vtable_offset = (int32_t) vtable_size;
+  uint16_t obj_size = sizeof(int32_t);
+  int i, size;
+
+  for (i = 0; i < n; i++) vtable[2 + i] = 0;
+  for (size = 8; size >= 1; size /= 2)
+    for (i = 0; i < n; i++)
+      if (fields[i].size == size) {
+        vtable[2 + i] = obj_size;
+        obj_size += size;
+      }
+  vtable[0] = (uint16_t) vtable_size;
+  vtable[1] = obj_size;
+
+  while (!p_fb->failed && (p_fb->len + vtable_size) % 8 != 4)
+    fb_put(p_fb, NULL, 1);
+  fb_put(p_fb, vtable, vtable_size);
+  table = fb_put(p_fb, &vtable_offset, sizeof(vtable_offset));
+  fb_put(p_fb, NULL, obj_size - sizeof(int32_t));
+  for (i = 0; i < n; i++) {
+    if (0 == fields[i].size) continue;
+    fields[i].slot = table + vtable[2 + i];
+    if (!fields[i].b_offset && !p_fb->failed)
+      memcpy(p_fb->buf + fields[i].slot, &fields[i].value, fields[i].size);
+  }
+  return table;
+}
 
-    @param self self
-    @return the number of columns (variables) in the lp.
-*/
-static VALUE lpsolve_get_Ncolumns(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_Ncolumns)
+/* Write a vector of n elements of elem_size bytes (zeros if data is
+   NULL), with the elements aligned to align. For a vector of offsets
+   the element slots start 4 bytes after the returned position.
 
-/** A wrapper for get_nonzeros().
+   @return the position of the vector. */
+static size_t
+fb_vector(fb_t *p_fb, size_t n, size_t elem_size, size_t align,
+          const void *data)
+{
+  uint32_t length = (uint32_t) n;
+  size_t vector;
+  fb_pad(p_fb, (align > 4) ? align : 4, (align > 4) ? align - 4 : 0);
+  vector = fb_put(p_fb, &length, sizeof(length));
+  fb_put(p_fb, data, n * elem_size);
+  return vector;
+}
 
-    Return the number of non-zero elements in matrix of the the lp object.
+static size_t
+fb_string(fb_t *p_fb, const char *psz)
+{
+  size_t vector = fb_vector(p_fb, strlen(psz), 1, 1, psz);
+  fb_put(p_fb, NULL, 1);
+  return vector;
+}
 
-    @param self self
-    @return the number of non-zero elements in the matrix of the lp.
-*/
-static VALUE lpsolve_get_nonzeros(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_nonzeros)
+/* Set the next field of a table being described. */
+#define FB_SCALAR(f, sz, v) ((f).size = (sz), (f).b_offset = FALSE, (f).value = (v))
+#define FB_OFFSET(f)        ((f).size = 4, (f).b_offset = TRUE, (f).value = 0)
+
+#define ARROW_MAGIC            "ARROW1"
+#define ARROW_METADATA_V5      4
+#define ARROW_HEADER_SCHEMA    1
+#define ARROW_HEADER_BATCH     3
+#define ARROW_TYPE_INT         2
+#define ARROW_TYPE_FLOAT       3
+#define ARROW_TYPE_UTF8        5
+#define ARROW_PRECISION_DOUBLE 2
+
+/** Column types of the exported tables. */
+typedef enum {
+  ARROW_INDEX,   /**< int32 row or column number, 1-based */
+  ARROW_NAME,    /**< utf8 row or column name */
+  ARROW_DOUBLE   /**< float64 values, or all null */
+} arrow_type_t;
+
+/** A column of an exported table. */
+typedef struct {
+  const char *name;
+  arrow_type_t type;
+  const REAL *values;   /**< ARROW_DOUBLE values; NULL if all null. */
+  MYBOOL nullable;
+} arrow_column_t;
+
+/** Block of the Arrow footer locating a record batch. */
+typedef struct {
+  int64_t offset;
+  int32_t metadata_length;
+  int32_t padding;
+  int64_t body_length;
+} arrow_block_t;
+
+/* Write a Schema table for the columns. */
+static size_t
+arrow_schema(fb_t *p_fb, const arrow_column_t *cols, int n)
+{
+  fb_field_t schema_fields[2];
+  size_t schema, fields;
+  int i;
+
+  memset(schema_fields, 0, sizeof(schema_fields));
+  FB_OFFSET(schema_fields[1]);                    /* fields */
+  schema = fb_table(p_fb, schema_fields, 2);
+  fields = fb_vector(p_fb, n, 4, 4, NULL);
+  fb_patch(p_fb, schema_fields[1].slot, fields);
+
+  for (i = 0; i < n; i++) {
+    fb_field_t field[6], type[2];
+    size_t table;
+    int n_type = 0, type_id = ARROW_TYPE_UTF8;
+
+    memset(field, 0, sizeof(field));
+    memset(type, 0, sizeof(type));
+    if (ARROW_INDEX == cols[i].type) {
+      type_id = ARROW_TYPE_INT;
+      FB_SCALAR(type[0], 4, 32);                  /* bitWidth */
+      FB_SCALAR(type[1], 1, 1);                   /* is_signed */
+      n_type = 2;
+    } else if (ARROW_DOUBLE == cols[i].type) {
+      type_id = ARROW_TYPE_FLOAT;
+      FB_SCALAR(type[0], 2, ARROW_PRECISION_DOUBLE);
+      n_type = 1;
+    }
+    FB_OFFSET(field[0]);                          /* name */
+    FB_SCALAR(field[1], 1, cols[i].nullable);     /* nullable */
+    FB_SCALAR(field[2], 1, type_id);              /* type_type */
+    FB_OFFSET(field[3]);                          /* type */
+    FB_OFFSET(field[5]);                          /* children */
+    table = fb_table(p_fb, field, 6);
+    fb_patch(p_fb, fields + 4 + 4 * i, table);
+    fb_patch(p_fb, field[0].slot, fb_string(p_fb, cols[i].name));
+    fb_patch(p_fb, field[3].slot, fb_table(p_fb, type, n_type));
+    fb_patch(p_fb, field[5].slot, fb_vector(p_fb, 0, 4, 4, NULL));
+  }
+  return schema;
+}
 
-/** 
-    A wrapper for get_Norig_columns().
+/* Start a Message; the header table is to be patched into *p_slot. */
+static void
+arrow_message(fb_t *p_fb, int header_type, int64_t body_length, 
+              size_t *p_slot)
+{
+  fb_field_t message[4];
+  memset(message, 0, sizeof(message));
+  p_fb->len = 0;
+  fb_put(p_fb, NULL, 4);                          /* root offset */
+  FB_SCALAR(message[0], 2, ARROW_METADATA_V5);    /* version */
+  FB_SCALAR(message[1], 1, header_type);          /* header_type */
+  FB_OFFSET(message[2]);                          /* header */
+  FB_SCALAR(message[3], 8, body_length);          /* bodyLength */
+  fb_patch(p_fb, 0, fb_table(p_fb, message, 4));
+  *p_slot = message[2].slot;
+}
 
-    Return the number of original columns (variables) in the lp
-    object. Note that the number of row does not change, but the
-    number of original columns does not.
+/* Write bytes to fp, counting them. */
+static MYBOOL
+arrow_put(FILE *fp, const void *p, size_t n, int64_t *p_written)
+{
+  static const char zeros[8] = {0};
+  if (NULL == p && n <= sizeof(zeros)) p = zeros;
+  *p_written += n;
+  return n == fwrite(p, 1, n, fp);
+}
 
-    @param self self
-    @return the number of columns (variables) in the lp.
-*/
-static VALUE lpsolve_get_Norig_columns(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_Norig_columns)
+static MYBOOL
+arrow_pad(FILE *fp, int64_t *p_written)
+{
+  size_t n = (8 - *p_written % 8) % 8;
+  return arrow_put(fp, NULL, n, p_written);
+}
 
-/** A wrapper for get_Norig_rows().
+/* Write the FlatBuffer in p_fb as an encapsulated message and return
+   the length of its metadata, prefix included, or -1 on error. */
+static int32_t
+arrow_put_message(FILE *fp, fb_t *p_fb, int64_t *p_written)
+{
+  int32_t prefix[2];
+  fb_pad(p_fb, 8, 0);
+  if (p_fb->failed) return -1;
+  prefix[0] = -1;
+  prefix[1] = (int32_t) p_fb->len;
+  if (!arrow_put(fp, prefix, sizeof(prefix), p_written)
+      || !arrow_put(fp, p_fb->buf, p_fb->len, p_written))
+    return -1;
+  return (int32_t) (sizeof(prefix) + p_fb->len);
+}
 
-    Return the number of original rows (constraints) in the lp
-    object. Note that the number of row does not change, but the
-    number of original rows does not.
+#define ARROW_PAD8(n) (((n) + 7) & ~((int64_t) 7))
 
-    @param self self
-    @return the number of original rows (constraints) in the lp.
-*/
-static VALUE lpsolve_get_Norig_rows(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_Norig_rows)
+/* Write rows [start, start + n) of the columns as one record batch. */
+static MYBOOL
+arrow_put_batch(lprec *lp, FILE *fp, fb_t *p_fb, const arrow_column_t *cols,
+                int n_cols, MYBOOL b_row, int start, int n, 
+                int64_t *p_written, arrow_block_t *p_block)
+{
+  int64_t nodes[2 * FB_MAX_FIELDS], buffers[2 * 3 * FB_MAX_FIELDS];
+  int64_t body_length = 0;
+  int n_buffers = 0, c, k;
+  fb_field_t batch[3];
+  size_t slot, table;
+  MYBOOL b_ok = TRUE;
+
+  /* Buffer layout: validity bitmap and values, plus offsets before
+     the values of strings. */
+  for (c = 0; c < n_cols; c++) {
+    int64_t validity = 0, offsets = 0, values;
+    if (ARROW_INDEX == cols[c].type) {
+      values = (int64_t) n * sizeof(int32_t);
+    } else if (ARROW_DOUBLE == cols[c].type) {
+      values = (int64_t) n * sizeof(double);
+      if (NULL == cols[c].values) validity = (n + 7) / 8;
+    } else {
+      offsets = (int64_t) (n + 1) * sizeof(int32_t);
+      values = 0;
+      for (k = 0; k < n; k++)
+        values += strlen(b_row ? get_row_name(lp, start + k + 1) 
+                               : get_col_name(lp, start + k + 1));
+      if (values > INT32_MAX) return FALSE;
+    }
+    nodes[2 * c]     = n;
+    nodes[2 * c + 1] = validity ? n : 0;
+    buffers[2 * n_buffers]     = body_length;
+    buffers[2 * n_buffers + 1] = validity;
+    body_length += ARROW_PAD8(validity);
+    n_buffers++;
+    if (ARROW_NAME == cols[c].type) {
+      buffers[2 * n_buffers]     = body_length;
+      buffers[2 * n_buffers + 1] = offsets;
+      body_length += ARROW_PAD8(offsets);
+      n_buffers++;
+    }
+    buffers[2 * n_buffers]     = body_length;
+    buffers[2 * n_buffers + 1] = values;
+    body_length += ARROW_PAD8(values);
+    n_buffers++;
+  }
 
-/** A wrapper for get_Nrows().
+  arrow_message(p_fb, ARROW_HEADER_BATCH, body_length, &slot);
+  memset(batch, 0, sizeof(batch));
+  FB_SCALAR(batch[0], 8, n);                      /* length */
+  FB_OFFSET(batch[1]);                            /* nodes */
+  FB_OFFSET(batch[2]);                            /* buffers */
+  table = fb_table(p_fb, batch, 3);
+  fb_patch(p_fb, slot, table);
+  fb_patch(p_fb, batch[1].slot, fb_vector(p_fb, n_cols, 16, 8, nodes));
+  fb_patch(p_fb, batch[2].slot, fb_vector(p_fb, n_buffers, 16, 8, buffers));
+
+  p_block->offset          = *p_written;
+  p_block->padding         = 0;
+  p_block->body_length     = body_length;
+  p_block->metadata_length = arrow_put_message(fp, p_fb, p_written);
+  if (p_block->metadata_length < 0) return FALSE;
+
+  /* The body, column by column, in the layout above. */
+  for (c = 0; b_ok && c < n_cols; c++) {
+    if (ARROW_INDEX == cols[c].type) {
+      for (k = 0; b_ok && k < n; k++) {
+        int32_t index = start + k + 1;
+        b_ok = arrow_put(fp, &index, sizeof(index), p_written);
+      }
+    } else if (ARROW_NAME == cols[c].type) {
+      int32_t offset = 0;
+      b_ok = arrow_put(fp, &offset, sizeof(offset), p_written);
+      for (k = 0; b_ok && k < n; k++) {
+        offset += strlen(b_row ? get_row_name(lp, start + k + 1) 
+                               : get_col_name(lp, start + k + 1));
+        b_ok = arrow_put(fp, &offset, sizeof(offset), p_written);
+      }
+      b_ok = b_ok && arrow_pad(fp, p_written);
+      for (k = 0; b_ok && k < n; k++) {
+        const char *name = b_row ? get_row_name(lp, start + k + 1) 
+                                 : get_col_name(lp, start + k + 1);
+        b_ok = arrow_put(fp, name, strlen(name), p_written);
+      }
+    } else if (NULL == cols[c].values) {
+      /* All null: a zero validity bitmap and zero values. */
+      int64_t size = ARROW_PAD8((n + 7) / 8) + (int64_t) n * sizeof(double);
+      for (; b_ok && size > 0; size -= 8)
+        b_ok = arrow_put(fp, NULL, 8, p_written);
+    } else if (sizeof(REAL) == sizeof(double)) {
+      b_ok = arrow_put(fp, cols[c].values + start, n * sizeof(double), 
+                       p_written);
+    } else {
+      for (k = 0; b_ok && k < n; k++) {
+        double val = (double) cols[c].values[start + k];
+        b_ok = arrow_put(fp, &val, sizeof(val), p_written);
+      }
+    }
+    b_ok = b_ok && arrow_pad(fp, p_written);
+  }
+  return b_ok;
+}
 
-    Return the number of rows (variables) in the lp object. Note that
-    the number of columns can change when a presolve is done or when
-    negative variables are split in a positive and a negative part.
-    Therefore it is advisable to use this function to determine how
-    many columns there are in the lp instead of relying one's own
-    count.
+/** Write the columns as an Arrow IPC file with record batches of at
+    most \a batch_size rows. Rows of the table are the model's rows if
+    \a b_row is set, else its columns.
 
-    @param self self
-    @return the number of rows (constraints) in the lp.
+    @return \a TRUE if everything was written.
 */
-static VALUE lpsolve_get_Nrows(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_Nrows)
+static MYBOOL
+arrow_write(lprec *lp, FILE *fp, const arrow_column_t *cols, int n_cols,
+            MYBOOL b_row, int batch_size)
+{
+  int n = b_row ? get_Nrows(lp) : get_Ncolumns(lp);
+  int n_batches = (n + batch_size - 1) / batch_size, b;
+  arrow_block_t *blocks = malloc((n_batches + 1) * sizeof(arrow_block_t));
+  int64_t written = 0;
+  int32_t footer_length, eos[2] = {-1, 0};
+  fb_t fb;
+  fb_field_t footer[4];
+  size_t slot;
+  MYBOOL b_ok = (NULL != blocks);
+
+  memset(&fb, 0, sizeof(fb));
+  b_ok = b_ok && arrow_put(fp, ARROW_MAGIC, 6, &written) 
+    && arrow_put(fp, NULL, 2, &written);
+
+  arrow_message(&fb, ARROW_HEADER_SCHEMA, 0, &slot);
+  fb_patch(&fb, slot, arrow_schema(&fb, cols, n_cols));
+  b_ok = b_ok && arrow_put_message(fp, &fb, &written) >= 0;
+
+  for (b = 0; b_ok && b < n_batches; b++) {
+    int start = b * batch_size;
+    b_ok = arrow_put_batch(lp, fp, &fb, cols, n_cols, b_row, start,
+                           (n - start < batch_size) ? n - start : batch_size,
+                           &written, &blocks[b]);
+  }
+  b_ok = b_ok && arrow_put(fp, eos, sizeof(eos), &written);
+
+  /* The footer is a bare FlatBuffer with its own copy of the schema. */
+  memset(footer, 0, sizeof(footer));
+  fb.len = 0;
+  fb_put(&fb, NULL, 4);
+  FB_SCALAR(footer[0], 2, ARROW_METADATA_V5);     /* version */
+  FB_OFFSET(footer[1]);                           /* schema */
+  FB_OFFSET(footer[2]);                           /* dictionaries */
+  FB_OFFSET(footer[3]);                           /* recordBatches */
+  fb_patch(&fb, 0, fb_table(&fb, footer, 4));
+  fb_patch(&fb, footer[1].slot, arrow_schema(&fb, cols, n_cols));
+  fb_patch(&fb, footer[2].slot, fb_vector(&fb, 0, 24, 8, NULL));
+  fb_patch(&fb, footer[3].slot, 
+           fb_vector(&fb, n_batches, sizeof(arrow_block_t), 8, blocks));
+  fb_pad(&fb, 8, 0);
+  footer_length = (int32_t) fb.len;
+  b_ok = b_ok && !fb.failed 
+    && arrow_put(fp, fb.buf, fb.len, &written)
+    && arrow_put(fp, &footer_length, sizeof(footer_length), &written)
+    && arrow_put(fp, ARROW_MAGIC, 6, &written);
+
+  free(fb.buf);
+  free(blocks);
+  return b_ok && !ferror(fp);
+}
 
-/** A wrapper for get_mat().
+/* Sparse matrix import, see lpsolve_from_matrix_market() and
+   lpsolve_from_triplets_csv(). */
+
+/** Coordinate-format (row, column, value) entries of a constraint
+    matrix, 1-based, in file order. */
+typedef struct {
+  int  *row;
+  int  *col;
+  REAL *value;
+  long  n;         /**< Number of entries. */
+  long  cap;       /**< Allocated entries. */
+  int   rows;      /**< Declared number of rows, or the largest seen. */
+  int   columns;   /**< Declared number of columns, or the largest seen. */
+} triplets_t;
 
-  Get a single element from the matrix.
+static void
+triplets_free(triplets_t *p_t)
+{
+  free(p_t->row);
+  free(p_t->col);
+  free(p_t->value);
+  memset(p_t, 0, sizeof(*p_t));
+}
 
-  @param self self
-  @param row_num row number
-  @param col_num column number
+static MYBOOL
+triplets_push(triplets_t *p_t, int row, int col, REAL value)
+{
+  if (p_t->n == p_t->cap) {
+    long cap = (p_t->cap > 0) ? 2 * p_t->cap : 1024;
+    int  *p_row   = realloc(p_t->row, cap * sizeof(int));
+    int  *p_col   = (NULL != p_row) ? realloc(p_t->col, cap * sizeof(int)) : NULL;
+    REAL *p_value = (NULL != p_col) ? realloc(p_t->value, cap * sizeof(REAL)) : NULL;
+    if (NULL != p_row) p_t->row = p_row;
+    if (NULL != p_col) p_t->col = p_col;
+    if (NULL == p_value) return FALSE;
+    p_t->value = p_value;
+    p_t->cap   = cap;
+  }
+  p_t->row[p_t->n]   = row;
+  p_t->col[p_t->n]   = col;
+  p_t->value[p_t->n] = value;
+  p_t->n++;
+  return TRUE;
+}
 
-  @return the value of the element on row \a row, column \a column. If no
-  value was set for this element, the function returns 0.  Note that
-  row entry mode must be off, else this function also fails. @see
-  lpsolve_set_add_rowmode().
+/* Return the next line of fp that is neither blank nor a comment
+   starting with one of the characters in comments, or NULL at end of
+   file. */
+static char *
+triplets_next_line(FILE *fp, char **p_line, size_t *p_cap, long *p_lineno,
+                   const char *comments)
+{
+  while (getline(p_line, p_cap, fp) >= 0) {
+    char *p = *p_line;
+    (*p_lineno)++;
+    while (' ' == *p || '\t' == *p) p++;
+    if ('\0' == *p || '\n' == *p || '\r' == *p || strchr(comments, *p))
+      continue;
+    return p;
+  }
+  return NULL;
+}
+
+/** Read a Matrix Market coordinate file ("%%MatrixMarket matrix
+    coordinate real|integer|pattern general|symmetric|skew-symmetric").
+    Pattern entries have the value 1; the mirror image of each
+    off-diagonal entry of a symmetric matrix is added.
 
+    @return \a NULL on success, or a message describing the error.
 */
-static VALUE
-lpsolve_get_mat(VALUE self, VALUE row_num, VALUE col_num) 
+static const char *
+mm_read(FILE *fp, triplets_t *p_t)
 {
-  INIT_LP;
-  if (TYPE(row_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
-    return Qnil;
+  static char sz_error[100];
+  char object[32], format[32], field[32], symmetry[32];
+  char *line = NULL, *p;
+  size_t cap = 0;
+  long lineno = 0, nnz = 0, count = 0;
+  MYBOOL b_pattern, b_symmetric, b_skew;
+  const char *psz_error = NULL;
+
+  if (getline(&line, &cap, fp) < 0 
+      || 4 != sscanf(line, "%%%%MatrixMarket %31s %31s %31s %31s", 
+                     object, format, field, symmetry)) {
+    free(line);
+    return "missing %%MatrixMarket header";
   }
-  if (TYPE(col_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 2, is not a number.\n", __FUNCTION__);
-    return Qnil;
+  lineno = 1;
+  b_pattern   = (0 == strcasecmp(field, "pattern"));
+  b_skew      = (0 == strcasecmp(symmetry, "skew-symmetric"));
+  b_symmetric = b_skew || (0 == strcasecmp(symmetry, "symmetric"));
+  if (0 != strcasecmp(object, "matrix") 
+      || 0 != strcasecmp(format, "coordinate")) {
+    psz_error = "only coordinate matrices are supported";
+  } else if (!b_pattern && 0 != strcasecmp(field, "real")
+             && 0 != strcasecmp(field, "integer")) {
+    psz_error = "only real, integer and pattern fields are supported";
+  } else if (!b_symmetric && 0 != strcasecmp(symmetry, "general")) {
+    psz_error = "only general and symmetric matrices are supported";
+  } else if (NULL == (p = triplets_next_line(fp, &line, &cap, &lineno, "%"))
+             || 3 != sscanf(p, "%d %d %ld", &p_t->rows, &p_t->columns, &nnz)
+             || p_t->rows < 0 || p_t->columns < 0 || nnz < 0) {
+    psz_error = "missing or bad size line";
   }
-  return rb_float_new(get_mat(lp, FIX2INT(row_num), FIX2INT(col_num)));
+
+  while (NULL == psz_error 
+         && NULL != (p = triplets_next_line(fp, &line, &cap, &lineno, "%"))) {
+    char *end;
+    long row = strtol(p, &end, 10), col = strtol(end, &end, 10);
+    REAL value = 1.0;
+    if (!b_pattern) {
+      p = end;
+      value = strtod(p, &end);
+      if (end == p) row = 0;
+    }
+    if (++count > nnz) {
+      snprintf(sz_error, sizeof(sz_error), 
+               "more than the %ld entries declared, on line %ld", nnz, lineno);
+      psz_error = sz_error;
+    } else if (row < 1 || row > p_t->rows || col < 1 || col > p_t->columns) {
+      snprintf(sz_error, sizeof(sz_error), "bad entry on line %ld", lineno);
+      psz_error = sz_error;
+    } else if (!triplets_push(p_t, (int) row, (int) col, value)
+               || (b_symmetric && row != col 
+                   && !triplets_push(p_t, (int) col, (int) row, 
+                                     b_skew ? -value : value))) {
+      psz_error = "not enough memory";
+    }
+  }
+  if (NULL == psz_error && count < nnz) {
+    snprintf(sz_error, sizeof(sz_error), 
+             "%ld entries declared but only %ld found", nnz, count);
+    psz_error = sz_error;
+  }
+  free(line);
+  return psz_error;
 }
 
-/** A wrapper for get_mip_gap().
+/** Read "row,column,value" lines. Fields may also be separated by
+    semicolons, tabs or spaces; blank lines and lines starting with '#'
+    are skipped, and so is a first line that does not start with a
+    number (a header). Indices start at \a base, which must not be
+    negative.
 
-   Sets the MIP gap that specifies a tolerance for the branch and bound
-   algorithm. This tolerance is the difference between the best-found
-   solution yet and the current solution. If the difference is smaller
-   than this tolerance then the solution (and all the sub-solutions) is
-   rejected. This can result in faster solving times, but results in a
-   solution which is not the perfect solution. So be careful with this
-   tolerance.  The default mip_gap value is 1e-9
+    @return \a NULL on success, or a message describing the error.
+*/
+static const char *
+csv_read(FILE *fp, triplets_t *p_t, int base)
+{
+  static char sz_error[100];
+  char *line = NULL, *p;
+  size_t cap = 0;
+  long lineno = 0;
+  MYBOOL b_first = TRUE;
+  const char *psz_error = NULL;
+
+  while (NULL == psz_error 
+         && NULL != (p = triplets_next_line(fp, &line, &cap, &lineno, "#"))) {
+    char *end;
+    long row, col;
+    REAL value;
+    MYBOOL b_bad = FALSE;
+    row = strtol(p, &end, 10);
+    if (end == p) {
+      if (b_first) {
+        b_first = FALSE;
+        continue;
+      }
+      b_bad = TRUE;
+    }
+    b_first = FALSE;
+    p = end + strspn(end, " \t,;");
+    col = strtol(p, &end, 10);
+    if (end == p) b_bad = TRUE;
+    p = end + strspn(end, " \t,;");
+    value = strtod(p, &end);
+    if (end == p) b_bad = TRUE;
+    /* base >= 0, so these differences cannot overflow. */
+    if (b_bad || row < base || col < base 
+        || row - base >= INT_MAX || col - base >= INT_MAX) {
+      snprintf(sz_error, sizeof(sz_error), "bad entry on line %ld", lineno);
+      psz_error = sz_error;
+    } else if (!triplets_push(p_t, (int) (row - base + 1), 
+                              (int) (col - base + 1), value)) {
+      psz_error = "not enough memory";
+    } else {
+      if (row - base + 1 > p_t->rows)    p_t->rows    = (int) (row - base + 1);
+      if (col - base + 1 > p_t->columns) p_t->columns = (int) (col - base + 1);
+    }
+  }
+  free(line);
+  return psz_error;
+}
 
+/** Build a model from the entries in \a p_t: the entries are bucketed
+    by row and then, stably, by column, so each column comes out with
+    its rows in order; duplicate entries are summed and zeros dropped.
+    \a obj, if not \a NULL, holds the objective, 1-based.
 
-   @param self self
-   @param abs_rel: set to true if the gap is absolute, or false for relative.
-   @param val: gap value. The default mip_gap is 1e-9.
-   @return \a gap value or nil if there was an error.
+    @return the new lprec or \a NULL if out of memory.
 */
-static VALUE
-lpsolve_get_mip_gap(VALUE self, VALUE abs_rel) 
+static lprec *
+triplets_to_lp(triplets_t *p_t, const REAL *obj)
 {
-  INIT_LP;
-  if (abs_rel != Qtrue && abs_rel != Qfalse && abs_rel != Qnil) {
-    report(lp, IMPORTANT,
-           "%s: Parameter is not a boolean or nil.\n",
-           __FUNCTION__);
-    return Qnil;
-  } else {
-    return rb_float_new(get_mip_gap(lp, Qtrue == abs_rel));
+  int rows = p_t->rows, columns = p_t->columns;
+  long n = p_t->n, k, max_count = 0;
+  long *row_start = calloc(rows + 2, sizeof(long));
+  long *col_start = calloc(columns + 2, sizeof(long));
+  long *by_row    = malloc((n + 1) * sizeof(long));
+  long *by_col    = malloc((n + 1) * sizeof(long));
+  int  *rowno     = NULL;
+  REAL *column    = NULL;
+  lprec *lp = NULL;
+  int i, j;
+
+  if (NULL == row_start || NULL == col_start || NULL == by_row 
+      || NULL == by_col)
+    goto done;
+
+  for (k = 0; k < n; k++) {
+    row_start[p_t->row[k] + 1]++;
+    col_start[p_t->col[k] + 1]++;
+  }
+  for (i = 1; i <= rows + 1; i++) row_start[i] += row_start[i - 1];
+  for (j = 1; j <= columns + 1; j++) {
+    if (col_start[j] > max_count) max_count = col_start[j];
+    col_start[j] += col_start[j - 1];
+  }
+  for (k = 0; k < n; k++) by_row[row_start[p_t->row[k]]++] = k;
+  for (k = 0; k < n; k++) {
+    long e = by_row[k];
+    by_col[col_start[p_t->col[e]]++] = e;
+  }
+  /* col_start[j] is now the end of column j. */
+
+  rowno  = malloc((max_count + 1) * sizeof(int));
+  column = malloc((max_count + 1) * sizeof(REAL));
+  if (NULL == rowno || NULL == column) goto done;
+
+  lp = make_lp(rows, 0);
+  if (NULL == lp) goto done;
+  resize_lp(lp, rows, columns);
+  for (j = 1; j <= columns; j++) {
+    int count = 0;
+    if (NULL != obj && 0.0 != obj[j]) {
+      rowno[0]  = 0;
+      column[0] = obj[j];
+      count = 1;
+    }
+    for (k = col_start[j - 1]; k < col_start[j]; k++) {
+      long e = by_col[k];
+      if (count > 0 && rowno[count - 1] == p_t->row[e]) {
+        column[count - 1] += p_t->value[e];
+      } else {
+        rowno[count]  = p_t->row[e];
+        column[count] = p_t->value[e];
+        count++;
+      }
+      if (0.0 == column[count - 1] && rowno[count - 1] > 0) count--;
+    }
+    if (!add_columnex(lp, count, column, rowno)) {
+      delete_lp(lp);
+      lp = NULL;
+      goto done;
+    }
   }
+
+ done:
+  free(row_start);
+  free(col_start);
+  free(by_row);
+  free(by_col);
+  free(rowno);
+  free(column);
+  return lp;
 }
 
-/** A wrapper for get_objective().
+/* Undo log of model changes, used by lpsolve_with_overrides() and
+   lpsolve_transaction().
+
+   Each change to the model records the value it overwrote, so that
+   changes can be rolled back by restoring just those entries, newest
+   first. */
+
+/** What a change touched. */
+typedef enum {
+  UNDO_LOWBO,   /**< Lower bound of column col. */
+  UNDO_UPBO,    /**< Upper bound of column col. */
+  UNDO_RH,      /**< Right-hand side of row row. */
+  UNDO_MAT,     /**< Matrix element (row, col); row 0 is the objective. */
+  UNDO_INT,     /**< Integer flag of column col, as 0 or 1. */
+  UNDO_SEMICONT,/**< Semi-continuous flag of column col, as 0 or 1. */
+  UNDO_RH_RANGE,/**< Range of row row, as given to set_rh_range(). */
+  UNDO_SENSE,   /**< 1 when maximizing, 0 when minimizing. */
+  UNDO_ADD_ROW, /**< Row row was appended; undone by deleting it. */
+  UNDO_ADD_COL  /**< Column col was appended; undone by deleting it. */
+} undo_kind_t;
+
+typedef struct {
+  undo_kind_t kind;
+  int row;
+  int col;
+  REAL value;   /**< The value before the change. */
+} undo_entry_t;
+
+typedef struct {
+  undo_entry_t *entries;
+  long n;
+  long cap;
+} undo_log_t;
+
+static REAL
+undo_get(lprec *lp, undo_kind_t kind, int row, int col)
+{
+  switch (kind) {
+  case UNDO_LOWBO: return get_lowbo(lp, col);
+  case UNDO_UPBO:  return get_upbo(lp, col);
+  case UNDO_RH:    return get_rh(lp, row);
+  case UNDO_MAT:   return get_mat(lp, row, col);
+  case UNDO_INT:   return is_int(lp, col) ? 1.0 : 0.0;
+  case UNDO_SEMICONT: return is_semicont(lp, col) ? 1.0 : 0.0;
+  case UNDO_RH_RANGE: return get_rh_range(lp, row);
+  case UNDO_SENSE: return is_maxim(lp) ? 1.0 : 0.0;
+  case UNDO_ADD_ROW:
+  case UNDO_ADD_COL: break;
+  }
+  return 0.0;
+}
 
-    returns the value of the objective of the last solve().
-    This value is only valid after a successful lpsolve_solve() or 
-    lag_solve.
+static MYBOOL
+undo_set(lprec *lp, undo_kind_t kind, int row, int col, REAL value)
+{
+  switch (kind) {
+  case UNDO_LOWBO: return set_lowbo(lp, col, value);
+  case UNDO_UPBO:  return set_upbo(lp, col, value);
+  case UNDO_RH:    return set_rh(lp, row, value);
+  case UNDO_MAT:   return set_mat(lp, row, col, value);
+  case UNDO_INT:   return set_int(lp, col, 0.0 != value);
+  case UNDO_SEMICONT: return set_semicont(lp, col, 0.0 != value);
+  case UNDO_RH_RANGE: return set_rh_range(lp, row, value);
+  case UNDO_SENSE: set_sense(lp, 0.0 != value); return TRUE;
+  case UNDO_ADD_ROW:
+    /* Rows can only be deleted with row entry mode off. */
+    if (is_add_rowmode(lp)) set_add_rowmode(lp, FALSE);
+    return del_constraint(lp, row);
+  case UNDO_ADD_COL: return del_column(lp, col);
+  }
+  return FALSE;
+}
 
-    In Ruby, you can also use accessor function objective.
-
-    @param self self
-    @return the objective value. It is a real value.
-*/
-static VALUE lpsolve_get_objective(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_objective);
-
-/** A wrapper for get_origcol_name().
-
-    Returns the name of the specified column. 
-
-    The difference between lpsolve_get_col_name() and
-    lpsolve_get_origcol_name() is only visible when a presolve
-    (lpsolve_set_presolve()) was done. Presolve can result in deletion
-    of columns in the model. In lpsolve_get_col_name(), column
-    specifies the column number after presolve was done.
-
-    @param self self
-    @param column_num column number
-
-    @return nil indicates an error. 
+/** Append an entry to \a p_log holding the current value of what a
+    change of \a kind at (\a row, \a col) is about to overwrite.
+    Growing the log may raise NoMemoryError; that happens before the
+    model is touched.
 */
-static VALUE
-lpsolve_get_origcol_name(VALUE self, VALUE column_num) 
+static void
+undo_record(lprec *lp, undo_log_t *p_log, undo_kind_t kind, int row, int col)
 {
-  lprec *lp;
-  char *psz_col_name;
-  Data_Get_Struct(self, lprec, lp);
-  if (TYPE(column_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not an integer.\n", 
-           __FUNCTION__);
-    return Qnil;
+  undo_entry_t *p_entry;
+  if (p_log->n == p_log->cap) {
+    p_log->cap = (p_log->cap > 0) ? 2 * p_log->cap : 16;
+    REALLOC_N(p_log->entries, undo_entry_t, p_log->cap);
   }
-  psz_col_name = get_origcol_name(lp, FIX2INT(column_num));
-  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+  p_entry = &p_log->entries[p_log->n++];
+  p_entry->kind  = kind;
+  p_entry->row   = row;
+  p_entry->col   = col;
+  p_entry->value = undo_get(lp, kind, row, col);
 }
 
-/** A wrapper for get_origrow_name()
-
-    @param self self
-    @param row_num row number
-
-    get_row_name and get_origrow_name return the name of the specified
-    row. A return value of NULL indicates an error. The difference
-    between lpsolve_get_row_name() and lpsolve_get_origrow_name() is
-    only visible when a presolve (lpsovle_set_presolve()) was
-    done. Presolve can result in deletion of rows in the model. In
-    get_row_name, row specifies the row number after presolve was
-    done. In lpsolve_get_origrow_name(), row specifies the row number
-    before presolve was done, ie the original row number. If presolve
-    is not active then both functions are equal.
+/** Change one entry of the model, recording its old value in \a
+    p_log.
 
-    @return a Ruby string row name.
+    @return \a TRUE if lp_solve accepted the change.
 */
-static VALUE
-lpsolve_get_origrow_name(VALUE self, VALUE row_num) 
+static MYBOOL
+undo_change(lprec *lp, undo_log_t *p_log, undo_kind_t kind, int row, int col,
+            REAL value)
 {
-  char *psz_col_name;
-  INIT_LP;
-  if (TYPE(row_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
-    return Qnil;
+  undo_record(lp, p_log, kind, row, col);
+  if (!undo_set(lp, kind, row, col, value)) {
+    p_log->n--;
+    return FALSE;
   }
-  psz_col_name = get_origrow_name(lp, FIX2INT(row_num));
-  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+  return TRUE;
 }
 
-/** 
-    A wrapper for get_presolve().
-
-    @param self self
-    @return the number of columns (variables) in the lp.
-*/
-static VALUE lpsolve_get_presolve(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_presolve);
-
-/** 
-    A wrapper for get_presolveloops().
+/** Undo the changes in \a p_log after the first \a mark, newest
+    first, and drop them from the log. */
+static void
+undo_rollback(lprec *lp, undo_log_t *p_log, long mark)
+{
+  while (p_log->n > mark) {
+    undo_entry_t *p_entry = &p_log->entries[--p_log->n];
+    undo_set(lp, p_entry->kind, p_entry->row, p_entry->col, p_entry->value);
+  }
+}
 
-    Returns the number of times presolve is may be iterated. After a
-    presolve is performed, another presolve may result in elimination
-    of more rows and columns. This number specifies the maximum
-    number of times this process may be repeated. 
+/** The rb_protect() state of a raised exception, Ruby's TAG_RAISE,
+    which its public headers do not export. break, next, return and
+    throw leave a block with other states. */
+#define PROTECT_TAG_RAISE 6
 
-    By default presolve repetition is performed until no simplification
-    is done.
+/** The change journal of an LPSolve object inside
+    lpsolve_transaction(), kept in its hidden "journal" instance
+    variable. */
+typedef struct {
+  undo_log_t log;
+  int depth;      /**< Number of transaction blocks being run. */
+  int overrides;  /**< Number of with_overrides() blocks being run. */
+} journal_t;
 
-    @param self self
-    @return maximum number of presolve loops. A value of -1 means we 
-    loop for as many times as there is improvement.
-*/
-static VALUE lpsolve_get_presolveloops(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_presolveloops);
+static void
+journal_free(journal_t *p_journal)
+{
+  free(p_journal->log.entries);
+  free(p_journal);
+}
 
-/** A wrapper for get_row().
+/** Return the journal of \a self, creating it if \a b_create is
+    set, else \a NULL if there is none yet. */
+static journal_t *
+journal_get(VALUE self, MYBOOL b_create)
+{
+  ID id_journal = rb_intern("journal");
+  VALUE holder = rb_attr_get(self, id_journal);
+  journal_t *p_journal;
+  if (NIL_P(holder)) {
+    if (!b_create) return NULL;
+    p_journal = ALLOC(journal_t);
+    memset(p_journal, 0, sizeof(journal_t));
+    holder = Data_Wrap_Struct(0, 0, journal_free, p_journal);
+    rb_ivar_set(self, id_journal, holder);
+  }
+  Data_Get_Struct(holder, journal_t, p_journal);
+  return p_journal;
+}
 
-  Get all row elements from the matrix for a given row number.
+/** Return the undo log that changes to \a self should be recorded
+    in, or \a NULL when no transaction is running. */
+static undo_log_t *
+journal_log(VALUE self)
+{
+  journal_t *p_journal = journal_get(self, FALSE);
+  if (NULL == p_journal) return NULL;
+  return (p_journal->depth > 0) ? &p_journal->log : NULL;
+}
 
-  @param self self
+/** Record what a change of \a kind at (\a row, \a col) to \a self
+    is about to overwrite, if a transaction is running. Call before
+    making the change. */
+static void
+journal_note(VALUE self, lprec *lp, undo_kind_t kind, int row, int col)
+{
+  undo_log_t *p_log = journal_log(self);
+  if (NULL != p_log) undo_record(lp, p_log, kind, row, col);
+}
 
-  @param row_num the row number that you want. The value must be
-  between 1 and the number of rows.
+/** Drop the last \a count entries journal_note() recorded, for a
+    change that lp_solve then refused. Returns \a b_ret, the result
+    of the change. */
+static MYBOOL
+journal_done(VALUE self, MYBOOL b_ret, int count)
+{
+  undo_log_t *p_log = journal_log(self);
+  if (!b_ret && NULL != p_log) p_log->n -= count;
+  return b_ret;
+}
 
-  @return an array of the row values. The size of the array is 
-  the number of columns + 1. Nil is returned if there was an error.
-*/
-static VALUE
-lpsolve_get_row(VALUE self, VALUE row_num) 
+/** Report an error and return \a FALSE unless \a row, if not -1, is
+    a row of \a lp (0 being the objective) and \a col, if not -1, is
+    one of its columns. Setters check this before journal_note(), so
+    that a change refused anyway is not journaled. */
+static MYBOOL
+index_ok(lprec *lp, const char *psz_fn, int row, int col)
 {
-  unsigned int i_row = FIX2INT(row_num);
-  unsigned int i_columns;
-  REAL *p_row;
+  if (-1 != row && (row < 0 || row > lp->rows)) {
+    report(lp, IMPORTANT, "%s: row %d is out of range.\n", psz_fn, row);
+    return FALSE;
+  }
+  if (-1 != col && (col < 1 || col > lp->columns)) {
+    report(lp, IMPORTANT, "%s: column %d is out of range.\n", psz_fn, col);
+    return FALSE;
+  }
+  return TRUE;
+}
 
-  INIT_LP;
+/** Return a copy of the objective function of \a lp, to be handed to
+    journal_objective_end() once it has been changed, or \a NULL when
+    no transaction is running. */
+static REAL *
+journal_objective_begin(VALUE self, lprec *lp)
+{
+  REAL *obj;
+  if (NULL == journal_log(self)) return NULL;
+  obj = ALLOC_N(REAL, 1 + lp->columns);
+  get_row(lp, 0, obj);
+  return obj;
+}
 
-  if (TYPE(row_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
-    return Qnil;
+/** Record the objective coefficients that differ from \a old_obj,
+    as returned by journal_objective_begin(), and free it. */
+static void
+journal_objective_end(VALUE self, lprec *lp, REAL *old_obj)
+{
+  undo_log_t *p_log = journal_log(self);
+  REAL *new_obj;
+  int j;
+  if (NULL == old_obj) return;
+  if (NULL == p_log) {
+    free(old_obj);
+    return;
   }
-  i_columns =  get_Ncolumns(lp); /* Yep, Ncolumns, not Nrows. */
-  p_row = ALLOC_N(REAL, i_columns + 1);
-  
-  if (!get_row(lp, i_row, p_row)) {
-    free(p_row);
-    return Qnil;
-  } else {
-    VALUE ret_ary = rb_ary_new2(i_columns+1);
-    unsigned int i;
-    for (i=0; i<=i_columns; i++) {
-      rb_ary_push(ret_ary, rb_float_new(p_row[i]));
+  new_obj = ALLOC_N(REAL, 1 + lp->columns);
+  get_row(lp, 0, new_obj);
+  for (j = 1; j <= lp->columns; j++) {
+    if (new_obj[j] != old_obj[j]) {
+      undo_record(lp, p_log, UNDO_MAT, 0, j);
+      p_log->entries[p_log->n - 1].value = old_obj[j];
     }
-    free(p_row);
-    return ret_ary;
   }
-  
+  free(new_obj);
+  free(old_obj);
 }
 
-/** A wrapper for get_row_name()
+/** Report an error and return \a TRUE if \a self is inside a
+    transaction or a with_overrides() block, for changes that cannot
+    be journaled or that renumber the rows and columns an undo log
+    refers to. */
+static MYBOOL
+journal_refuse(VALUE self, lprec *lp, const char *psz_fn)
+{
+  journal_t *p_journal = journal_get(self, FALSE);
+  if (NULL == p_journal) return FALSE;
+  if (p_journal->depth > 0) {
+    report(lp, IMPORTANT, "%s: not allowed inside a transaction.\n", psz_fn);
+    return TRUE;
+  }
+  if (p_journal->overrides > 0) {
+    report(lp, IMPORTANT, "%s: not allowed inside with_overrides.\n",
+           psz_fn);
+    return TRUE;
+  }
+  return FALSE;
+}
 
-    @param self self
-    @param row_num row number
+/** Holder for LPSolve class object. A singleton value. */
+VALUE rb_cLPSolve;
+
+/** LPSolve::Rollback, raised in a transaction block to roll it back
+    quietly. */
+static VALUE rb_eLPSolveRollback;
+
+/** Directory of the parsed-model cache used by read_LP and read_MPS,
+    or nil when the cache is off. See lpsolve_set_model_cache_dir(). */
+static VALUE model_cache_dir = Qnil;
 
-    @return the name of the specified row. A return value of NULL
-    indicates an error. The difference between lpsolve_get_row_name()
-    and lpsolve_get_origrow_name() is only visible when a presolve
-    (set_presolve) was done. Presolve can result in deletion of rows
-    in the model. In lpsolve_get_row_name(), row specifies the row
-    number after presolve was done. In lpsolve_aget_origrow_name(),
-    row specifies the row number before presolve was done, ie the
-    original row number. If presolve is not active then both functions
-    are equal.  Returns a Ruby string row name.
-*/
 static VALUE
-lpsolve_get_row_name(VALUE self, VALUE row_num) 
+model_cache_key_protected(VALUE args)
 {
-  char *psz_col_name;
-  INIT_LP;
-  if (TYPE(row_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
+  VALUE *p_args = (VALUE *) args;
+  VALUE digest = rb_funcall(rb_path2class("Digest::SHA256"),
+                            rb_intern("new"), 0);
+  rb_funcall(digest, rb_intern("update"), 1, p_args[1]);
+  rb_funcall(digest, rb_intern("file"), 1, p_args[0]);
+  return rb_funcall(digest, rb_intern("hexdigest"), 0);
+}
+
+/* Return the cache file for the model in filename, keyed by a SHA-256
+   of its contents, format and model name, or nil if the file cannot
+   be hashed. */
+static VALUE
+model_cache_path(VALUE filename, model_format_t format, const char *lp_name)
+{
+  VALUE args[2];
+  VALUE key;
+  int state = 0;
+  args[0] = filename;
+  args[1] = rb_sprintf("%d:%d:%s", SNAPSHOT_VERSION, (int) format,
+                       (NULL != lp_name) ? lp_name : "");
+  key = rb_protect(model_cache_key_protected, (VALUE) args, &state);
+  if (state) {
+    rb_set_errinfo(Qnil);
     return Qnil;
   }
-  psz_col_name = get_row_name(lp, FIX2INT(row_num));
-  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+  return rb_sprintf("%"PRIsVALUE"/%"PRIsVALUE".lpsnap", model_cache_dir, key);
 }
 
-/** A wrapper for get_scaling().
-
-    @param self self
-    @return A Ruby integer indicating scaling algorithm is used. 
+/** Like read_model(), but when the model cache is on, load a
+    previously parsed copy of an unchanged file from the cache, and
+    store a newly parsed one there. Raises NotImplementedError for a
+    compressed file this build cannot decompress.
 
-    In Ruby, you can also use accessor function scaling.
+    @return the new lprec or \a NULL on error.
 */
-static VALUE lpsolve_get_scaling(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_scaling)
-
-/** 
-    A wrapper for get_simplextype()
+static lprec *
+read_model_cached(VALUE filename, model_format_t format, int verbosity,
+                  char *lp_name)
+{
+  VALUE cache_path, tmp_path;
+  const char *psz_error;
+  const char *psz_missing = compression_missing(RSTRING_PTR(filename));
+  lprec *lp;
+  FILE *fp;
+
+  if (NULL != psz_missing)
+    rb_raise(rb_eNotImpError, "%s: cannot decompress, built without %s",
+             RSTRING_PTR(filename), psz_missing);
+  if (NIL_P(model_cache_dir) 
+      || NIL_P(cache_path = model_cache_path(filename, format, lp_name)))
+    return read_model(RSTRING_PTR(filename), format, verbosity, lp_name);
+
+  lp = snapshot_load(RSTRING_PTR(cache_path), &psz_error);
+  if (NULL != lp) {
+    set_verbose(lp, verbosity);
+    return lp;
+  }
 
-    get_simplextype returns the desired combination of primal and dual
-    simplex algorithms.
+  lp = read_model(RSTRING_PTR(filename), format, verbosity, lp_name);
+  if (NULL == lp) return NULL;
+
+  /* Write under a private name and rename, so that concurrent readers
+     never see a partial entry. */
+  tmp_path = rb_sprintf("%"PRIsVALUE".%ld.tmp", cache_path, (long) getpid());
+  fp = fopen(RSTRING_PTR(tmp_path), "wb");
+  if (NULL != fp) {
+    MYBOOL b_ok = snapshot_write(lp, fp);
+    if (0 != fclose(fp)) b_ok = FALSE;
+    if (!b_ok || 0 != rename(RSTRING_PTR(tmp_path), RSTRING_PTR(cache_path)))
+      unlink(RSTRING_PTR(tmp_path));
+  }
+  return lp;
+}
 
-    The default is SIMPLEX_DUAL_PRIMAL.
+static void lpsolve_free(void *lp);
 
-    In Ruby, you can also use accessor function simplextype.
+/** 
+ A wrapper for add_constraintex.
 
-    @param self self
+ Adds a constraint. These routines will perform much better when
+ lpsolve_set_add_rowmode() is called before adding constraints.
 
-    @return a Ruby integer simplex type which is one of the following
-    values:
-       \a LPSolve::SIMPLEX_PRIMAL_PRIMAL, 
-       \a LPSolve::DUAL_PRIMAL, 
-       \a LPSolve::PRIMAL_DUAL, 
-       \a LPSolve::DUAL_DUAL
+ @param self self
+ @param name The name of the constraint or \a nil if no name.
 
-*/
-static VALUE lpsolve_get_simplextype(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_simplextype)
+ @param row_coeffs A list of tuples. The first entry of the tuple is
+ the column number which should be in the range 0..columns-1; the
+ second entry in the tuple should be the coefficient value.
 
-/** 
-    A wrapper for get_solutioncount().
+ @param constr_type The constraint type. Should be one of 
+ \a LPSolve::LE, \a LPSolve::EQ, \a LPSolve::GE.
 
-    Returns the number of equal solutions. This is only valid if there
-    are integer, semi-continious or SOS variables in the model so that
-    the branch-and-bound algoritm is used. This count gives the number
-    of solutions with the same optimal objective value. If there is
-    only one optimal solution, this value is 1.
+ @param rh The right-hand-side constant, a number.
 
-    @param self self
+ @return number of rows, (the row number of the constraint added) if
+ successful or \a nil on error.
 
-    @return the number of equal solutions to to
-    lpsolve_get_solutionlimit.
-    
 */
-static VALUE lpsolve_get_solutioncount(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_solutioncount)
-
-/** 
-    A wrapper for get_solutionlimit().
-
-    returns the number of solutions that must be returned. 
+static VALUE 
+lpsolve_add_constraintex(VALUE self, VALUE name, VALUE row_coeffs, 
+                         VALUE constr_type, VALUE rh) 
+{
+  int i_constr_type = FIX2INT(constr_type);
+  REAL r_rh = NUM2DBL(rh);
+  REAL *row = NULL;
+  int *colno = NULL;
+  long int i, count;
+  VALUE ret = Qnil;
+  MYBOOL b_ret;
+  VALUE *p_row_coeff = NULL;
 
-    @param self self
+  INIT_LP;
 
-    @return the number of solutions that must be returned.
+  if (TYPE(name) != T_STRING && name != Qnil) {
+    report(lp, IMPORTANT, 
+           "%s: constraint name, parameter 1, should be nil or a string.\n", 
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  if (TYPE(row_coeffs) != T_ARRAY) {
+    report(lp, IMPORTANT, 
+           "%s: row coefficients, parameter 2 is not an array.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  if (TYPE(constr_type) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: constraint type, parameter 3, is not a number.\n", 
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  switch (i_constr_type) {
+  case EQ:
+  case GE:
+  case LE: break;
+  default:
+    report(lp, IMPORTANT, 
+           "%s: constraint type, parameter 3, should be LE, EQ, or GE.\n", 
+           __FUNCTION__);
+    return Qnil;
+  }
+  
+  /***FIXME: combine common parts of this with add_constraintex ****/
+  count   = RARRAY_LEN(row_coeffs);
+
+  if (0 == count)  {
+    report(lp, IMPORTANT, 
+           "%s: row coefficients array has to have at least one item.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  colno   = ALLOC_N(int, count);
+  row     = ALLOC_N(REAL, count);
+
+  p_row_coeff = RARRAY_PTR(row_coeffs);
+  for (i = 0; i < count; i++) {
+    int i_col;
+    if (TYPE(*p_row_coeff) != T_ARRAY) {
+      report(lp, IMPORTANT, 
+             "%s: row coeffient element %d is not an array.\n", 
+             __FUNCTION__, i);
+      goto done;
+    }
+    if (RARRAY_LEN(*p_row_coeff) != 2) {
+      report(lp, IMPORTANT, 
+             "%s: row coeffient element %d is not an array tuple.\n", 
+             __FUNCTION__, i);
+      goto done;
+    } else {
+      VALUE *tuple = RARRAY_PTR(*p_row_coeff);
+      if (TYPE(tuple[0]) != T_FIXNUM) {
+        report(lp, IMPORTANT, 
+               "%s: Column number, first element, of row coefficients at " \
+               "tuple %d is not a integer.\n", __FUNCTION__, i);
+        goto done;
+      }
+      switch (TYPE(tuple[1])) {
+      case T_FIXNUM:
+      case T_FLOAT: break;
+      default:
+        report(lp, IMPORTANT, 
+               "%s: Coefficient value, second element, of row coeffients at "
+               "tuple %d is not an integer.\n", __FUNCTION__, i);
+        goto done;
+      }
+
+      i_col = FIX2INT(tuple[0]);
+      if (i_col <= 0 || i_col > lp->columns) {
+        report(lp, IMPORTANT, 
+               "%s: Column number, first element, of row coeffients at " \
+               "tuple %d, value %d, is not in the range 1..%d\n", 
+               __FUNCTION__, i, i_col, lp->columns);
+        goto done;
+      }
+      colno[i] = i_col;
+      row[i]   = NUM2DBL(tuple[1]);
+    }
+    p_row_coeff++;
+  }
+
+  b_ret = add_constraintex(lp, count, row, colno, i_constr_type, r_rh);
+  if (b_ret) {
+    ret = INT2FIX(lp->rows);
+    if (name != Qnil) 
+      set_row_name(lp, lp->rows, RSTRING_PTR(name));
+    journal_note(self, lp, UNDO_ADD_ROW, lp->rows, 0);
+  }
+
+ done:
+  free(row);
+  free(colno);
+  return ret;
+}
+
+/** 
+ A wrapper for add_SOS.
+
+ Adds an SOS constraint. A Special Ordered Set of Type n is a way of
+ indicating that at most n of a set of variables may be nonzero.
+
+ @param self self
+ @param name The name of the SOS constraint.
+
+ @param sos_type The type of the SOS constraint, 1 means "at most 1" 2
+ means "at most 2".  Must be >= 1.
+ @param priority Priority of the SOS constraint in the SOS set.
+ @param sos_vars  A list of tuples of column numbers and weights
+
+*/
+static VALUE 
+lpsolve_add_SOS(VALUE self, VALUE name, VALUE sos_type, VALUE priority, 
+                VALUE sos_vars) 
+{
+  int i_sos_type = FIX2INT(sos_type);
+  int i_priority = FIX2INT(priority);
+  int *vars = NULL;
+  double *weights = NULL;
+  long int i, count;
+  VALUE *p_sos_var;
+  VALUE ret = Qnil;
+  int i_ret = 0;
+
+  INIT_LP;
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qnil;
+  
+  if (TYPE(sos_type) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: SOS type, parameter 2, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  
+  if (TYPE(priority) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: priority, parameter 3, not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  if (TYPE(name) != T_STRING) {
+    report(lp, IMPORTANT, "%s: name is not a string.\n", __FUNCTION__);
+    return Qnil;
+  }
+  if (i_sos_type < 1) {
+    report(lp, IMPORTANT, "%s: SOS type (%ld) is less than 1.\n",
+           __FUNCTION__, i_sos_type);
+    return Qnil;
+  }
+  
+  if (TYPE(sos_vars) != T_ARRAY) {
+    report(lp, IMPORTANT, "%s: SOS vars is not an array.\n", __FUNCTION__);
+    return Qnil;
+  }
+
+  count   = RARRAY_LEN(sos_vars);
+
+  if (0 == count)  {
+    report(lp, IMPORTANT, 
+           "%s: SOS vars array has to have at least one item.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  vars    = ALLOC_N(int, count);
+  weights = ALLOC_N(double, count);
+
+  p_sos_var = RARRAY_PTR(sos_vars);
+  for (i = 0; i < count; i++) {
+    if (TYPE(*p_sos_var) != T_ARRAY) {
+      report(lp, IMPORTANT, 
+             "%s: SOS vars element %d is not an array.\n", __FUNCTION__, i);
+      goto done;
+    }
+    if (RARRAY_LEN(*p_sos_var) != 2) {
+      report(lp, IMPORTANT, 
+             "%s: SOS vars element %d is not an array tuple.\n", __FUNCTION__,
+             i);
+      goto done;
+    } else {
+      VALUE *tuple = RARRAY_PTR(*p_sos_var);
+      if (TYPE(tuple[0]) != T_FIXNUM) {
+        report(lp, IMPORTANT, 
+               "%s: First element of SOS vars at tuple %d " \
+               "is not a integer.\n",  __FUNCTION__, i);
+        goto done;
+      }
+      if (TYPE(tuple[1]) != T_FIXNUM) {
+        report(lp, IMPORTANT, 
+               "%s: Second element of SOS vars at tuple %d " \
+               "is not an integer.\n", __FUNCTION__, i);
+        goto done;
+      }
+      vars[i] = FIX2INT(tuple[0]);
+      weights[i] = FIX2INT(tuple[1]);
+    }
+    p_sos_var++;
+  }
+  i_ret = add_SOS(lp, RSTRING_PTR(name), i_sos_type, i_priority, 
+                  count, vars, weights);
+  if (i_ret != 0)
+    ret = INT2FIX(i_ret);
+
+ done:
+  free(vars);
+  free(weights);
+  return ret;
+}
+
+/** Allocate a Ruby container for a lprec * pointer. Ruby may call
+    this routine directly under various circumstances such as when
+    doing data marshalling. However usually the most common case is
+    when new() is called.  Here, after the call to lpsolve_alloc(),
+    Ruby will call lpsolve_initialize(). 
+*/
+static VALUE 
+lpsolve_alloc(VALUE klass) 
+{
+  VALUE obj;
+  obj = Data_Wrap_Struct(klass, 0, lpsolve_free, NULL);
+  return obj;
+}
+
+/** A wrapper for default_basis().
+
+    Sets the starting base to an all slack basis (the default simplex
+    starting basis).
+    
+    @param self self
+    @return \a true unless we have an error.
+*/
+static VALUE lpsolve_default_basis(VALUE self);
+LPSOLVE_0_IN_STATUS_OUT(default_basis)
+
+/** A wrapper for del_column().
+
+    @param self self
+    @param column_num column number
+
+    @return \a true if the operation was successful. false indicates an
+    error.  An error occurs when column is not between 1 and the number
+    of columns in the lp.  Note that row entry mode must be off, else
+    this function also fails. Deleting is not allowed inside
+    lpsolve_transaction() or lpsolve_with_overrides().
+
+    @see lpsolve_set_add_rowmode()
+*/
+static VALUE
+lpsolve_del_column(VALUE self, VALUE column_num)
+{
+  INIT_LP;
+  if (TYPE(column_num) != T_FIXNUM) {
+    report(lp, IMPORTANT,
+           "%s: Parameter is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qfalse;
+  RETURN_BOOL(del_column(lp, FIX2INT(column_num)));
+}
+
+/** A wrapper for del_constraint()
+
+  del_constraint returns true if the operation was successful. 
+
+  @param self self
+  @param row_num row number
+
+  @return a \a false value indicates an error.  An error occurs when
+  row_num is not between 1 and the number of rows self.  Note that row
+  entry mode must be off, else this function also fails. Deleting is
+  not allowed inside lpsolve_transaction() or
+  lpsolve_with_overrides(). @see lpsolve_set_add_rowmode().
+*/
+static VALUE
+lpsolve_del_constraint(VALUE self, VALUE row_num)
+{
+  INIT_LP;
+  if (TYPE(row_num) != T_FIXNUM) {
+    report(lp, IMPORTANT,
+           "%s: Parameter is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qfalse;
+  RETURN_BOOL(del_constraint(lp, FIX2INT(row_num)));
+}
+
+
+static void
+lpsolve_free(void *lp) 
+{
+#if DEBUG_GC
+  printf("lpsolve_free called\n");
+#endif
+  if (NULL != lp) {
+    /* A stream set by set_output_io() belongs to a hidden object that
+       the garbage collector may already have freed; keep delete_lp()
+       from flushing it. Owned streams are still closed by lp_solve. */
+    if (!((lprec *) lp)->streamowned) ((lprec *) lp)->outstream = stdout;
+    delete_lp((lprec *)lp);
+  }
+}
+
+/** A wrapper for get_bb_depthlimit(lprec *lp);
+
+   get_bb_depthlimit returns the maximum branch-and-bound depth. 
+
+   Parameters
+
+   lp
+
+   Pointer to previously created lp model. See return value of make_lp, copy_lp, read_lp, read_LP, read_mps, read_freemps, read_MPS, read_freeMPS, read_XLI
+
+   Remarks
+   
+   The get_bb_depthlimit function returns the maximum branch-and-bound
+   depth.  This is only useful if there are integer, semi-continious
+   or SOS variables in the model so that the branch-and-bound
+   algorithm must be used to solve them. The branch-and-bound
+   algorithm will not go deeper than this level. When 0 then there is
+   no limit to the depth. Limiting the depth will speed up solving
+   time, but there is a chance that the found solution is not the most
+   optimal one. Be aware of this. It can also result in not finding a
+   solution at all. A positive value means that the depth is
+   absolute. NOTE: in the standard lpsolve an absolute depth is
+   *added* to the number of SOS vars and semi-continuous vars. In a
+   hacked version of lpsolve, absolute is, well, absolute.
+
+   A negative value means a relative B&B depth limit. The
+   "order" of a MIP problem is defined to be 2x the number of binary
+   variables plus the number of SC and SOS variables. A relative value
+   of -x results in a maximum depth of x times the order of the MIP
+   problem.  The default is -50.  The get_bb_rule function returns the
+   branch-and-bound rule for choosing which non-integer variable is to
+   be selected. This rule can influence solving times
+   considerably. Depending on the model one rule can be best and for
+   another model another rule.  The default is NODE_PSEUDONONINTSELECT
+   + NODE_GREEDYMODE + NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
+
+    @param self self
+    @return  Returns the branch-and-bound rule.
+*/
+static VALUE lpsolve_get_bb_depthlimit(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_bb_depthlimit);
+
+/** A wrapper for get_bb_rule().
+
+    The get_bb_rule function returns the branch-and-bound rule for
+    choosing which non-integer variable is to be selected. This rule
+    can influence solving times considerably. Depending on the model
+    one rule can be best and for another model another rule.  The
+    default is NODE_PSEUDONONINTSELECT + NODE_GREEDYMODE +
+    NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
+
+    @param self self
+    @return  Returns the branch-and-bound rule.
+
+*/
+static VALUE lpsolve_get_bb_rule(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_bb_rule);
+
+/** A wrapper for get_col_name().
+
+    get_col_name() returns the name of the specified column.  The
+    difference between get_col_name and get_origcol_name is only
+    visible when a presolve (set_presolve) was done. Presolve can
+    result in deletion of columns in the model. In get_col_name(),
+    column specifies the column number after presolve was done.
+
+    @return the string name. A value of \a nil indicates an error. 
+*/
+static VALUE 
+lpsolve_get_col_name(VALUE self, VALUE column_num) 
+{
+  char *psz_col_name;
+  INIT_LP;
+
+  if (TYPE(column_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not an integer.\n", 
+           __FUNCTION__);
+    return Qnil;
+  }
+
+  psz_col_name = get_col_name(lp, FIX2INT(column_num));
+  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+}
+
+/** get_col_num(). - Not in API  (yet)
+
+    get_col_num() returns the column number for the specified column
+    name.  
+
+    @return the column number. A value of \a nil indicates an error. 
+*/
+static VALUE 
+lpsolve_get_col_num(VALUE self, VALUE column_name) 
+{
+  INIT_LP;
+  
+  if (TYPE(column_name) != T_STRING) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not a string.\n", 
+           __FUNCTION__);
+    return Qnil;
+  } else {
+    int retval = get_col_num(lp, RSTRING_PTR(column_name));
+    return (-1 == retval) ? Qnil : INT2FIX(retval);
+  }
+}
+
+/** A wrapper for get_column().
+
+  Get all column elements from the matrix for a given column number.
+
+  @param self self
+
+  @param column_num the column number that you want. The value must be
+  between 1 and the number of columns.
+
+  @return an array of the column values. The size of the array is 
+  the number of rows + 1. \a Nil is returned if there was an error.
+*/
+static VALUE
+lpsolve_get_column(VALUE self, VALUE column_num) 
+{
+  unsigned int i_column = FIX2INT(column_num);
+  unsigned int i_rows;
+  REAL *p_column;
+  INIT_LP;
+  
+  i_rows =  get_Nrows(lp); /* Yep, Nrows, not Ncolumns. */
+  p_column = ALLOC_N(REAL, i_rows + 1);
+  
+  if (!get_column(lp, i_column, p_column)) {
+    free(p_column);
+    return Qnil;
+  } else {
+    VALUE ret_ary = rb_ary_new2(i_rows+1);
+    unsigned int i;
+    for (i=0; i<=i_rows; i++) {
+      rb_ary_push(ret_ary, rb_float_new(p_column[i]));
+    }
+    free(p_column);
+    return ret_ary;
+  }
+  
+}
+
+/** A wrapper for get_infinite().
+
+    @param self self
+    @return Returns the value of "infinite".
+*/
+static VALUE lpsolve_get_infinite(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_infinite);
+
+/** A wrapper for get_lowbo().
+
+   Returns the upper bound on the variable identified by column.
+   Setting a bound on a variable is the way to go instead of adding an
+   extra constraint (row) to the model. Setting a bound doesn't
+   increase the model size that means that the model stays smaller and
+   will be solved faster.  The default upper bound of a variable is
+   infinity (well not quite. It is a very big number. The value of
+   lpsolve_get_infinite().
+
+   @param self self
+
+   @param column_num the column number of the variable. It must be
+   between 1 and the number of columns in the lp.
+
+*/
+
+static VALUE lpsolve_get_lowbo(VALUE self, VALUE column_num);
+LPSOLVE_1_IN_NUM_OUT(get_lowbo, T_FIXNUM, "an integer", FIX2INT);
+
+/** A wrapper for get_lp_name().
+
+    @return the name of the lp. The doc says the default name is
+    "Unnamed", but in fact we seem to return "".
+*/
+static VALUE
+lpsolve_get_lp_name(VALUE self) 
+{
+  char *psz_lp_name;
+  INIT_LP;
+  psz_lp_name = get_lp_name(lp);
+  return psz_lp_name ? rb_str_new2(psz_lp_name) : rb_str_new2("Unnamed");
+}
+
+/** 
+    A wrapper for get_Ncolumns().
+
+    Return the number of columns (variables) in the lp object. Note
+    that the number of columns can change when a presolve is done or
+    when negative variables are split in a positive and a negative
+    part.  Therefore it is advisable to use this function to determine
+    how many columns there are in the lp instead of relying one's own
+    count.
+
+    @param self self
+    @return the number of columns (variables) in the lp.
+*/
+static VALUE lpsolve_get_Ncolumns(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_Ncolumns)
+
+/** A wrapper for get_nonzeros().
+
+    Return the number of non-zero elements in matrix of the the lp object.
+
+    @param self self
+    @return the number of non-zero elements in the matrix of the lp.
+*/
+static VALUE lpsolve_get_nonzeros(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_nonzeros)
+
+/** 
+    A wrapper for get_Norig_columns().
+
+    Return the number of original columns (variables) in the lp
+    object. Note that the number of row does not change, but the
+    number of original columns does not.
+
+    @param self self
+    @return the number of columns (variables) in the lp.
+*/
+static VALUE lpsolve_get_Norig_columns(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_Norig_columns)
+
+/** A wrapper for get_Norig_rows().
+
+    Return the number of original rows (constraints) in the lp
+    object. Note that the number of row does not change, but the
+    number of original rows does not.
+
+    @param self self
+    @return the number of original rows (constraints) in the lp.
+*/
+static VALUE lpsolve_get_Norig_rows(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_Norig_rows)
+
+/** A wrapper for get_Nrows().
+
+    Return the number of rows (variables) in the lp object. Note that
+    the number of columns can change when a presolve is done or when
+    negative variables are split in a positive and a negative part.
+    Therefore it is advisable to use this function to determine how
+    many columns there are in the lp instead of relying one's own
+    count.
+
+    @param self self
+    @return the number of rows (constraints) in the lp.
+*/
+static VALUE lpsolve_get_Nrows(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_Nrows)
+
+/** A wrapper for get_mat().
+
+  Get a single element from the matrix.
+
+  @param self self
+  @param row_num row number
+  @param col_num column number
+
+  @return the value of the element on row \a row, column \a column. If no
+  value was set for this element, the function returns 0.  Note that
+  row entry mode must be off, else this function also fails. @see
+  lpsolve_set_add_rowmode().
+
+*/
+static VALUE
+lpsolve_get_mat(VALUE self, VALUE row_num, VALUE col_num) 
+{
+  INIT_LP;
+  if (TYPE(row_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  if (TYPE(col_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 2, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  return rb_float_new(get_mat(lp, FIX2INT(row_num), FIX2INT(col_num)));
+}
+
+/** A wrapper for get_mip_gap().
+
+   Sets the MIP gap that specifies a tolerance for the branch and bound
+   algorithm. This tolerance is the difference between the best-found
+   solution yet and the current solution. If the difference is smaller
+   than this tolerance then the solution (and all the sub-solutions) is
+   rejected. This can result in faster solving times, but results in a
+   solution which is not the perfect solution. So be careful with this
+   tolerance.  The default mip_gap value is 1e-9
+
+
+   @param self self
+   @param abs_rel: set to true if the gap is absolute, or false for relative.
+   @param val: gap value. The default mip_gap is 1e-9.
+   @return \a gap value or nil if there was an error.
+*/
+static VALUE
+lpsolve_get_mip_gap(VALUE self, VALUE abs_rel) 
+{
+  INIT_LP;
+  if (abs_rel != Qtrue && abs_rel != Qfalse && abs_rel != Qnil) {
+    report(lp, IMPORTANT,
+           "%s: Parameter is not a boolean or nil.\n",
+           __FUNCTION__);
+    return Qnil;
+  } else {
+    return rb_float_new(get_mip_gap(lp, Qtrue == abs_rel));
+  }
+}
+
+/** A wrapper for get_objective().
+
+    returns the value of the objective of the last solve().
+    This value is only valid after a successful lpsolve_solve() or 
+    lag_solve.
+
+    In Ruby, you can also use accessor function objective.
+
+    @param self self
+    @return the objective value. It is a real value.
+*/
+static VALUE lpsolve_get_objective(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_objective);
+
+/** A wrapper for get_orig_index().
+
+    Maps a row or column of the model after presolve to its number in
+    the original model. Rows are passed as 1 to rows and columns as
+    rows+1 to rows+columns; a row comes back as a row number, a column
+    as a plain column number, 1 to the original number of columns.
+
+    @param self self
+    @param lp_index the row or column in the current model.
+    @return its index in the original model, or \a nil on error.
+*/
+static VALUE
+lpsolve_get_orig_index(VALUE self, VALUE lp_index)
+{
+  INIT_LP;
+  if (TYPE(lp_index) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: index, parameter 1, is not an integer.\n", __FUNCTION__);
+    return Qnil;
+  }
+  return INT2FIX(get_orig_index(lp, FIX2INT(lp_index)));
+}
+
+/** A wrapper for get_lp_index().
+
+    The inverse of lpsolve_get_orig_index(): maps a row or column of
+    the original model to its number after presolve. Columns are
+    passed as orig_rows+1 to orig_rows+orig_columns and come back as a
+    plain column number.
+
+    @param self self
+    @param orig_index the row or column in the original model.
+    @return its index in the current model, 0 if presolve removed it,
+    or \a nil on error.
+*/
+static VALUE
+lpsolve_get_lp_index(VALUE self, VALUE orig_index)
+{
+  INIT_LP;
+  if (TYPE(orig_index) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: index, parameter 1, is not an integer.\n", __FUNCTION__);
+    return Qnil;
+  }
+  return INT2FIX(get_lp_index(lp, FIX2INT(orig_index)));
+}
+
+/** The index maps between the model after presolve and the original
+    one, in bulk.
+
+    @param self self
+    @return a Hash with :rows, the original row number of each current
+    row, :columns, the original column number of each current column,
+    and :orig_rows and :orig_columns, the current number of each
+    original row and column, 0 where presolve removed it. Each is a
+    String of packed native ints (unpack it with "i*").
+*/
+static VALUE
+lpsolve_get_index_map(VALUE self)
+{
+  VALUE result, rows_map, cols_map, orig_rows_map, orig_cols_map;
+  int rows, columns, orig_rows, orig_columns, i;
+  int *p_map;
+  INIT_LP;
+  rows = get_Nrows(lp);
+  columns = get_Ncolumns(lp);
+  orig_rows = get_Norig_rows(lp);
+  orig_columns = get_Norig_columns(lp);
+
+  rows_map = rb_str_new(NULL, rows * sizeof(int));
+  p_map = (int *) RSTRING_PTR(rows_map);
+  for (i = 1; i <= rows; i++) p_map[i - 1] = get_orig_index(lp, i);
+  cols_map = rb_str_new(NULL, columns * sizeof(int));
+  p_map = (int *) RSTRING_PTR(cols_map);
+  for (i = 1; i <= columns; i++) 
+    p_map[i - 1] = get_orig_index(lp, rows + i);
+
+  orig_rows_map = rb_str_new(NULL, orig_rows * sizeof(int));
+  p_map = (int *) RSTRING_PTR(orig_rows_map);
+  for (i = 1; i <= orig_rows; i++) p_map[i - 1] = get_lp_index(lp, i);
+  orig_cols_map = rb_str_new(NULL, orig_columns * sizeof(int));
+  p_map = (int *) RSTRING_PTR(orig_cols_map);
+  for (i = 1; i <= orig_columns; i++) 
+    p_map[i - 1] = get_lp_index(lp, orig_rows + i);
+
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("rows")), rows_map);
+  rb_hash_aset(result, ID2SYM(rb_intern("columns")), cols_map);
+  rb_hash_aset(result, ID2SYM(rb_intern("orig_rows")), orig_rows_map);
+  rb_hash_aset(result, ID2SYM(rb_intern("orig_columns")), orig_cols_map);
+  return result;
+}
+
+/** The last solution in the numbering of the original model, in bulk.
+
+    Unlike lpsolve_get_variables(), which follows the model after
+    presolve, this covers every original row and column. Those still
+    in the model take their values from the last solve, found through
+    get_lp_index(). Those presolve removed are frozen at the values of
+    the solve that presolved: lp_solve only updates them while
+    presolve is on, so after lpsolve_presolve_once() they do not follow
+    later solves.
+
+    @param self self
+    @return a Hash with :objective, :constraints, the activity of each
+    original row, and :variables, the value of each original column,
+    the latter two as Strings of packed native doubles (unpack them
+    with "d*"); \a nil if the model has not been solved.
+*/
+static VALUE
+lpsolve_get_orig_solution(VALUE self)
+{
+  VALUE result, constraints, variables;
+  VALUE status = rb_ivar_get(self, rb_intern("@status"));
+  int orig_rows, orig_columns, i, j;
+  REAL *p_constraints, *p_variables;
+  double *p_out;
+  INIT_LP;
+  if (!FIXNUM_P(status) || SOLVE_NOT_CALLED == FIX2INT(status)) 
+    return Qnil;
+  if (!get_ptr_constraints(lp, &p_constraints)
+      || !get_ptr_variables(lp, &p_variables)) {
+    report(lp, IMPORTANT, "%s: No solution available.\n", __FUNCTION__);
+    return Qnil;
+  }
+  orig_rows = get_Norig_rows(lp);
+  orig_columns = get_Norig_columns(lp);
+
+  constraints = rb_str_new(NULL, orig_rows * sizeof(double));
+  p_out = (double *) RSTRING_PTR(constraints);
+  for (i = 1; i <= orig_rows; i++) {
+    j = get_lp_index(lp, i);
+    p_out[i - 1] = (j > 0) ? p_constraints[j - 1] 
+      : get_var_primalresult(lp, i);
+  }
+  variables = rb_str_new(NULL, orig_columns * sizeof(double));
+  p_out = (double *) RSTRING_PTR(variables);
+  for (i = 1; i <= orig_columns; i++) {
+    j = get_lp_index(lp, orig_rows + i);
+    p_out[i - 1] = (j > 0) ? p_variables[j - 1]
+      : get_var_primalresult(lp, orig_rows + i);
+  }
+
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("objective")), 
+               rb_float_new(get_objective(lp)));
+  rb_hash_aset(result, ID2SYM(rb_intern("constraints")), constraints);
+  rb_hash_aset(result, ID2SYM(rb_intern("variables")), variables);
+  return result;
+}
+
+/** A wrapper for get_origcol_name().
+
+    Returns the name of the specified column. 
+
+    The difference between lpsolve_get_col_name() and
+    lpsolve_get_origcol_name() is only visible when a presolve
+    (lpsolve_set_presolve()) was done. Presolve can result in deletion
+    of columns in the model. In lpsolve_get_col_name(), column
+    specifies the column number after presolve was done.
+
+    @param self self
+    @param column_num column number
+
+    @return nil indicates an error. 
+*/
+static VALUE
+lpsolve_get_origcol_name(VALUE self, VALUE column_num) 
+{
+  lprec *lp;
+  char *psz_col_name;
+  Data_Get_Struct(self, lprec, lp);
+  if (TYPE(column_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not an integer.\n", 
+           __FUNCTION__);
+    return Qnil;
+  }
+  psz_col_name = get_origcol_name(lp, FIX2INT(column_num));
+  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+}
+
+/** A wrapper for get_origrow_name()
+
+    @param self self
+    @param row_num row number
+
+    get_row_name and get_origrow_name return the name of the specified
+    row. A return value of NULL indicates an error. The difference
+    between lpsolve_get_row_name() and lpsolve_get_origrow_name() is
+    only visible when a presolve (lpsovle_set_presolve()) was
+    done. Presolve can result in deletion of rows in the model. In
+    get_row_name, row specifies the row number after presolve was
+    done. In lpsolve_get_origrow_name(), row specifies the row number
+    before presolve was done, ie the original row number. If presolve
+    is not active then both functions are equal.
+
+    @return a Ruby string row name.
+*/
+static VALUE
+lpsolve_get_origrow_name(VALUE self, VALUE row_num) 
+{
+  char *psz_col_name;
+  INIT_LP;
+  if (TYPE(row_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  psz_col_name = get_origrow_name(lp, FIX2INT(row_num));
+  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+}
+
+/** 
+    A wrapper for get_presolve().
+
+    @param self self
+    @return the number of columns (variables) in the lp.
+*/
+static VALUE lpsolve_get_presolve(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_presolve);
+
+/** 
+    A wrapper for get_presolveloops().
+
+    Returns the number of times presolve is may be iterated. After a
+    presolve is performed, another presolve may result in elimination
+    of more rows and columns. This number specifies the maximum
+    number of times this process may be repeated. 
+
+    By default presolve repetition is performed until no simplification
+    is done.
+
+    @param self self
+    @return maximum number of presolve loops. A value of -1 means we 
+    loop for as many times as there is improvement.
+*/
+static VALUE lpsolve_get_presolveloops(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_presolveloops);
+
+/** A wrapper for get_row().
+
+  Get all row elements from the matrix for a given row number.
+
+  @param self self
+
+  @param row_num the row number that you want. The value must be
+  between 1 and the number of rows.
+
+  @return an array of the row values. The size of the array is 
+  the number of columns + 1. Nil is returned if there was an error.
+*/
+static VALUE
+lpsolve_get_row(VALUE self, VALUE row_num) 
+{
+  unsigned int i_row = FIX2INT(row_num);
+  unsigned int i_columns;
+  REAL *p_row;
+
+  INIT_LP;
+
+  if (TYPE(row_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  i_columns =  get_Ncolumns(lp); /* Yep, Ncolumns, not Nrows. */
+  p_row = ALLOC_N(REAL, i_columns + 1);
+  
+  if (!get_row(lp, i_row, p_row)) {
+    free(p_row);
+    return Qnil;
+  } else {
+    VALUE ret_ary = rb_ary_new2(i_columns+1);
+    unsigned int i;
+    for (i=0; i<=i_columns; i++) {
+      rb_ary_push(ret_ary, rb_float_new(p_row[i]));
+    }
+    free(p_row);
+    return ret_ary;
+  }
+  
+}
+
+/** A wrapper for get_row_name()
+
+    @param self self
+    @param row_num row number
+
+    @return the name of the specified row. A return value of NULL
+    indicates an error. The difference between lpsolve_get_row_name()
+    and lpsolve_get_origrow_name() is only visible when a presolve
+    (set_presolve) was done. Presolve can result in deletion of rows
+    in the model. In lpsolve_get_row_name(), row specifies the row
+    number after presolve was done. In lpsolve_aget_origrow_name(),
+    row specifies the row number before presolve was done, ie the
+    original row number. If presolve is not active then both functions
+    are equal.  Returns a Ruby string row name.
+*/
+static VALUE
+lpsolve_get_row_name(VALUE self, VALUE row_num) 
+{
+  char *psz_col_name;
+  INIT_LP;
+  if (TYPE(row_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: row number, parameter 1, is not a number.\n", __FUNCTION__);
+    return Qnil;
+  }
+  psz_col_name = get_row_name(lp, FIX2INT(row_num));
+  return psz_col_name ? rb_str_new2(psz_col_name) : Qnil;
+}
+
+/** A wrapper for get_scaling().
+
+    @param self self
+    @return A Ruby integer indicating scaling algorithm is used. 
+
+    In Ruby, you can also use accessor function scaling.
+*/
+static VALUE lpsolve_get_scaling(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_scaling)
+
+/** 
+    A wrapper for get_simplextype()
+
+    get_simplextype returns the desired combination of primal and dual
+    simplex algorithms.
+
+    The default is SIMPLEX_DUAL_PRIMAL.
+
+    In Ruby, you can also use accessor function simplextype.
+
+    @param self self
+
+    @return a Ruby integer simplex type which is one of the following
+    values:
+       \a LPSolve::SIMPLEX_PRIMAL_PRIMAL, 
+       \a LPSolve::DUAL_PRIMAL, 
+       \a LPSolve::PRIMAL_DUAL, 
+       \a LPSolve::DUAL_DUAL
+
+*/
+static VALUE lpsolve_get_simplextype(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_simplextype)
+
+/** 
+    A wrapper for get_solutioncount().
+
+    Returns the number of equal solutions. This is only valid if there
+    are integer, semi-continious or SOS variables in the model so that
+    the branch-and-bound algoritm is used. This count gives the number
+    of solutions with the same optimal objective value. If there is
+    only one optimal solution, this value is 1.
+
+    @param self self
+
+    @return the number of equal solutions to to
+    lpsolve_get_solutionlimit.
+    
+*/
+static VALUE lpsolve_get_solutioncount(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_solutioncount)
+
+/** 
+    A wrapper for get_solutionlimit().
+
+    returns the number of solutions that must be returned. 
+
+    @param self self
+
+    @return the number of solutions that must be returned.
 
     This is only valid if there are integer, semi-continious or SOS
     variables in the model so that the branch-and-bound algoritm is
@@ -1205,1313 +3790,4589 @@ LPSOLVE_0_IN_INT_OUT(get_solutioncount)
     get_solutioncount
     
 */
-static VALUE lpsolve_get_solutionlimit(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_solutionlimit)
+static VALUE lpsolve_get_solutionlimit(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_solutionlimit)
+
+/** 
+    return the status of the last solve.
+    @param self self
+    @return A return status number of the last solve.
+*/
+static VALUE lpsolve_get_status(VALUE self) 
+{
+  return rb_ivar_get(self, rb_intern("@status"));
+}
+
+/** 
+    return the early termination policy of the last solve that fired.
+    @param self self
+    @return :deadline, :gap, :stall_nodes or :stall_seconds, or nil if
+    the last lpsolve_solve() ran to the end.
+*/
+static VALUE lpsolve_get_termination(VALUE self) 
+{
+  return rb_attr_get(self, rb_intern("@termination"));
+}
+
+
+/** 
+    A wrapper for get_statustext(statuscode).
+    However statuscode need not be supplied. If it isn't we use 
+    the status code from the last solve.
+
+    @param self self
+    @param statuscode can be omitted or nil or an integer
+    @return string description of statuscode
+
+    In Ruby, you can also use accessor function statustext.
+*/
+static VALUE lpsolve_get_statustext(int argc, VALUE *argv, VALUE self)
+{
+  VALUE statuscode;
+  unsigned int i_scanned;
+  int i_statuscode;
+  INIT_LP;
+  if ((argc > 1) || (argc < 0))
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
+  i_scanned = rb_scan_args(argc, argv, "01", &statuscode);
+  switch (i_scanned) {
+  case 0: 
+    statuscode = rb_ivar_get(self, rb_intern("@status"));
+    break;
+  case 1: 
+    if (statuscode != Qnil)
+      statuscode = rb_ivar_get(self, rb_intern("@status"));
+    else if (TYPE(statuscode) != T_FIXNUM) {
+      report(lp, IMPORTANT, "%s: Parameter is not nil or an integer.\n",
+             __FUNCTION__);
+      return Qnil;
+    }
+    break;
+  default:
+    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", 
+             i_scanned);
+  }
+
+  i_statuscode = FIX2INT(statuscode);
+  if (i_statuscode == SOLVE_NOT_CALLED)
+    return rb_str_new2("LPSolve method solve() not performed yet.");
+  else
+    return rb_str_new2(get_statustext(lp, FIX2INT(statuscode)));
+}
+
+/** A wrapper for get_timeout().
+
+    @param self self
+    @return the number of seconds after which a timeout occurs.
+*/
+static VALUE lpsolve_get_timeout(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_timeout);
+
+/** A wrapper for get_timeout().
+
+    Returns the total number of iterations with Branch-and-bound of
+    the last solution.  
+
+    @param self self 
+
+    @return the total number of iterations with Branch-and-bound of
+    the last solution.  
+*/
+static VALUE lpsolve_get_total_iter(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(get_total_iter);
+
+/** A wrapper for get_upbo().
+
+   Returns the upper bound on the variable identified by column.
+   Setting a bound on a variable is the way to go instead of adding an
+   extra constraint (row) to the model. Setting a bound doesn't
+   increase the model size that means that the model stays smaller and
+   will be solved faster.  The default upper bound of a variable is
+   infinity (well not quite. It is a very big number. The value of
+   lpsolve_get_infinite().
+
+   @param self self
+
+   @param column_num the column number of the variable. It must be
+   between 1 and the number of columns in the lp.
+
+*/
+
+static VALUE lpsolve_get_upbo(VALUE self, VALUE column_num);
+LPSOLVE_1_IN_NUM_OUT(get_upbo, T_FIXNUM, "an integer", FIX2INT);
+
+/** A wrapper for get_var_branch().
+
+    @param self self
+    @param column a column number.
+    @return the branch taken first on \a column: LPSolve::BRANCH_CEILING,
+    BRANCH_FLOOR or BRANCH_AUTOMATIC; \a nil if \a column is not a
+    column number.
+*/
+static VALUE
+lpsolve_get_var_branch(VALUE self, VALUE column)
+{
+  INIT_LP;
+  if (TYPE(column) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: Parameter is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  if (!index_ok(lp, __FUNCTION__, -1, FIX2INT(column))) return Qnil;
+  return INT2FIX(get_var_branch(lp, FIX2INT(column)));
+}
+
+/** A wrapper for get_var_dualresult()
+
+    
+
+    @param self self
+    @param index index 
+
+    @return returns the reduced cost.
+
+    In contrast to get_dual_solution, the original index number is
+    preserved.
+*/
+static VALUE lpsolve_get_var_dualresult(VALUE self, VALUE index);
+LPSOLVE_1_IN_NUM_OUT(get_var_dualresult, T_FIXNUM, "an integer", FIX2INT);
+
+/** A wrapper for get_var_primalresult()
+
+    @param self self
+    @param index index 
+
+    @return the name of the specified row. A return value of NULL
+    indicates an error. The difference between lpsolve_get_row_name()
+    and lpsovle_get_origrow_name() is only visible when a presolve
+    (set_presolve) was done. Presolve can result in deletion of rows
+    in the model. In lpsolve_get_row_name(), row specifies the row
+    number after presolve was done. In lpsovle_aget_origrow_name(),
+    row specifies the row number before presolve was done, ie the
+    original row number. If presolve is not active then both functions
+    are equal.  Returns a Ruby string row name.
+
+    Retrieve the a value of the objective function, constraints and variables.
+    These values are only valid after a successful solve or lag_solve.
+
+    In contrast to get_primal_solution, the original index number is
+    preserved.
+*/
+static VALUE lpsolve_get_var_primalresult(VALUE self, VALUE index);
+LPSOLVE_1_IN_NUM_OUT(get_var_primalresult, T_FIXNUM, "an integer", FIX2INT);
+
+/** A wrapper for get_var_priority().
+
+    @param self self
+    @param column a column number.
+    @return the place of \a column in the branching order, 1 for the
+    column branched on first. Without lpsolve_set_var_weights() this is
+    the column number itself. \a nil if \a column is not a column
+    number.
+*/
+static VALUE
+lpsolve_get_var_priority(VALUE self, VALUE column)
+{
+  INIT_LP;
+  if (TYPE(column) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: Parameter is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  if (!index_ok(lp, __FUNCTION__, -1, FIX2INT(column))) return Qnil;
+  return INT2FIX(get_var_priority(lp, FIX2INT(column)));
+}
+
+/** A wrapper for get_variables().
+
+    Get the values of the variables.
+    @param self self
+    
+    @return an array of the variable values. The size of the array is 
+    the number of columns + 1. Nil is returned if there was an error.
+*/
+static VALUE
+lpsolve_get_variables(VALUE self) 
+{
+  unsigned int i_columns;
+  REAL *p_variables;
+
+  INIT_LP;
+  i_columns =  get_Ncolumns(lp);
+  
+  if (!get_ptr_variables(lp, &p_variables)) {
+    return Qnil;
+  } else {
+    VALUE ret_ary = rb_ary_new2(i_columns);
+    unsigned int i;
+    for (i=0; i<i_columns; i++) {
+      rb_ary_push(ret_ary, rb_float_new(p_variables[i]));
+    }
+    return ret_ary;
+  }
+  
+}
+
+/** A wrapper for get_verbose()
+
+    get_verbose returns the current verbose level. Can be one of the
+    following values:
+       \a LPSolve::NEUTRAL,   \a LPSolve::CRITICAL, \a LPSolve::SEVERE,
+       \a LPSolve::IMPORTANT, \a LPSolve::NORMAL,   \a LPSolve::DETAILED, or
+       \a LPSolve::FULL
+
+    How much information is reported depends on the verbose level. The
+    default verbose level is \a LPSOLVE::NORMAL. lp_solve determines
+    how verbose a given message is. For example specifying a wrong
+    row/column index values is considered as a \a LPSOLVE::SEVERE
+    error. All messages equal to and below the set level are reported.
+    The default reporting device is the console screen. It is possible
+    to set a used defined reporting routine via lpsolve_put_logfunc().
+
+    In Ruby, you can also use accessor function verbose.
+
+    @param self self
+    @return a Ruby integer verbosity level.
+
+*/
+static VALUE lpsolve_get_verbose(VALUE self);
+LPSOLVE_0_IN_INT_OUT(get_verbose)
+
+static VALUE
+lpsolve_initialize(VALUE self, VALUE num_vars, VALUE num_constraints) 
+{
+  int i_vars = NUM2INT(num_vars);
+  int i_constraints = NUM2INT(num_constraints);
+  lprec *lp = make_lp(i_vars, i_constraints);
+  DATA_PTR(self) = lp;
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  return self;
+}
+
+/** Support for dup and clone: a deep copy of the model, made with
+    copy_lp().
+
+    The copy has its own matrix, bounds, names and SOS constraints, and
+    the solver parameters are copied explicitly. If the original has
+    been solved, its final basis is given to the copy, so solving a
+    slightly changed copy starts warm. The solution itself and the
+    callbacks are not copied. A stream set with set_output_io() is
+    shared; one opened by set_outputfile() is not, and the copy prints
+    to stdout. A copy made inside a transaction is outside it.
+
+    @param self the new object
+    @param orig the object being copied
+    @return self
+*/
+static VALUE
+lpsolve_initialize_copy(VALUE self, VALUE orig)
+{
+  lprec *lp, *orig_lp;
+  int int_params[SNAP_N_INT_PARAMS];
+  REAL real_params[SNAP_N_REAL_PARAMS];
+  VALUE status;
+
+  if (self == orig) return self;
+  rb_obj_init_copy(self, orig);
+  Data_Get_Struct(orig, lprec, orig_lp);
+  if (NULL == orig_lp) 
+    rb_raise(rb_eArgError, "cannot copy an uninitialized LPSolve");
+  if (is_add_rowmode(orig_lp))
+    rb_raise(rb_eRuntimeError, "cannot copy a model in row entry mode");
+
+  lp = copy_lp(orig_lp);
+  if (NULL == lp) rb_raise(rb_eNoMemError, "copy_lp failed");
+  if (NULL != DATA_PTR(self)) delete_lp((lprec *) DATA_PTR(self));
+  DATA_PTR(self) = lp;
+
+  snapshot_get_params(orig_lp, int_params, real_params);
+  snapshot_set_params(lp, int_params, real_params);
+  set_infinite(lp, get_infinite(orig_lp));
+  lp->outstream   = orig_lp->streamowned ? stdout : orig_lp->outstream;
+  lp->streamowned = FALSE;
+
+  status = rb_ivar_get(orig, rb_intern("@status"));
+  if (FIXNUM_P(status) && SOLVE_NOT_CALLED != FIX2INT(status)) {
+    int size = 1 + get_Nrows(lp) + get_Ncolumns(lp);
+    int *bascolumn = ALLOC_N(int, size);
+    if (get_basis(orig_lp, bascolumn, TRUE))
+      set_basis(lp, bascolumn, TRUE);
+    free(bascolumn);
+  }
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  rb_ivar_set(self, rb_intern("journal"), Qnil);
+  put_logfunc(lp, NULL, NULL);
+  rb_ivar_set(self, rb_intern("logbuf"), Qnil);
+  put_msgfunc(lp, NULL, NULL, 0);
+  put_bb_nodefunc(lp, NULL, NULL);
+  put_bb_branchfunc(lp, NULL, NULL);
+  put_abortfunc(lp, NULL, NULL);
+  rb_ivar_set(self, rb_intern("msgfunc"), Qnil);
+  rb_ivar_set(self, rb_intern("bbfunc"), Qnil);
+  rb_ivar_set(self, rb_intern("abortfunc"), Qnil);
+  return self;
+}
+
+/** A wrapper for is_debug().
+
+    Returns a flag if all intermediate results and the
+    branch-and-bound decisions must be printed while solving. This
+    function is meant for debugging purposes. The default is not to
+    debug.
+
+    Returns a flag if 
+    @param self self
+
+    @return true, false, or nil on error. If true is returned, all
+    intermediate results and the branch-and-bound decisions will be
+    printed while solving.
+*/
+static VALUE lpsolve_is_debug(VALUE self);
+LPSOLVE_0_IN_BOOL_OUT(is_debug);
+
+/** A wrapper for is_maxim().
+
+    @param self self
+    @return boolean or nil on error.
+*/
+static VALUE lpsolve_is_maxim(VALUE self);
+LPSOLVE_0_IN_BOOL_OUT(is_maxim);
+
+/** A wrapper for is_SOS_var().
+
+    Returns if a variable is a SOS variable or not. By default a variable
+    is not SOS. A variable becomes a SOS variable via lpsolve_add_SOS().
+
+    @param column the column number of the variable to be checked. It
+    should be between 1 and the number of columns in the lp.
+    @param self self
+    @return boolean or nil on error.
+*/
+static VALUE lpsolve_is_SOS_var(VALUE self, VALUE column);
+LPSOLVE_1_IN_BOOL_OUT(is_SOS_var, T_FIXNUM, "an integer", FIX2INT)
+
+/** Support for Marshal.dump().
+
+    The model is saved as a binary snapshot (see lpsolve_save_binary())
+    together with the status of the last solve and, if the model has
+    been solved, the final basis. lp_solve does not let a solution be
+    set from outside, so a loaded model has no solution and its status
+    is SOLVE_NOT_CALLED; a model that was solved is given that basis,
+    so calling solve() on it again reproduces the solution without
+    further simplex iterations.
+
+    @param self self
+    @return an Array [snapshot String, status, packed basis or nil].
+*/
+static VALUE
+lpsolve_marshal_dump(VALUE self)
+{
+  VALUE snapshot = rb_str_buf_new(0);
+  VALUE status = rb_ivar_get(self, rb_intern("@status"));
+  VALUE basis = Qnil;
+  INIT_LP;
+  if (!write_model_rb(lp, snapshot_write, snapshot))
+    rb_raise(rb_eRuntimeError, "could not write the model snapshot");
+  if (FIXNUM_P(status) && SOLVE_NOT_CALLED != FIX2INT(status)) {
+    int size = 1 + get_Nrows(lp) + get_Ncolumns(lp);
+    int *bascolumn = ALLOC_N(int, size);
+    if (get_basis(lp, bascolumn, TRUE))
+      basis = rb_str_new((char *) bascolumn, size * sizeof(int));
+    free(bascolumn);
+  }
+  return rb_ary_new3(3, snapshot, NIL_P(status) ? Qnil : status, basis);
+}
+
+/** Support for Marshal.load(). Restores what lpsolve_marshal_dump()
+    saved into a newly allocated LPSolve object. The dumped status is
+    not restored: there is no solution until the next solve().
+
+    @param self self
+    @param data the Array made by lpsolve_marshal_dump().
+    @return self
+*/
+static VALUE
+lpsolve_marshal_load(VALUE self, VALUE data)
+{
+  VALUE snapshot, basis;
+  const char *psz_error;
+  lprec *lp;
+
+  Check_Type(data, T_ARRAY);
+  if (RARRAY_LEN(data) != 3)
+    rb_raise(rb_eTypeError, "marshaled LPSolve data should have 3 items");
+  snapshot = rb_ary_entry(data, 0);
+  basis    = rb_ary_entry(data, 2);
+  Check_Type(snapshot, T_STRING);
+
+  lp = snapshot_read_string(snapshot, &psz_error);
+  if (NULL == lp)
+    rb_raise(rb_eArgError, "cannot load LPSolve: %s", psz_error);
+  if (NULL != DATA_PTR(self)) delete_lp((lprec *) DATA_PTR(self));
+  DATA_PTR(self) = lp;
+
+  if (TYPE(basis) == T_STRING && RSTRING_LEN(basis) == 
+      (long) ((1 + get_Nrows(lp) + get_Ncolumns(lp)) * sizeof(int))) {
+    int *bascolumn = ALLOC_N(int, 1 + get_Nrows(lp) + get_Ncolumns(lp));
+    memcpy(bascolumn, RSTRING_PTR(basis), RSTRING_LEN(basis));
+    set_basis(lp, bascolumn, TRUE);
+    free(bascolumn);
+  }
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  return self;
+}
+
+/** Create a LPSolve object from a binary snapshot written by
+    lpsolve_save_binary().
+
+    The file is memory-mapped and the model is built directly from
+    the arrays in it, column by column, so no text is parsed. The
+    snapshot includes names, SOS constraints and solver parameters.
+
+    @param filename the snapshot file.
+
+    @return a new LPSolve object. A \a nil return value indicates an
+    error, which is reported: the file could not be read, is not a
+    valid snapshot, or was written on a machine with different integer
+    or floating-point sizes or byte order.
+*/
+static VALUE
+lpsolve_load_binary(VALUE module, VALUE filename)
+{
+  lprec *lp;
+  const char *psz_error;
+
+  if (TYPE(filename) != T_STRING) {
+    return Qnil;
+  }
+
+  lp = snapshot_load(RSTRING_PTR(filename), &psz_error);
+  if (NULL == lp) {
+    report(NULL, IMPORTANT, "%s: Cannot load %s: %s.\n",
+           __FUNCTION__, RSTRING_PTR(filename), psz_error);
+    return Qnil;
+  } else {
+    VALUE obj = lpsolve_alloc(rb_cLPSolve);
+    DATA_PTR(obj) = lp;
+    return obj;
+  }
+}
+
+/* Arguments of triplets_build(). */
+typedef struct {
+  triplets_t *p_t;
+  VALUE opts;
+} triplets_build_t;
+
+/* Convert the Array opts[key] of n numbers to a 1-based REAL vector
+   held in a Ruby String, so that it is garbage collected if we raise
+   later. Return NULL if the option was not given. */
+static REAL *
+companion_vector(VALUE opts, const char *key, int n, volatile VALUE *p_buf)
+{
+  VALUE ary = NIL_P(opts) ? Qnil : rb_hash_aref(opts, ID2SYM(rb_intern(key)));
+  REAL *p_vec;
+  int i;
+  if (NIL_P(ary)) return NULL;
+  Check_Type(ary, T_ARRAY);
+  if (RARRAY_LEN(ary) != n)
+    rb_raise(rb_eArgError, "%s: expected %d values, got %ld", key, n, 
+             RARRAY_LEN(ary));
+  *p_buf = rb_str_new(NULL, (n + 1) * sizeof(REAL));
+  p_vec = (REAL *) RSTRING_PTR(*p_buf);
+  p_vec[0] = 0.0;
+  for (i = 0; i < n; i++)
+    p_vec[i + 1] = NUM2DBL(rb_ary_entry(ary, i));
+  return p_vec;
+}
+
+/* Build an LPSolve object from the entries read by mm_read() or
+   csv_read() and the companion vectors in opts. */
+static VALUE
+triplets_build(VALUE arg)
+{
+  triplets_build_t *p_args = (triplets_build_t *) arg;
+  triplets_t *p_t = p_args->p_t;
+  VALUE opts = p_args->opts, obj, types = Qnil;
+  volatile VALUE obj_buf = Qnil, rhs_buf = Qnil, lower_buf = Qnil;
+  volatile VALUE upper_buf = Qnil;
+  REAL *p_obj, *p_rhs, *p_lower, *p_upper;
+  int rows = p_t->rows, columns = p_t->columns, i, j;
+  lprec *lp;
+
+  p_obj   = companion_vector(opts, "obj",   columns, &obj_buf);
+  p_rhs   = companion_vector(opts, "rhs",   rows,    &rhs_buf);
+  p_lower = companion_vector(opts, "lower", columns, &lower_buf);
+  p_upper = companion_vector(opts, "upper", columns, &upper_buf);
+  if (!NIL_P(opts)) types = rb_hash_aref(opts, ID2SYM(rb_intern("constr_type")));
+  if (TYPE(types) == T_ARRAY && RARRAY_LEN(types) != rows)
+    rb_raise(rb_eArgError, "constr_type: expected %d values, got %ld", rows,
+             RARRAY_LEN(types));
+  if (!NIL_P(types) && TYPE(types) != T_ARRAY) (void) NUM2INT(types);
+  for (i = 0; TYPE(types) == T_ARRAY && i < rows; i++)
+    (void) NUM2INT(rb_ary_entry(types, i));
+
+  /* Everything that can raise has been checked. */
+  obj = lpsolve_alloc(rb_cLPSolve);
+  lp = triplets_to_lp(p_t, p_obj);
+  if (NULL == lp) rb_raise(rb_eNoMemError, "not enough memory for the model");
+  DATA_PTR(obj) = lp;
+
+  for (i = 1; i <= rows; i++) {
+    if (TYPE(types) == T_ARRAY)
+      set_constr_type(lp, i, NUM2INT(rb_ary_entry(types, i - 1)));
+    else if (!NIL_P(types))
+      set_constr_type(lp, i, NUM2INT(types));
+    else
+      set_constr_type(lp, i, LE);
+  }
+  if (NULL != p_rhs) set_rh_vec(lp, p_rhs);
+  for (j = 1; j <= columns; j++) {
+    if (NULL != p_lower) set_lowbo(lp, j, p_lower[j]);
+    if (NULL != p_upper) set_upbo(lp, j, p_upper[j]);
+  }
+  if (!NIL_P(opts) && RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("maximize")))))
+    set_maxim(lp);
+  return obj;
+}
+
+static VALUE
+triplets_release(VALUE arg)
+{
+  triplets_free((triplets_t *) arg);
+  return Qnil;
+}
+
+/* Read path as Matrix Market or, if b_csv, as CSV triplets, and
+   build the model; shared by the two import functions. */
+static VALUE
+triplets_import(VALUE path, VALUE opts, MYBOOL b_csv)
+{
+  triplets_t t;
+  triplets_build_t args;
+  const char *psz_error;
+  int base = 1, rows = 0, columns = 0;
+  FILE *fp;
+
+  if (TYPE(path) != T_STRING) {
+    return Qnil;
+  }
+  if (!NIL_P(opts)) {
+    VALUE val;
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("base"))))) {
+      base = NUM2INT(val);
+      if (base < 0) rb_raise(rb_eArgError, "base must not be negative");
+    }
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("rows")))))
+      rows = NUM2INT(val);
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("columns")))))
+      columns = NUM2INT(val);
+  }
+
+  fp = model_fopen(RSTRING_PTR(path), "r");
+  if (NULL == fp) {
+    return Qnil;
+  }
+  memset(&t, 0, sizeof(t));
+  psz_error = b_csv ? csv_read(fp, &t, base) : mm_read(fp, &t);
+  fclose(fp);
+  if (NULL == psz_error && b_csv) {
+    if (rows > 0 && rows < t.rows)
+      psz_error = "an entry is beyond the given rows";
+    else if (columns > 0 && columns < t.columns)
+      psz_error = "an entry is beyond the given columns";
+    if (rows > t.rows)       t.rows    = rows;
+    if (columns > t.columns) t.columns = columns;
+  }
+  if (NULL != psz_error) {
+    triplets_free(&t);
+    rb_warning("%s: %s", RSTRING_PTR(path), psz_error);
+    return Qnil;
+  }
+
+  args.p_t  = &t;
+  args.opts = opts;
+  return rb_ensure(triplets_build, (VALUE) &args, triplets_release, (VALUE) &t);
+}
+
+/** Create a LPSolve object whose constraint matrix is read from a
+    Matrix Market coordinate file.
+
+    The file is read in one pass and the matrix is added column by
+    column, with no LP text in between. "real", "integer" and "pattern"
+    fields and "general", "symmetric" and "skew-symmetric" matrices are
+    supported; a name ending in ".gz" (or ".zst" when built with
+    Zstandard) is decompressed as it is read. Duplicate entries are
+    summed.
+
+    In Ruby:
+    \verbatim
+      LPSolve.from_matrix_market(path, obj: c, rhs: b, 
+                                 constr_type: LPSolve::LE,
+                                 lower: l, upper: u, maximize: false)
+    \endverbatim
+
+    @param argc number of arguments
+    @param argv the file name and an optional Hash of companion
+    vectors: \a :obj, \a :lower and \a :upper are Arrays with one
+    number per column, \a :rhs one per row. \a :constr_type is one
+    constraint type for all rows or an Array of them; rows are \a LE
+    by default. Set \a :maximize to maximize.
+    @param module the LPSolve class
+    @return a new LPSolve object. A \a nil return value indicates
+    that the file could not be read or is malformed (a warning says
+    why when $VERBOSE is set).
+*/
+static VALUE
+lpsolve_from_matrix_market(int argc, VALUE *argv, VALUE module)
+{
+  VALUE path, opts;
+  rb_scan_args(argc, argv, "1:", &path, &opts);
+  return triplets_import(path, opts, FALSE);
+}
+
+/** Create a LPSolve object whose constraint matrix is read from a
+    file of "row,column,value" lines.
+
+    This is like lpsolve_from_matrix_market() and takes the same
+    options, plus \a :base, the number of the first row and column
+    (1 by default), and \a :rows and \a :columns, the size of the
+    matrix if it is larger than the largest indices in the file. A
+    first line that does not start with a number is taken as a header
+    and skipped.
+
+    @param argc number of arguments
+    @param argv the file name and an optional Hash of options.
+    @param module the LPSolve class
+    @return a new LPSolve object or \a nil on error.
+*/
+static VALUE
+lpsolve_from_triplets_csv(int argc, VALUE *argv, VALUE module)
+{
+  VALUE path, opts;
+  rb_scan_args(argc, argv, "1:", &path, &opts);
+  return triplets_import(path, opts, TRUE);
+}
+
+/* Seconds on a monotonic clock, for throttling callbacks and timing
+   the rounds of the solve drivers. */
+static double
+monotonic_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* lp_solve log lines waiting to be handed to Ruby by
+   lpsolve_put_logfunc(). Lines are kept in a ring of \a capacity
+   slots and delivered together when it fills up and after each
+   solve, so Ruby is not entered once per line. Kept in the hidden
+   "logbuf" instance variable. */
+
+/** Longest log line kept; longer ones are cut short. */
+#define LOGBUF_LINE_MAX 256
+
+typedef struct {
+  VALUE self;
+  VALUE target;     /**< A Proc, a method name or an object with #add. */
+  int severity;     /**< Logger severity used with #add. */
+  int capacity;
+  int head;
+  int count;
+  long dropped;     /**< Lines lost since the last delivery. */
+  int state;        /**< Non-zero once a delivery raised. */
+  VALUE error;      /**< What it raised, to re-raise after solving. */
+  char *lines;      /**< capacity slots of LOGBUF_LINE_MAX bytes. */
+} logbuf_t;
+
+static void
+logbuf_mark(logbuf_t *p_log)
+{
+  rb_gc_mark(p_log->self);
+  rb_gc_mark(p_log->target);
+  rb_gc_mark(p_log->error);
+}
+
+static void
+logbuf_free(logbuf_t *p_log)
+{
+  free(p_log->lines);
+  free(p_log);
+}
+
+/* Hand all waiting lines to the target as one Array. Run under
+   rb_protect(), as it runs Ruby code from inside lp_solve. */
+static VALUE
+logbuf_deliver(VALUE arg)
+{
+  logbuf_t *p_log = (logbuf_t *) arg;
+  VALUE batch = rb_ary_new2(p_log->count + 1);
+  long i;
+  if (p_log->dropped > 0) {
+    rb_ary_push(batch, rb_sprintf("(%ld log lines dropped)", 
+                                  p_log->dropped));
+    p_log->dropped = 0;
+  }
+  for (; p_log->count > 0; p_log->count--) {
+    rb_ary_push(batch, rb_str_new2(p_log->lines 
+                                   + p_log->head * LOGBUF_LINE_MAX));
+    p_log->head = (p_log->head + 1) % p_log->capacity;
+  }
+  if (rb_obj_is_proc(p_log->target))
+    rb_proc_call(p_log->target, rb_ary_new3(1, batch));
+  else if (SYMBOL_P(p_log->target) || TYPE(p_log->target) == T_STRING)
+    rb_funcall(p_log->self, rb_to_id(p_log->target), 1, batch);
+  else {
+    for (i = 0; i < RARRAY_LEN(batch); i++)
+      rb_funcall(p_log->target, rb_intern("add"), 2, 
+                 INT2FIX(p_log->severity), rb_ary_entry(batch, i));
+  }
+  return Qnil;
+}
+
+/* Deliver the waiting lines unless an earlier delivery failed. */
+static void
+logbuf_drain(logbuf_t *p_log)
+{
+  int state = 0;
+  if (p_log->state || (0 == p_log->count && 0 == p_log->dropped)) return;
+  rb_protect(logbuf_deliver, (VALUE) p_log, &state);
+  if (state) {
+    p_log->state = state;
+    p_log->error = rb_errinfo();
+    rb_set_errinfo(Qnil);
+  }
+}
+
+/* Deliver what is left in the log buffer of self, if any, and
+   re-raise an exception a delivery during the last solve raised. */
+static void
+logbuf_flush(VALUE self)
+{
+  VALUE holder = rb_attr_get(self, rb_intern("logbuf"));
+  logbuf_t *p_log;
+  int state;
+  if (NIL_P(holder)) return;
+  Data_Get_Struct(holder, logbuf_t, p_log);
+  logbuf_drain(p_log);
+  if (0 != (state = p_log->state)) {
+    VALUE error = p_log->error;
+    p_log->state = 0;
+    p_log->error = Qnil;
+    rb_set_errinfo(error);
+    rb_jump_tag(state);
+  }
+}
+
+/* The log function given to lp_solve: queue the line, delivering the
+   queue when it is full. Once a delivery has failed, lines are
+   dropped until the error has been re-raised. */
+static void __WINAPI
+lpsolve_logfunction(lprec *lp, void *userhandle, char *buf)
+{
+  logbuf_t *p_log = (logbuf_t *) userhandle;
+  size_t len = strlen(buf);
+  char *p_slot;
+  if (p_log->state) return;
+  while (len > 0 && ('\n' == buf[len - 1] || '\r' == buf[len - 1])) len--;
+  if (0 == len) return;
+  if (p_log->count == p_log->capacity) {
+    p_log->head = (p_log->head + 1) % p_log->capacity;
+    p_log->count--;
+    p_log->dropped++;
+  }
+  p_slot = p_log->lines + ((p_log->head + p_log->count) % p_log->capacity)
+    * LOGBUF_LINE_MAX;
+  if (len >= LOGBUF_LINE_MAX) len = LOGBUF_LINE_MAX - 1;
+  memcpy(p_slot, buf, len);
+  p_slot[len] = '\0';
+  if (++p_log->count == p_log->capacity) logbuf_drain(p_log);
+}
+
+/**
+   Constructs a new LP. Sets all variables to initial values.  The LP
+   has rows rows and columns columns. The matrix contains no values,
+   but space for one value. All arrays that depend on rows and columns
+   are allocated.
+
+   @param class_or_model_name either the class or module name which this
+   is to belong to (it will be equal to LPSolve or LPsolve). If you are 
+   calling from Ruby, this parameter will be taken care of automatically.
+   @param num_vars number of variables or columns
+   @param num_constraints number of constraints or rows
+
+   @return nil is returned if there was an error.
+*/
+
+static VALUE
+lpsolve_make_lp(VALUE class_or_model_name, VALUE num_constraints, 
+                VALUE num_vars) 
+{
+  int i_constraints = NUM2INT(num_constraints);
+  int i_vars = NUM2INT(num_vars);
+  lprec *lp = make_lp(i_constraints, i_vars);
+  if (NULL == lp) {
+    return Qnil;
+  } else {
+    VALUE obj = lpsolve_alloc(rb_cLPSolve);
+    DATA_PTR(obj) = lp;
+    return obj;
+  }
+}
+
+/** A wrapper for print_duals(). 
+
+    @param self self
+    @return \a true unless we have an error.
+*/
+LPSOLVE_0_IN_STATUS_OUT(print_duals)
+
+/** A wrapper for print_debugdump(). 
+
+    The print_debugdump function creates a generic readable data dump
+    of key lp_solve model variables; principally for run difference and
+    debugging purposes This function is meant for debugging purposes.
+
+    @return \a true if we could write the output file.
+*/
+static VALUE lpsolve_print_debugdump(VALUE self, VALUE filename);
+LPSOLVE_1_STR_IN_BOOL_OUT(print_debugdump)
+
+/** A wrapper for print_lp. 
+
+    @param self self
+    @return \a true unless we have an error.
+*/
+static VALUE lpsolve_print_lp(VALUE self);
+LPSOLVE_0_IN_STATUS_OUT(print_lp)
+
+static VALUE lpsolve_print(VALUE self);
+void print(lprec *lp);
+LPSOLVE_0_IN_STATUS_OUT(print)
+
+void print_sparse(lprec *lp, int max_rows, int max_cols);
+
+/** Print the model by walking only its nonzeros, column by column,
+    so that the time and size of the output grow with the number of
+    nonzeros rather than with rows times columns. Only the first
+    max_rows rows and max_cols columns are listed; summary statistics
+    cover the whole model. The output goes where print_lp's does.
+
+    @param self self
+    @param max_rows number of rows to list; omitted or nil for all.
+    @param max_cols number of columns to list; omitted or nil for all.
+    @return \a true unless we have an error.
+*/
+static VALUE 
+lpsolve_print_sparse(int argc, VALUE *argv, VALUE self) 
+{
+  VALUE max_rows, max_cols;
+  int i_max_rows, i_max_cols;
+  INIT_LP;
+  rb_scan_args(argc, argv, "02", &max_rows, &max_cols);
+  if ((!NIL_P(max_rows) && TYPE(max_rows) != T_FIXNUM) 
+      || (!NIL_P(max_cols) && TYPE(max_cols) != T_FIXNUM)) {
+    report(lp, IMPORTANT, "%s: Parameters must be nil or integers.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
+  i_max_rows = NIL_P(max_rows) ? get_Nrows(lp)    : FIX2INT(max_rows);
+  i_max_cols = NIL_P(max_cols) ? get_Ncolumns(lp) : FIX2INT(max_cols);
+  print_sparse(lp, i_max_rows, i_max_cols);
+  return Qtrue;
+}
+
+/** A wrapper for print_constraints. 
+    @param self self
+    @param num constraint number.
+    @return \a true unless we have an error.
+*/
+static VALUE lpsolve_print_constraints(VALUE self, VALUE num);
+LPSOLVE_1_IN_STATUS_OUT(print_constraints, FIX2INT(param1));
+
+/** A wrapper for put_logfunc().
+
+    Routes lp_solve's log messages to Ruby instead of stdout. Messages
+    are queued in a native buffer and handed over \a batch lines at a
+    time, and whatever is left at the end of each solve(), so Ruby is
+    not entered once per line; call lpsolve_flush_log() to deliver
+    lines logged outside solve(). If the receiver raises, the error is
+    re-raised when solve() returns and later lines are dropped until
+    then. Methods that solve repeatedly, such as
+    sweep_rhs() or solve_with_cuts(), stop at that solve and put the
+    model back as they would have at the end before re-raising.
+
+    lp_solve does not tell the log function how important a message
+    is; it filters messages against the verbosity instead, so \a level
+    is handed to set_verbose().
+
+    @param self self
+    @param target where the lines go: a block or Proc, called with an
+    Array of lines; the name of a method of self, e.g. "puts", called
+    the same way; or a Logger, or anything with add(severity, message),
+    called once per line. \a nil turns logging to Ruby off.
+    @param level if given, the verbosity to log at, e.g.
+    LPSolve::DETAILED.
+    @param batch how many lines to queue before delivering them, 64 by
+    default.
+    @param severity the severity passed to add(), Logger::INFO (1) by
+    default.
+    @return nil.
+*/
+static VALUE
+lpsolve_put_logfunc(int argc, VALUE *argv, VALUE self) 
+{
+  VALUE target, opts, block, val, holder;
+  logbuf_t *p_log;
+  int capacity = 64, severity = 1;
+
+  INIT_LP;
+  rb_scan_args(argc, argv, "01:&", &target, &opts, &block);
+  if (!NIL_P(block)) target = block;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("batch")))))
+      capacity = NUM2INT(val);
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("severity")))))
+      severity = NUM2INT(val);
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("level")))))
+      set_verbose(lp, NUM2INT(val));
+  }
+  if (capacity < 1) rb_raise(rb_eArgError, "batch must be positive");
+  if (!NIL_P(target) && !rb_obj_is_proc(target) && !SYMBOL_P(target)
+      && TYPE(target) != T_STRING 
+      && !rb_respond_to(target, rb_intern("add")))
+    rb_raise(rb_eTypeError, 
+             "log target must be a block, a method name or a Logger");
+
+  /* Deliver what the previous target still has waiting. */
+  logbuf_flush(self);
+  if (NIL_P(target)) {
+    put_logfunc(lp, NULL, NULL);
+    rb_ivar_set(self, rb_intern("logbuf"), Qnil);
+    return Qnil;
+  }
+
+  p_log = ALLOC(logbuf_t);
+  memset(p_log, 0, sizeof(logbuf_t));
+  p_log->self = self;
+  p_log->target = target;
+  p_log->error = Qnil;
+  p_log->severity = severity;
+  p_log->capacity = capacity;
+  holder = Data_Wrap_Struct(0, logbuf_mark, logbuf_free, p_log);
+  p_log->lines = ALLOC_N(char, (size_t) capacity * LOGBUF_LINE_MAX);
+  rb_ivar_set(self, rb_intern("logbuf"), holder);
+  put_logfunc(lp, lpsolve_logfunction, p_log);
+  return Qnil;
+}
+
+/** Deliver the log lines still queued by lpsolve_put_logfunc().
+
+    @param self self
+    @return nil.
+*/
+static VALUE
+lpsolve_flush_log(VALUE self)
+{
+  logbuf_flush(self);
+  return Qnil;
+}
+
+/* Ruby blocks steering branch-and-bound, given to put_bb_nodefunc()
+   and put_bb_branchfunc(). Kept in the hidden "bbfunc" instance
+   variable. */
+typedef struct {
+  VALUE node_block;     /**< Picks the column to branch on, or nil. */
+  VALUE branch_block;   /**< Picks the branch taken first, or nil. */
+  lprec *lp;
+  int arg;              /**< vartype or column of the current call. */
+  int state;            /**< Non-zero once a block raised. */
+  VALUE error;
+} bbfunc_t;
+
+static void
+bbfunc_mark(bbfunc_t *p_bb)
+{
+  rb_gc_mark(p_bb->node_block);
+  rb_gc_mark(p_bb->branch_block);
+  rb_gc_mark(p_bb->error);
+}
+
+/* Call the node block with the column values of the node's relaxation
+   and return the column it picked, or nil. */
+static VALUE
+bbfunc_node(VALUE arg)
+{
+  bbfunc_t *p_bb = (bbfunc_t *) arg;
+  lprec *lp = p_bb->lp;
+  VALUE x = rb_str_new(NULL, lp->columns * sizeof(double));
+  VALUE column;
+  int j;
+  for (j = 0; j < lp->columns; j++) 
+    ((double *) RSTRING_PTR(x))[j] = lp->solution[lp->rows + 1 + j];
+  column = rb_proc_call(p_bb->node_block, 
+                        rb_ary_new3(2, x, INT2FIX(p_bb->arg)));
+  if (NIL_P(column)) return Qnil;
+  j = NUM2INT(column);
+  if (j < 1 || j > lp->columns) 
+    rb_raise(rb_eArgError, "branching column %d out of range", j);
+  return INT2FIX(j);
+}
+
+/* Call the branch block and return true to take the ceiling branch
+   first. */
+static VALUE
+bbfunc_branch(VALUE arg)
+{
+  bbfunc_t *p_bb = (bbfunc_t *) arg;
+  VALUE dir = rb_proc_call(p_bb->branch_block, 
+                           rb_ary_new3(1, INT2FIX(p_bb->arg)));
+  if (FIXNUM_P(dir)) return BRANCH_CEILING == FIX2INT(dir) ? Qtrue : Qfalse;
+  return RTEST(dir) ? Qtrue : Qfalse;
+}
+
+/* Run fn on behalf of lp_solve, remembering what it raised. */
+static VALUE
+bbfunc_call(bbfunc_t *p_bb, lprec *lp, VALUE (*fn)(VALUE), int arg)
+{
+  VALUE ret;
+  int state = 0;
+  p_bb->lp  = lp;
+  p_bb->arg = arg;
+  ret = rb_protect(fn, (VALUE) p_bb, &state);
+  if (state) {
+    p_bb->state = state;
+    p_bb->error = rb_errinfo();
+    rb_set_errinfo(Qnil);
+    return Qnil;
+  }
+  return ret;
+}
+
+/* The node selection function given to lp_solve: the column to branch
+   on, or -1 for lp_solve's own choice. */
+static int __WINAPI
+lpsolve_nodefunction(lprec *lp, void *userhandle, int vartype)
+{
+  bbfunc_t *p_bb = (bbfunc_t *) userhandle;
+  VALUE column;
+  if (p_bb->state || NIL_P(p_bb->node_block)) return -1;
+  column = bbfunc_call(p_bb, lp, bbfunc_node, vartype);
+  return NIL_P(column) ? -1 : FIX2INT(column);
+}
+
+/* The branch direction function given to lp_solve: TRUE to take the
+   ceiling branch first. */
+static MYBOOL __WINAPI
+lpsolve_branchfunction(lprec *lp, void *userhandle, int column)
+{
+  bbfunc_t *p_bb = (bbfunc_t *) userhandle;
+  if (p_bb->state || NIL_P(p_bb->branch_block))
+    return BRANCH_CEILING == get_floorfirst(lp);
+  return Qtrue == bbfunc_call(p_bb, lp, bbfunc_branch, column);
+}
+
+/* The branching state of self, created on first use. */
+static bbfunc_t *
+bbfunc_holder(VALUE self)
+{
+  VALUE holder = rb_attr_get(self, rb_intern("bbfunc"));
+  bbfunc_t *p_bb;
+  if (NIL_P(holder)) {
+    p_bb = ALLOC(bbfunc_t);
+    memset(p_bb, 0, sizeof(bbfunc_t));
+    p_bb->node_block   = Qnil;
+    p_bb->branch_block = Qnil;
+    p_bb->error        = Qnil;
+    holder = Data_Wrap_Struct(0, bbfunc_mark, free, p_bb);
+    rb_ivar_set(self, rb_intern("bbfunc"), holder);
+  }
+  Data_Get_Struct(holder, bbfunc_t, p_bb);
+  return p_bb;
+}
+
+/* Progress events of put_msgfunc(), throttled natively. The latest
+   event is captured into the fields below each time lp_solve reports
+   one, and handed to the block at most once per \a interval seconds;
+   one still waiting when solve() returns is delivered then. Kept in
+   the hidden "msgfunc" instance variable. */
+typedef struct {
+  VALUE block;
+  double interval;
+  double last;          /**< When the last event was delivered. */
+  MYBOOL b_incumbent;   /**< Include the incumbent in MILP events. */
+  MYBOOL b_pending;     /**< An event is waiting to be delivered. */
+  int msg;
+  REAL objective;
+  REAL bound;
+  REAL elapsed;
+  long long nodes;
+  REAL *incumbent;      /**< n_incumbent values, or none. */
+  int n_incumbent;
+  int cap_incumbent;
+  int state;            /**< Non-zero once the block raised. */
+  VALUE error;
+} msgfunc_t;
+
+static void
+msgfunc_mark(msgfunc_t *p_msg)
+{
+  rb_gc_mark(p_msg->block);
+  rb_gc_mark(p_msg->error);
+}
+
+static void
+msgfunc_free(msgfunc_t *p_msg)
+{
+  free(p_msg->incumbent);
+  free(p_msg);
+}
+
+/* Call the block with the waiting event as a Hash. */
+static VALUE
+msgfunc_deliver(VALUE arg)
+{
+  msgfunc_t *p_msg = (msgfunc_t *) arg;
+  VALUE event = rb_hash_new();
+  p_msg->b_pending = FALSE;
+  rb_hash_aset(event, ID2SYM(rb_intern("type")), INT2FIX(p_msg->msg));
+  rb_hash_aset(event, ID2SYM(rb_intern("objective")), 
+               rb_float_new(p_msg->objective));
+  rb_hash_aset(event, ID2SYM(rb_intern("bound")), 
+               rb_float_new(p_msg->bound));
+  rb_hash_aset(event, ID2SYM(rb_intern("elapsed")), 
+               rb_float_new(p_msg->elapsed));
+  rb_hash_aset(event, ID2SYM(rb_intern("nodes")), LL2NUM(p_msg->nodes));
+  if (p_msg->n_incumbent > 0) {
+    VALUE incumbent = rb_str_new(NULL, p_msg->n_incumbent * sizeof(double));
+    int j;
+    for (j = 0; j < p_msg->n_incumbent; j++) 
+      ((double *) RSTRING_PTR(incumbent))[j] = p_msg->incumbent[j];
+    rb_hash_aset(event, ID2SYM(rb_intern("incumbent")), incumbent);
+  }
+  rb_proc_call(p_msg->block, rb_ary_new3(1, event));
+  return Qnil;
+}
+
+/** The early termination policy of lpsolve_solve() that fired. */
+typedef enum {
+  POLICY_NONE,
+  POLICY_DEADLINE,
+  POLICY_GAP,
+  POLICY_STALL_NODES,
+  POLICY_STALL_SECONDS
+} policy_t;
+
+/* What the abort function given to lp_solve checks: the state of the
+   Ruby callbacks, so solving stops once one of them has raised, and
+   the early termination policies given to lpsolve_solve(). Kept in
+   the hidden "abortfunc" instance variable, and registered with
+   lp_solve when first needed. */
+typedef struct {
+  msgfunc_t *p_msg;     /**< The put_msgfunc() state, or NULL. */
+  bbfunc_t *p_bb;       /**< The put_bb_*func() state, or NULL. */
+  MYBOOL b_policy;      /**< Policies apply to the running solve. */
+  double deadline;      /**< When to stop, or HUGE_VAL. */
+  REAL gap;             /**< Relative gap to stop at, or < 0. */
+  long long stall_nodes;  /**< Nodes without improvement, or <= 0. */
+  double stall_seconds;   /**< Seconds without improvement, or <= 0. */
+  MYBOOL b_incumbent;   /**< An incumbent has been seen. */
+  REAL incumbent;       /**< Its objective value. */
+  long long improved_nodes; /**< Node count when it last improved. */
+  double improved;      /**< When it last improved. */
+  policy_t fired;
+} abortfunc_t;
+
+/* Check the early termination policies, tracking when the incumbent
+   last improved. */
+static MYBOOL
+abortfunc_policy(lprec *lp, abortfunc_t *p_abort)
+{
+  double now = monotonic_seconds();
+  REAL objective;
+  long long nodes;
+
+  if (now >= p_abort->deadline) {
+    p_abort->fired = POLICY_DEADLINE;
+    return TRUE;
+  }
+  if (get_solutioncount(lp) < 1) return FALSE;
+
+  objective = get_working_objective(lp);
+  nodes = get_total_nodes(lp);
+  if (!p_abort->b_incumbent || objective != p_abort->incumbent) {
+    p_abort->b_incumbent    = TRUE;
+    p_abort->incumbent      = objective;
+    p_abort->improved_nodes = nodes;
+    p_abort->improved       = now;
+  }
+  if (p_abort->gap >= 0 && fabs(objective - lp->bb_limitOF) 
+      <= p_abort->gap * (1.0 + fabs(objective)))
+    p_abort->fired = POLICY_GAP;
+  else if (p_abort->stall_nodes > 0 
+           && nodes - p_abort->improved_nodes >= p_abort->stall_nodes)
+    p_abort->fired = POLICY_STALL_NODES;
+  else if (p_abort->stall_seconds > 0 
+           && now - p_abort->improved >= p_abort->stall_seconds)
+    p_abort->fired = POLICY_STALL_SECONDS;
+  return POLICY_NONE != p_abort->fired;
+}
+
+/* The abort function given to lp_solve. */
+static int __WINAPI
+lpsolve_abortfunction(lprec *lp, void *userhandle)
+{
+  abortfunc_t *p_abort = (abortfunc_t *) userhandle;
+  if ((NULL != p_abort->p_msg && 0 != p_abort->p_msg->state)
+      || (NULL != p_abort->p_bb && 0 != p_abort->p_bb->state))
+    return TRUE;
+  return p_abort->b_policy && abortfunc_policy(lp, p_abort);
+}
+
+/* The abort state of self, created and registered on first use. */
+static abortfunc_t *
+abortfunc_holder(VALUE self, lprec *lp)
+{
+  VALUE holder = rb_attr_get(self, rb_intern("abortfunc"));
+  abortfunc_t *p_abort;
+  if (NIL_P(holder)) {
+    p_abort = ALLOC(abortfunc_t);
+    memset(p_abort, 0, sizeof(abortfunc_t));
+    p_abort->deadline = HUGE_VAL;
+    holder = Data_Wrap_Struct(0, 0, free, p_abort);
+    rb_ivar_set(self, rb_intern("abortfunc"), holder);
+    put_abortfunc(lp, lpsolve_abortfunction, p_abort);
+  }
+  Data_Get_Struct(holder, abortfunc_t, p_abort);
+  return p_abort;
+}
+
+/* The message function given to lp_solve. */
+static void __WINAPI
+lpsolve_msgfunction(lprec *lp, void *userhandle, int msg)
+{
+  msgfunc_t *p_msg = (msgfunc_t *) userhandle;
+  double now;
+  int state = 0;
+  if (p_msg->state) return;
+
+  p_msg->msg       = msg;
+  p_msg->objective = get_working_objective(lp);
+  p_msg->bound     = lp->bb_limitOF;
+  p_msg->elapsed   = time_elapsed(lp);
+  p_msg->nodes     = get_total_nodes(lp);
+  p_msg->n_incumbent = 0;
+  if (p_msg->b_incumbent 
+      && 0 != (msg & (MSG_MILPFEASIBLE | MSG_MILPEQUAL | MSG_MILPBETTER))) {
+    if (p_msg->cap_incumbent < lp->columns) {
+      REALLOC_N(p_msg->incumbent, REAL, lp->columns);
+      p_msg->cap_incumbent = lp->columns;
+    }
+    memcpy(p_msg->incumbent, lp->best_solution + lp->rows + 1,
+           lp->columns * sizeof(REAL));
+    p_msg->n_incumbent = lp->columns;
+  }
+  p_msg->b_pending = TRUE;
+
+  now = monotonic_seconds();
+  if (now - p_msg->last < p_msg->interval) return;
+  p_msg->last = now;
+  rb_protect(msgfunc_deliver, (VALUE) p_msg, &state);
+  if (state) {
+    p_msg->state = state;
+    p_msg->error = rb_errinfo();
+    rb_set_errinfo(Qnil);
+  }
+}
+
+/* The first error a Ruby callback raised during a native solve, kept
+   to be re-raised once the caller has put the model back in order. */
+typedef struct {
+  int state;
+  VALUE error;
+} callback_error_t;
+
+/* Move the error in *p_state and *p_error, if any, to p_err unless it
+   already holds an earlier one, and clear them. */
+static void
+callback_error_take(callback_error_t *p_err, int *p_state, VALUE *p_error)
+{
+  if (0 != *p_state && 0 == p_err->state) {
+    p_err->state = *p_state;
+    p_err->error = *p_error;
+  }
+  *p_state = 0;
+  *p_error = Qnil;
+}
+
+/* After a native solve: deliver what the callbacks of self still have
+   waiting and move what they raised to p_err. Every callback state is
+   cleared, so the next solve starts clean. */
+static void
+callbacks_collect(VALUE self, callback_error_t *p_err)
+{
+  VALUE holder = rb_attr_get(self, rb_intern("logbuf"));
+  if (!NIL_P(holder)) {
+    logbuf_t *p_log;
+    Data_Get_Struct(holder, logbuf_t, p_log);
+    logbuf_drain(p_log);
+    callback_error_take(p_err, &p_log->state, &p_log->error);
+  }
+  holder = rb_attr_get(self, rb_intern("msgfunc"));
+  if (!NIL_P(holder)) {
+    msgfunc_t *p_msg;
+    Data_Get_Struct(holder, msgfunc_t, p_msg);
+    /* An event held back by the throttle is delivered now. */
+    p_msg->last = 0;
+    if (p_msg->b_pending && 0 == p_msg->state) {
+      rb_protect(msgfunc_deliver, (VALUE) p_msg, &p_msg->state);
+      if (p_msg->state) {
+        p_msg->error = rb_errinfo();
+        rb_set_errinfo(Qnil);
+      }
+    }
+    p_msg->b_pending = FALSE;
+    callback_error_take(p_err, &p_msg->state, &p_msg->error);
+  }
+  holder = rb_attr_get(self, rb_intern("bbfunc"));
+  if (!NIL_P(holder)) {
+    bbfunc_t *p_bb;
+    Data_Get_Struct(holder, bbfunc_t, p_bb);
+    callback_error_take(p_err, &p_bb->state, &p_bb->error);
+  }
+}
+
+/* Re-raise the error callbacks_collect() kept, if any. */
+static void
+callbacks_raise(callback_error_t *p_err)
+{
+  if (0 != p_err->state) {
+    rb_set_errinfo(p_err->error);
+    rb_jump_tag(p_err->state);
+  }
+}
+
+/* solve() for every method that solves: run lp_solve, then collect
+   what the callbacks raised into p_err. A caller solving repeatedly
+   stops once p_err->state is set, tidies up and calls
+   callbacks_raise(). */
+static int
+callbacks_solve(VALUE self, lprec *lp, callback_error_t *p_err)
+{
+  int status = solve(lp);
+  callbacks_collect(self, p_err);
+  return status;
+}
+
+/** A wrapper for put_msgfunc().
+
+    Calls the block with the solver's progress events while solve()
+    runs, e.g. to stream improved MIP solutions or to decide whether
+    to stop early. Each event is a Hash with :type (the LPSolve::MSG_*
+    value), :objective (the best objective found), :bound (the bound
+    on the final MIP objective), :elapsed (seconds since solve started)
+    and :nodes (branch-and-bound nodes so far), plus :incumbent, the
+    value of each column as a String of packed native doubles, for MIP
+    solution events when asked for.
+
+    Events are throttled in native code: the block is called at most
+    once per \a interval seconds with the latest event, and the last
+    event is delivered when solve() returns if it was held back. If
+    the block raises, solving is aborted and the exception re-raised
+    from solve(), or from whichever method was solving, e.g.
+    sweep_obj(), once it has put the model back.
+
+    @param self self
+    @param mask the events wanted, LPSolve::MSG_* values or'ed
+    together; all of PRESOLVE, LPFEASIBLE, LPOPTIMAL, MILPFEASIBLE,
+    MILPEQUAL and MILPBETTER by default. Without a block, stop
+    reporting events.
+    @param interval the least number of seconds between calls, 0.1 by
+    default; 0 delivers every event.
+    @param incumbent if \a true, add :incumbent to MIP solution events.
+    @return nil.
+*/
+static VALUE
+lpsolve_put_msgfunc(int argc, VALUE *argv, VALUE self)
+{
+  VALUE mask, opts, block, val, holder;
+  msgfunc_t *p_msg;
+  int i_mask = MSG_PRESOLVE | MSG_LPFEASIBLE | MSG_LPOPTIMAL 
+    | MSG_MILPFEASIBLE | MSG_MILPEQUAL | MSG_MILPBETTER;
+
+  INIT_LP;
+  rb_scan_args(argc, argv, "01:&", &mask, &opts, &block);
+  if (NIL_P(block)) {
+    put_msgfunc(lp, NULL, NULL, 0);
+    abortfunc_holder(self, lp)->p_msg = NULL;
+    rb_ivar_set(self, rb_intern("msgfunc"), Qnil);
+    return Qnil;
+  }
+  if (!NIL_P(mask)) i_mask = NUM2INT(mask);
+
+  p_msg = ALLOC(msgfunc_t);
+  memset(p_msg, 0, sizeof(msgfunc_t));
+  p_msg->block = block;
+  p_msg->error = Qnil;
+  p_msg->interval = 0.1;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("interval")))))
+      p_msg->interval = NUM2DBL(val);
+    p_msg->b_incumbent = 
+      RTEST(rb_hash_aref(opts, ID2SYM(rb_intern("incumbent"))));
+  }
+  holder = Data_Wrap_Struct(0, msgfunc_mark, msgfunc_free, p_msg);
+  rb_ivar_set(self, rb_intern("msgfunc"), holder);
+  put_msgfunc(lp, lpsolve_msgfunction, p_msg, i_mask);
+  abortfunc_holder(self, lp)->p_msg = p_msg;
+  return Qnil;
+}
+
+/** A wrapper for put_bb_branchfunc().
+
+    Lets the block choose which branch of a branching column
+    branch-and-bound explores first, instead of the one direction set
+    with set_floorfirst() or lpsolve_set_var_branch(). The block is
+    called with the column number and returns \a true or
+    LPSolve::BRANCH_CEILING for the ceiling branch, \a false or
+    LPSolve::BRANCH_FLOOR for the floor branch. If the block raises,
+    solving is aborted and the exception re-raised from solve().
+
+    @param self self
+    @return nil. Without a block, go back to lp_solve's own choice.
+*/
+static VALUE
+lpsolve_put_bb_branchfunc(VALUE self)
+{
+  bbfunc_t *p_bb;
+  INIT_LP;
+  p_bb = bbfunc_holder(self);
+  p_bb->branch_block = rb_block_given_p() ? rb_block_proc() : Qnil;
+  if (NIL_P(p_bb->branch_block)) {
+    put_bb_branchfunc(lp, NULL, NULL);
+  } else {
+    put_bb_branchfunc(lp, lpsolve_branchfunction, p_bb);
+    abortfunc_holder(self, lp)->p_bb = p_bb;
+  }
+  return Qnil;
+}
+
+/** A wrapper for put_bb_nodefunc().
+
+    Lets the block choose the column branch-and-bound branches on,
+    instead of the NODE_* rule set with set_bb_rule(). At each node
+    the block is called with the column values of the node's LP
+    relaxation, as a String of packed native doubles, and the kind of
+    variable to branch on (LPSolve::BB_INT, BB_SC or BB_SOS), and
+    returns a column number, or \a nil for lp_solve's own choice. If
+    the block raises, solving is aborted and the exception re-raised
+    from solve(), or from whichever method was solving. Column numbers are those of the model after
+    presolve, if any.
+
+    Calling into Ruby at every node has a price; when the branching
+    order is known beforehand, give it to lp_solve once with
+    lpsolve_set_var_weights() instead.
+
+    @param self self
+    @return nil. Without a block, go back to set_bb_rule().
+*/
+static VALUE
+lpsolve_put_bb_nodefunc(VALUE self)
+{
+  bbfunc_t *p_bb;
+  INIT_LP;
+  p_bb = bbfunc_holder(self);
+  p_bb->node_block = rb_block_given_p() ? rb_block_proc() : Qnil;
+  if (NIL_P(p_bb->node_block)) {
+    put_bb_nodefunc(lp, NULL, NULL);
+  } else {
+    put_bb_nodefunc(lp, lpsolve_nodefunction, p_bb);
+    abortfunc_holder(self, lp)->p_bb = p_bb;
+  }
+  return Qnil;
+}
+
+/** A wrapper for print_objective. 
+    @return nil.
+*/
+LPSOLVE_0_IN_STATUS_OUT(print_objective)
+
+/** A wrapper for print_tableau(). 
+
+    The print_tableau function prints the tableau. This function only
+    works after a successful solve This function is meant for
+    debugging purposes. By default, the output is stdout. However this
+    can be changed via a call to set_outputstream, set_outputfile.
+
+    @param self self
+    @return \a true unless we have an error.
+*/
+LPSOLVE_0_IN_STATUS_OUT(print_tableau)
+
+/** A wrapper for read_LP. 
+
+  Create a LPSolve object and read an lp model from file. A file
+  whose name ends in ".gz" (or ".zst" when built with Zstandard) is
+  decompressed as it is read; NotImplementedError is raised when this
+  build lacks the library needed for that.
+
+  When the model cache is on (see lpsolve_set_model_cache_dir()), an
+  unchanged file that has been read before is loaded from its cached
+  binary snapshot instead of being parsed again.
+
+  Returns anew LPSolve object. A Nil return value indicates an
+  error. Specifically file could not be opened or file has wrong
+  structure or not enough memory available to setup an lprec
+  structure.
+
+*/
+static VALUE
+lpsolve_read_LP(VALUE model, VALUE filename, VALUE verbosity, 
+                VALUE model_name) 
+{
+  lprec *lp;
+
+  if (TYPE(filename) != T_STRING) {
+    return Qnil;
+  }
+  
+  if (TYPE(verbosity) != T_FIXNUM) {
+    return Qnil;
+  }
+  
+  if (TYPE(model_name) != T_STRING) {
+      return Qnil;
+  }
+  
+  lp = read_model_cached(filename, MODEL_LP, FIX2INT(verbosity),
+                         RSTRING_PTR(model_name));
+  if (NULL == lp) {
+    return Qnil;
+  } else {
+    VALUE obj = lpsolve_alloc(rb_cLPSolve);
+    DATA_PTR(obj) = lp;
+    return obj;
+  }
+}
+
+/** A wrapper for read_MPS.
+
+  Create a LPSolve object and read an MPS model from a file. A file
+  whose name ends in ".gz" (or ".zst" when built with Zstandard) is
+  decompressed as it is read; NotImplementedError is raised when this
+  build lacks the library needed for that.
+
+  When the model cache is on (see lpsolve_set_model_cache_dir()), an
+  unchanged file that has been read before is loaded from its cached
+  binary snapshot instead of being parsed again.
+
+  Returns a new LPSolve Object. A Nil return value indicates an
+  error. Specifically file could not be opened or file has wrong
+  structure or not enough memory available to setup an lprec
+  structure.
+
+*/
+static VALUE
+lpsolve_read_MPS(VALUE module, VALUE filename, VALUE verbosity) 
+{
+  lprec *lp;
+
+  if (TYPE(filename) != T_STRING) {
+    return Qnil;
+  }
+  
+  if (TYPE(verbosity) != T_FIXNUM) {
+      return Qnil;
+  }
+  
+  lp = read_model_cached(filename, MODEL_MPS, FIX2INT(verbosity), NULL);
+  if (NULL == lp) {
+    return Qnil;
+  } else {
+    VALUE obj = lpsolve_alloc(rb_cLPSolve);
+    DATA_PTR(obj) = lp;
+    return obj;
+  }
+}
+
+/* State shared by the threads of read_many(). Nothing here is a Ruby
+   object: the threads run without the GVL. */
+typedef struct {
+  char **paths;
+  int n;
+  model_format_t format;
+  int verbosity;
+  lprec **results;
+  int *errors;         /**< errno of a file that could not be opened. */
+  int n_threads;
+  int next;            /**< Index of the next path to parse. */
+  volatile int interrupted;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
+} read_many_t;
+
+#ifdef HAVE_PTHREAD_H
+/* The LP-format parser of lp_solve 5.5 is generated by yacc and lex
+   and keeps its state in globals, and lp_solve does not promise that
+   its MPS reader is reentrant either, so only one file is parsed at a
+   time. */
+static pthread_mutex_t parser_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#ifdef HAVE_COOKIE_STREAMS
+/* A model file read into memory by a read_many() thread, so that
+   only the parse needs parser_lock. */
+typedef struct {
+  char *data;
+  size_t size;
+  size_t pos;
+} memfile_t;
+
+static long
+memfile_read(void *cookie, char *buf, long size)
+{
+  memfile_t *p_mem = (memfile_t *) cookie;
+  size_t n = p_mem->size - p_mem->pos;
+  if ((size_t) size < n) n = (size_t) size;
+  memcpy(buf, p_mem->data + p_mem->pos, n);
+  p_mem->pos += n;
+  return (long) n;
+}
+
+static const cookie_funcs_t memfile_funcs = {memfile_read, NULL, NULL};
+
+/* Read all of filename into p_mem, decompressing it as model_fopen()
+   does. Returns FALSE if it could not be opened or read. */
+static MYBOOL
+memfile_load(const char *filename, memfile_t *p_mem)
+{
+  FILE *fp = model_fopen(filename, "r");
+  size_t capacity = LPSOLVE_STREAM_BUFSIZE, n;
+  MYBOOL b_ok = TRUE;
+  p_mem->data = NULL;
+  p_mem->size = p_mem->pos = 0;
+  if (NULL == fp) return FALSE;
+  for (;;) {
+    if (NULL == p_mem->data || p_mem->size == capacity) {
+      char *p_new;
+      if (NULL != p_mem->data) capacity *= 2;
+      p_new = realloc(p_mem->data, capacity);
+      if (NULL == p_new) {
+        b_ok = FALSE;
+        break;
+      }
+      p_mem->data = p_new;
+    }
+    n = fread(p_mem->data + p_mem->size, 1, capacity - p_mem->size, fp);
+    if (0 == n) break;
+    p_mem->size += n;
+  }
+  if (ferror(fp)) b_ok = FALSE;
+  fclose(fp);
+  if (!b_ok) {
+    free(p_mem->data);
+    p_mem->data = NULL;
+  }
+  return b_ok;
+}
+#endif
+
+static void *
+read_many_worker(void *arg)
+{
+  read_many_t *p_rm = (read_many_t *) arg;
+  for (;;) {
+    int i = -1;
+    /* Only take a path when not interrupted, so that none is skipped
+       when read_many() carries on afterwards. */
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&p_rm->lock);
+    if (!p_rm->interrupted) i = p_rm->next++;
+    pthread_mutex_unlock(&p_rm->lock);
+#else
+    if (!p_rm->interrupted) i = p_rm->next++;
+#endif
+    if (i < 0 || i >= p_rm->n) break;
+    if (0 != access(p_rm->paths[i], R_OK)) {
+      p_rm->errors[i] = errno;
+      continue;
+    }
+#ifdef HAVE_COOKIE_STREAMS
+    {
+      /* Read and decompress in parallel; only the parse is locked. */
+      memfile_t mem;
+      FILE *fp;
+      if (!memfile_load(p_rm->paths[i], &mem)) continue;
+#ifdef HAVE_PTHREAD_H
+      pthread_mutex_lock(&parser_lock);
+#endif
+      fp = cookie_fopen(&mem, "r", &memfile_funcs);
+      if (NULL != fp) {
+        p_rm->results[i] = parse_model(fp, p_rm->format, p_rm->verbosity,
+                                       NULL);
+        fclose(fp);
+      }
+#ifdef HAVE_PTHREAD_H
+      pthread_mutex_unlock(&parser_lock);
+#endif
+      free(mem.data);
+    }
+#else
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_lock(&parser_lock);
+#endif
+    p_rm->results[i] = read_model(p_rm->paths[i], p_rm->format,
+                                  p_rm->verbosity, NULL);
+#ifdef HAVE_PTHREAD_H
+    pthread_mutex_unlock(&parser_lock);
+#endif
+#endif
+  }
+  return NULL;
+}
+
+/* Run read_many_worker() on up to n_threads threads, this one
+   included. */
+static void *
+read_many_nogvl(void *arg)
+{
+  read_many_t *p_rm = (read_many_t *) arg;
+#ifdef HAVE_PTHREAD_H
+  int n_threads = p_rm->n_threads, n_started = 0, t;
+  pthread_t *threads = malloc(sizeof(pthread_t) * n_threads);
+  if (NULL != threads)
+    for (t = 1; t < n_threads; t++) {
+      if (0 != pthread_create(&threads[n_started], NULL, 
+                              read_many_worker, p_rm))
+        break;
+      n_started++;
+    }
+  read_many_worker(p_rm);
+  for (t = 0; t < n_started; t++)
+    pthread_join(threads[t], NULL);
+  free(threads);
+#else
+  read_many_worker(p_rm);
+#endif
+  return NULL;
+}
+
+static void
+read_many_ubf(void *arg)
+{
+  ((read_many_t *) arg)->interrupted = 1;
+}
+
+static VALUE
+read_many_check_ints(VALUE unused)
+{
+  rb_thread_check_ints();
+  return Qnil;
+}
+
+/* Release what read_many() allocated, deleting the models read. */
+static void
+read_many_free(read_many_t *p_rm)
+{
+  int i;
+  for (i = 0; i < p_rm->n; i++) {
+    if (NULL != p_rm->results[i]) delete_lp(p_rm->results[i]);
+    free(p_rm->paths[i]);
+  }
+  free(p_rm->paths);
+  free(p_rm->results);
+  free(p_rm->errors);
+}
+
+/** Read many model files in parallel.
+
+    The files are read on native threads, without holding Ruby's
+    global VM lock, so other Ruby threads keep running meanwhile. Each
+    thread reads and decompresses whole files into memory in parallel;
+    the parsers of lp_solve are not reentrant, so only the parsing
+    itself is done one file at a time. Compressed files are read as by
+    read_MPS(). Where the platform lacks fopencookie() and funopen(),
+    reading is serialized along with the parsing.
+    The parsed-model cache (see lpsolve_set_model_cache_dir()) is not
+    used. If the reading thread is interrupted, e.g. by a signal trap,
+    the interrupt is handled and, unless it raised, reading goes on.
+
+    In Ruby:
+    \verbatim
+      LPSolve.read_many(paths, format: :mps, threads: 4, 
+                        verbose: LPSolve::IMPORTANT)
+    \endverbatim
+
+    @param argc number of arguments
+    @param argv the Array of file names and an optional Hash with
+    \a :format (\a :lp or \a :mps, the default), \a :threads (the
+    default is the number of online processors) and \a :verbose.
+    @param module the LPSolve class
+    @return an Array with, for each path in order, a new LPSolve
+    object, or an exception (not raised) describing why it could not
+    be read: a SystemCallError if the file could not be opened, a
+    NotImplementedError if it is compressed in a way this build cannot
+    read, or a RuntimeError if it could not be parsed.
+*/
+static VALUE
+lpsolve_read_many(int argc, VALUE *argv, VALUE module)
+{
+  VALUE paths, opts, format = Qnil, threads = Qnil, verbose = Qnil;
+  VALUE names, ret_ary;
+  read_many_t rm;
+  long i;
+
+  rb_scan_args(argc, argv, "1:", &paths, &opts);
+  Check_Type(paths, T_ARRAY);
+  if (!NIL_P(opts)) {
+    format  = rb_hash_aref(opts, ID2SYM(rb_intern("format")));
+    threads = rb_hash_aref(opts, ID2SYM(rb_intern("threads")));
+    verbose = rb_hash_aref(opts, ID2SYM(rb_intern("verbose")));
+  }
+
+  memset(&rm, 0, sizeof(rm));
+  rm.format = MODEL_MPS;
+  if (!NIL_P(format)) {
+    ID id = SYMBOL_P(format) ? SYM2ID(format) : 0;
+    if (id == rb_intern("lp"))       rm.format = MODEL_LP;
+    else if (id == rb_intern("mps")) rm.format = MODEL_MPS;
+    else rb_raise(rb_eArgError, "format must be :lp or :mps");
+  }
+  rm.verbosity = NIL_P(verbose) ? IMPORTANT : NUM2INT(verbose);
+  if (NIL_P(threads)) {
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    rm.n_threads = (n_cpus > 0) ? (int) n_cpus : 1;
+  } else {
+    rm.n_threads = NUM2INT(threads);
+    if (rm.n_threads < 1) rb_raise(rb_eArgError, "threads must be positive");
+  }
+
+  names = rb_ary_new2(RARRAY_LEN(paths));
+  for (i = 0; i < RARRAY_LEN(paths); i++) {
+    VALUE path = rb_ary_entry(paths, i);
+    StringValueCStr(path);
+    rb_ary_push(names, path);
+  }
+  rm.n = (int) RARRAY_LEN(names);
+  if (rm.n_threads > rm.n) rm.n_threads = (rm.n > 0) ? rm.n : 1;
+
+  /* Copy the names so that nothing Ruby owns is touched off the GVL. */
+  rm.paths   = ALLOC_N(char *, rm.n + 1);
+  rm.results = ALLOC_N(lprec *, rm.n + 1);
+  rm.errors  = ALLOC_N(int, rm.n + 1);
+  for (i = 0; i < rm.n; i++) {
+    VALUE path = rb_ary_entry(names, i);
+    rm.paths[i] = ALLOC_N(char, RSTRING_LEN(path) + 1);
+    memcpy(rm.paths[i], RSTRING_PTR(path), RSTRING_LEN(path) + 1);
+    rm.results[i] = NULL;
+    rm.errors[i]  = 0;
+  }
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&rm.lock, NULL);
+#endif
+  for (;;) {
+    int state = 0;
+    rm.interrupted = 0;
+    rb_thread_call_without_gvl(read_many_nogvl, &rm, read_many_ubf, &rm);
+    if (!rm.interrupted) break;
+    /* Run the interrupt; carry on with the rest unless it raised. */
+    rb_protect(read_many_check_ints, Qnil, &state);
+    if (state) {
+#ifdef HAVE_PTHREAD_H
+      pthread_mutex_destroy(&rm.lock);
+#endif
+      read_many_free(&rm);
+      rb_jump_tag(state);
+    }
+    if (rm.next >= rm.n) break;
+  }
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_destroy(&rm.lock);
+#endif
+
+  ret_ary = rb_ary_new2(rm.n);
+  for (i = 0; i < rm.n; i++) {
+    if (NULL != rm.results[i]) {
+      VALUE obj = lpsolve_alloc(rb_cLPSolve);
+      DATA_PTR(obj) = rm.results[i];
+      rb_ary_push(ret_ary, obj);
+    } else if (0 != rm.errors[i]) {
+      rb_ary_push(ret_ary, 
+                  rb_syserr_new(rm.errors[i], rm.paths[i]));
+    } else if (NULL != compression_missing(rm.paths[i])) {
+      rb_ary_push(ret_ary, 
+                  rb_exc_new_str(rb_eNotImpError,
+                                 rb_sprintf("%s: cannot decompress, "
+                                            "built without %s", rm.paths[i],
+                                            compression_missing(rm.paths[i]))));
+    } else {
+      rb_ary_push(ret_ary, 
+                  rb_exc_new_str(rb_eRuntimeError,
+                                 rb_sprintf("%s: could not read model",
+                                            rm.paths[i])));
+    }
+    rm.results[i] = NULL;
+  }
+  read_many_free(&rm);
+  return ret_ary;
+}
+
+/** A wrapper for print_str
+
+    Prints a string. By default, the output is stdout. However this
+    can be changed via a call to lpsolve_set_outputfile().  Possibly
+    useful for debugging/demo purposes.
+
+    @param self self 
+    @param str the string to print
+
+    @return \a true if string was printed; false on error such as the
+    str parameter is not a string type.
+*/
+static VALUE
+lpsolve_print_str(VALUE self, VALUE str)
+{
+  lprec *lp;
+  Data_Get_Struct(self, lprec, lp);
+
+  if (TYPE(str) != T_STRING) {
+    report(lp, IMPORTANT, 
+           "%s: parameter 2 is not a string.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
+  
+  print_str(lp, RSTRING_PTR(str));
+  return Qtrue;
+}
+
+/** A wrapper for print_solution. 
+
+    Prints the solution (variables) of the lp. This can only be done
+    after a successful solve.  This function is meant for debugging
+    purposes. By default, the output is stdout. However this can be
+    changed via a call to lpsolve_set_outputfile().
+
+    @param self self
+    @param columns Number of columns to use in printing the solution.
+    if columns is negative we will only print those variables which are
+    nonzero.
+
+    @return \a true unless we have an error.
+*/
+static VALUE lpsolve_print_solution(VALUE self, VALUE columns);
+static VALUE
+lpsolve_print_solution(VALUE self, VALUE columns) 
+{
+  lprec *lp;
+  int i_columns = FIX2INT(columns);
+  Data_Get_Struct(self, lprec, lp);
+  if (NULL == lp) return Qfalse;
+  if (i_columns < 0) {
+    int print_sol_save = lp->print_sol;
+    lp->print_sol = lp->print_sol | AUTOMATIC;
+    print_solution(lp, -i_columns);
+    lp->print_sol = print_sol_save;
+  } else {
+    print_solution(lp, i_columns);
+  }
+  return Qtrue;
+}
+
+/** Write a binary snapshot of the model.
+
+    The snapshot holds the constraint matrix in compressed sparse
+    column form, right-hand sides and ranges, bounds, variable types,
+    names, SOS constraints and solver parameters. Read it back with
+    LPSolve::load_binary(). The layout is versioned, but it uses the
+    native integer and floating-point format of the machine writing
+    it.
+
+    @param self self
+    @param filename place to write the snapshot, or an IO or any other
+    object that responds to write().
+
+    @return \a true if the snapshot was written completely.
+*/
+static VALUE
+lpsolve_save_binary(VALUE self, VALUE filename)
+{
+  INIT_LP;
+  if (TYPE(filename) == T_STRING) {
+    MYBOOL b_ret;
+    FILE *fp = fopen(RSTRING_PTR(filename), "wb");
+    if (NULL == fp) {
+      report(lp, IMPORTANT, "%s: Cannot open %s for writing.\n",
+             __FUNCTION__, RSTRING_PTR(filename));
+      return Qfalse;
+    }
+    b_ret = snapshot_write(lp, fp);
+    if (0 != fclose(fp)) b_ret = FALSE;
+    RETURN_BOOL(b_ret);
+  } else if (rb_respond_to(filename, rb_intern("write"))) {
+    RETURN_BOOL(write_model_rb(lp, snapshot_write, filename));
+  } else {
+    report(lp, IMPORTANT, "%s: Parameter is not a string filename or an IO.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+}
+
+/** wrapper for set_bb_depthlimit
+
+Sets the maximum branch-and-bound depth.
+
+Parameters
+
+lp
+
+Pointer to previously created lp model. See return value of make_lp, copy_lp, read_lp, read_LP, read_mps, read_freemps, read_MPS, read_freeMPS, read_XLI
+
+bb_maxlevel
+
+Specifies the maximum branch-and-bound depth. A positive value means
+that the depth is absoluut. A negative value means a relative B&B
+depth limit. The "order" of a MIP problem is defined to be 2x the
+number of binary variables plus the number of SC and SOS variables. A
+relative value of -x results in a maximum depth of x times the order
+of the MIP problem.
+
+Remarks
+
+The set_bb_depthlimit function sets the maximum branch-and-bound
+depth.  This is only useful if there are integer, semi-continious or
+SOS variables in the model so that the branch-and-bound algorithm must
+be used to solve them. The branch-and-bound algorithm will not go
+deeper than this level. When 0 then there is no limit to the
+depth. Limiting the depth will speed up solving time, but there is a
+chance that the found solution is not the most optimal one. Be aware
+of this. It can also result in not finding a solution at all.  The
+default is -50.
+*/
+static VALUE lpsolve_set_bb_depthlimit(VALUE self, VALUE limit);
+LPSOLVE_1_IN_STATUS_OUT(set_bb_depthlimit, FIX2INT(param1));
+
+/** wrapper for set_bb_bb_rule
+
+The set_bb_rule function specifies the branch-and-bound rule for
+choosing which non-integer variable is to be selected. This rule can
+influence solving times considerably. Depending on the model one rule
+can be best and for another model another rule.  The default is
+NODE_FIRSTSELECT (0).
+
+ */
+static VALUE lpsolve_set_bb_rule(VALUE self, VALUE bb_rule);
+LPSOLVE_1_IN_STATUS_OUT(set_bb_rule, FIX2INT(param1));
+
+/** A wrapper for set_add_rowmode().
+
+    Normally a model is built either column by column or row by row.
+    
+    The default \a on_off setting is \a false, which assumes model
+    building column by column.  So lpsolve_add_column(),
+    lpsolve_add_columnex(), and lpsolve_str_add_column() perform best
+    here.
+
+    If the model is built row by row via lpsolve_add_constraint(),
+    lpsolve_add_constraintex(), or lpsolve_str_add_constraint() calls,
+    then these routines will be much faster if this routine is called
+    with \a on_off set \a true. The speed improvement is spectacular,
+    especially for bigger models, so it is advisable to call this
+    routine to set the mode.
+
+    There are several restrictions with this mode. Only use this
+    function after lpsolve_make_lp() is called, not when the model is
+    read from a file. Also, if this function is used, first add the
+    objective function via set_obj_fn, set_obj_fnex, str_set_obj_fn
+    and after that add the constraints via add_constraint,
+    add_constraintex, str_add_constraint. Don't call other API
+    functions while in row entry mode. No other data matrix access is
+    allowed while in row entry mode. After adding the contraints, turn
+    row entry mode back off. Once turned off, you cannot switch back to
+    row entry mode. So in short: - turn row entry mode on - set the
+    objective function - create the constraints - turn row entry mode
+    off
+
+    @param self self
+    @param on_off \a true if are going to add by rows, \a false if not
+    or addign by columns.
+
+    @return \a true if changed from mode and \a false if this mode was
+    already set; \a nil if there was an error
+*/
+static VALUE lpsolve_set_add_rowmode(VALUE self, VALUE on_off);
+LPSOLVE_1_BOOL_IN_BOOL_OUT(set_add_rowmode);
+
+/** A wrapper for set_binary().
+
+    Set the type of the variable to be binary or floating point.
+    The default type of a variable is floating point. 
+
+    @param self self
+
+    @param column_num column number.
+
+    @param new_bool \a true if you want the column (variable) to take
+    on a binary value, \a false or \a nil if you want the column to
+    take on a floating-point value. If no value is given we assume \a
+    true (set to binary).
+
+    @return \a true if the operation was successful, \a false if there
+    was an error.
+*/
+#if 0
+LPSOLVE_SET_VARTYPE(set_binary, UNDO_INT)
+#endif
+
+static VALUE
+lpsolve_set_binary (VALUE self, VALUE column_num,       VALUE new_bool)
+{
+  INIT_LP;
+  if (new_bool != Qtrue && new_bool != Qfalse && new_bool != Qnil) {
+    report(lp, IMPORTANT,
+           "%s: Parameter is not a boolean or nil.\n",
+           __FUNCTION__);
+    return Qfalse;
+  } else {
+    int i_col = FIX2INT(column_num);
+    if (!index_ok(lp, __FUNCTION__, -1, i_col)) return Qfalse;
+    journal_note(self, lp, UNDO_INT, 0, i_col);
+    journal_note(self, lp, UNDO_LOWBO, 0, i_col);
+    journal_note(self, lp, UNDO_UPBO, 0, i_col);
+    RETURN_BOOL(journal_done(self, set_binary(lp, i_col, Qtrue == new_bool),
+                             3));
+  }
+}
 
-/** 
-    return the status of the last solve.
-    @param self self
-    @return A return status number of the last solve.
+/** A wrapper for set_bounds().
+
+    The set_bounds function sets a lower and upper bound on the
+    variable identified by column.  Setting a bound on a variable is
+    the way to go instead of adding an extra constraint (row) to the
+    model. Setting a bound doesn't increase the model size that means
+    that the model stays smaller and will be solved faster.  Note that
+    the default lower bound of each variable is 0. So variables will
+    never take negative values if no negative lower bound is set. The
+    default upper bound of a variable is infinity (well not quite. It
+    is a very big number. The value of get_infinite).
+
+   @return \a true if no errors.
 */
-static VALUE lpsolve_get_status(VALUE self) 
+static VALUE
+lpsolve_set_bounds(VALUE self, VALUE column_num, VALUE lower_bound, 
+                   VALUE upper_bound)
 {
-  return rb_ivar_get(self, rb_intern("@status"));
+  INIT_LP;
+  if (TYPE(column_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not an integer.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
+
+  {
+    int i_col = FIX2INT(column_num);
+    REAL r_lower = NUM2DBL(lower_bound), r_upper = NUM2DBL(upper_bound);
+    if (!index_ok(lp, __FUNCTION__, -1, i_col)) return Qfalse;
+    journal_note(self, lp, UNDO_LOWBO, 0, i_col);
+    journal_note(self, lp, UNDO_UPBO, 0, i_col);
+    RETURN_BOOL(journal_done(self, set_bounds(lp, i_col, r_lower, r_upper),
+                             2));
+  }
 }
 
+/** A wrapper for set_col_name
+    Returns a Ruby string column name.
+*/
+static VALUE
+lpsolve_set_col_name(VALUE self, VALUE column_num, VALUE new_name) 
+{
+  INIT_LP;
 
-/** 
-    A wrapper for get_statustext(statuscode).
-    However statuscode need not be supplied. If it isn't we use 
-    the status code from the last solve.
+  if (TYPE(column_num) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
 
-    @param self self
-    @param statuscode can be omitted or nil or an integer
-    @return string description of statuscode
+  if (TYPE(new_name) != T_STRING) {
+    report(lp, IMPORTANT, 
+           "%s: new name, parameter 2, is not a string.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
 
-    In Ruby, you can also use accessor function statustext.
+  return set_col_name(lp, FIX2INT(column_num), RSTRING_PTR(new_name)) ?
+    Qtrue: Qfalse;
+}
+
+/** A wrapper for set_debug
+
+    Sets a flag if all intermediate results and the branch-and-bound
+    decisions must be printed while solving.
+
+    @return \a true if no errors, false if an error (e.g. you didn't
+    pass true or false).
 */
-static VALUE lpsolve_get_statustext(int argc, VALUE *argv, VALUE self)
+static VALUE
+lpsolve_set_debug(VALUE self, VALUE new_bool) 
 {
-  VALUE statuscode;
-  unsigned int i_scanned;
-  int i_statuscode;
-  INIT_LP;
-  if ((argc > 1) || (argc < 0))
-    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", argc);
-  i_scanned = rb_scan_args(argc, argv, "01", &statuscode);
-  switch (i_scanned) {
-  case 0: 
-    statuscode = rb_ivar_get(self, rb_intern("@status"));
-    break;
-  case 1: 
-    if (statuscode != Qnil)
-      statuscode = rb_ivar_get(self, rb_intern("@status"));
-    else if (TYPE(statuscode) != T_FIXNUM) {
-      report(lp, IMPORTANT, "%s: Parameter is not nil or an integer.\n",
-             __FUNCTION__);
-      return Qnil;
-    }
-    break;
-  default:
-    rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", 
-             i_scanned);
+  if (new_bool != Qtrue && new_bool != Qfalse) {
+    return Qfalse;
+  } else {
+    INIT_LP;
+    set_debug(lp, Qtrue == new_bool);
+    return Qtrue;
   }
-
-  i_statuscode = FIX2INT(statuscode);
-  if (i_statuscode == SOLVE_NOT_CALLED)
-    return rb_str_new2("LPSolve method solve() not performed yet.");
-  else
-    return rb_str_new2(get_statustext(lp, FIX2INT(statuscode)));
 }
 
-/** A wrapper for get_timeout().
+/** A wrapper for set_int
+
+    Set the type of the variable to be integer or floating point.
+    The default type of a variable is floating point. 
+
+    The argument \a new_bool specifies what the status of the variable
+    becomes. From the moment there is at least one integer variable in
+    the model, the Branch and Bound algorithm is used to make these
+    variables integer. Note that solving times can be considerably
+    larger when there are integer variables. 
 
     @param self self
-    @return the number of seconds after which a timeout occurs.
-*/
-static VALUE lpsolve_get_timeout(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_timeout);
 
-/** A wrapper for get_timeout().
+    @param column_num column number of variable
 
-    Returns the total number of iterations with Branch-and-bound of
-    the last solution.  
+    @param new_bool \a true if you want the column (variable) to be an
+    integer, \a false or \a nil if you want the column not to take on
+    a floating-point value.  If no parameter is given, we assumed it
+    to be true (set to integer).
 
-    @param self self 
+    @param new_bool
 
-    @return the total number of iterations with Branch-and-bound of
-    the last solution.  
+    @return \a true if the operation was successful, \a false if there
+    was an error.
 */
-static VALUE lpsolve_get_total_iter(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(get_total_iter);
+LPSOLVE_SET_VARTYPE(set_int, UNDO_INT)
 
-/** A wrapper for get_upbo().
-
-   Returns the upper bound on the variable identified by column.
-   Setting a bound on a variable is the way to go instead of adding an
-   extra constraint (row) to the model. Setting a bound doesn't
-   increase the model size that means that the model stays smaller and
-   will be solved faster.  The default upper bound of a variable is
-   infinity (well not quite. It is a very big number. The value of
-   lpsolve_get_infinite().
+/** A wrapper for set_lp_name
 
-   @param self self
+    Set the name of the lp. Returns true if the operation was
+    successful. A return value of false indicates an error.
+*/
+static VALUE lpsolve_set_lp_name(VALUE self, VALUE model_name);
+LPSOLVE_1_STR_IN_BOOL_OUT(set_lp_name)
 
-   @param column_num the column number of the variable. It must be
-   between 1 and the number of columns in the lp.
+/** A wrapper for set_lowbo().
+    @return \a true if no errors.
+*/
+static VALUE
+lpsolve_set_lowbo(VALUE self, VALUE column, VALUE val) 
+{
+  INIT_LP;
+  if (TYPE(column) != T_FIXNUM) {
+    report(lp, IMPORTANT, 
+           "%s: column number, parameter 1, is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  {
+    REAL r_val = NUM2DBL(val);
+    if (!index_ok(lp, __FUNCTION__, -1, FIX2INT(column))) return Qfalse;
+    journal_note(self, lp, UNDO_LOWBO, 0, FIX2INT(column));
+    RETURN_BOOL(journal_done(self, set_lowbo(lp, FIX2INT(column), r_val), 1));
+  }
+}
 
+/** A wrapper for set_mat().
+    @return \a true if no errors.
 */
+static VALUE
+lpsolve_set_mat(VALUE self, VALUE row, VALUE column, VALUE val) 
+{
+  int i_row = NUM2INT(row), i_col = NUM2INT(column);
+  REAL r_val = NUM2DBL(val);
+  INIT_LP;
+  if (!index_ok(lp, __FUNCTION__, i_row, i_col)) return Qfalse;
+  journal_note(self, lp, UNDO_MAT, i_row, i_col);
+  RETURN_BOOL(journal_done(self, set_mat(lp, i_row, i_col, r_val), 1));
+}
 
-static VALUE lpsolve_get_upbo(VALUE self, VALUE column_num);
-LPSOLVE_1_IN_NUM_OUT(get_upbo, T_FIXNUM, "an integer", FIX2INT);
+/** A wrapper for set_maxim().
 
-/** A wrapper for get_var_dualresult()
+    Sets the objective direction to maximize. The default is to
+    minimize, except when reading a model in via lpsolve_read_LP. 
 
-    
+    @return \a true unless we have an error.
+*/
+static VALUE
+lpsolve_set_maxim(VALUE self)
+{
+  INIT_LP;
+  journal_note(self, lp, UNDO_SENSE, 0, 0);
+  set_maxim(lp);
+  return Qtrue;
+}
 
-    @param self self
-    @param index index 
+/** A wrapper for set_minim().
 
-    @return returns the reduced cost.
+    Sets the objective direction to minimize. The default is to
+    minimize, except when reading a model in via lpsolve_read_LP. 
 
-    In contrast to get_dual_solution, the original index number is
-    preserved.
+    @return \a true unless we have an error.
 */
-static VALUE lpsolve_get_var_dualresult(VALUE self, VALUE index);
-LPSOLVE_1_IN_NUM_OUT(get_var_dualresult, T_FIXNUM, "an integer", FIX2INT);
-
-/** A wrapper for get_var_primalresult()
+static VALUE
+lpsolve_set_minim(VALUE self)
+{
+  INIT_LP;
+  journal_note(self, lp, UNDO_SENSE, 0, 0);
+  set_minim(lp);
+  return Qtrue;
+}
 
-    @param self self
-    @param index index 
+/** A wrapper for set_mip_gap().
 
-    @return the name of the specified row. A return value of NULL
-    indicates an error. The difference between lpsolve_get_row_name()
-    and lpsovle_get_origrow_name() is only visible when a presolve
-    (set_presolve) was done. Presolve can result in deletion of rows
-    in the model. In lpsolve_get_row_name(), row specifies the row
-    number after presolve was done. In lpsovle_aget_origrow_name(),
-    row specifies the row number before presolve was done, ie the
-    original row number. If presolve is not active then both functions
-    are equal.  Returns a Ruby string row name.
+   Sets the MIP gap that specifies a tolerance for the branch and bound
+   algorithm. This tolerance is the difference between the best-found
+   solution yet and the current solution. If the difference is smaller
+   than this tolerance then the solution (and all the sub-solutions) is
+   rejected. This can result in faster solving times, but results in a
+   solution which is not the perfect solution. So be careful with this
+   tolerance.  The default mip_gap value is 1e-9
 
-    Retrieve the a value of the objective function, constraints and variables.
-    These values are only valid after a successful solve or lag_solve.
 
-    In contrast to get_primal_solution, the original index number is
-    preserved.
+   @param self self
+   @param abs_rel: set to true if the gap is absolute, or false for relative.
+   @param val: gap value. The default mip_gap is 1e-9.
+   @return \a true if no errors.
 */
-static VALUE lpsolve_get_var_primalresult(VALUE self, VALUE index);
-LPSOLVE_1_IN_NUM_OUT(get_var_primalresult, T_FIXNUM, "an integer", FIX2INT);
+static VALUE
+lpsolve_set_mip_gap(VALUE self, VALUE abs_rel, VALUE val) 
+{
+  INIT_LP;
+  if (abs_rel != Qtrue && abs_rel != Qfalse && abs_rel != Qnil) {
+    report(lp, IMPORTANT,
+           "%s: Parameter is not a boolean or nil.\n",
+           __FUNCTION__);
+    return Qfalse;
+  } else {
+    set_mip_gap(lp, Qtrue == abs_rel, NUM2DBL(val));
+    return Qtrue;
+  }
+}
 
-/** A wrapper for get_variables().
+/** A wrapper for str_set_obj_fn().
 
-    Get the values of the variables.
-    @param self self
-    
-    @return an array of the variable values. The size of the array is 
-    the number of columns + 1. Nil is returned if there was an error.
+    Set the objective function (row 0) of the matrix.
+
+    @return \a true unless we have an error, then \a nil or \a false.
 */
 static VALUE
-lpsolve_get_variables(VALUE self) 
+lpsolve_set_obj_fnex(VALUE self, VALUE row_coeffs) 
 {
-  unsigned int i_columns;
-  REAL *p_variables;
+  REAL *row = NULL;
+  int *colno = NULL;
+  long int i, count;
+  VALUE ret = Qnil;
+  VALUE *p_row_coeff = NULL;
 
   INIT_LP;
-  i_columns =  get_Ncolumns(lp);
-  
-  if (!get_ptr_variables(lp, &p_variables)) {
+
+  /***FIXME: combine common parts of this with add_constraintex ****/
+  if (TYPE(row_coeffs) != T_ARRAY) {
+    report(lp, IMPORTANT, 
+           "%s: row coefficients parameter is not an array.\n",
+           __FUNCTION__);
     return Qnil;
-  } else {
-    VALUE ret_ary = rb_ary_new2(i_columns);
-    unsigned int i;
-    for (i=0; i<i_columns; i++) {
-      rb_ary_push(ret_ary, rb_float_new(p_variables[i]));
+  }
+
+  count   = RARRAY_LEN(row_coeffs);
+  colno   = ALLOC_N(int, count);
+  row     = ALLOC_N(REAL, count);
+
+  p_row_coeff = RARRAY_PTR(row_coeffs);
+  for (i = 0; i < count; i++) {
+    int i_col;
+    if (TYPE(*p_row_coeff) != T_ARRAY) {
+      report(lp, IMPORTANT, 
+             "%s: row coeffient element %d is not an array.\n", 
+             __FUNCTION__, i);
+      goto done;
     }
-    return ret_ary;
+    if (RARRAY_LEN(*p_row_coeff) != 2) {
+      report(lp, IMPORTANT, 
+             "%s: row coeffient element %d is not an array tuple.\n", 
+             __FUNCTION__, i);
+      goto done;
+    } else {
+      VALUE *tuple = RARRAY_PTR(*p_row_coeff);
+      if (TYPE(tuple[0]) != T_FIXNUM) {
+        report(lp, IMPORTANT, 
+               "%s: Column number, first element, of row coefficients at " \
+               "tuple %d is not a integer.\n", __FUNCTION__, i);
+        goto done;
+      }
+      switch (TYPE(tuple[1])) {
+      case T_FIXNUM:
+      case T_FLOAT: break;
+      default:
+        report(lp, IMPORTANT, 
+               "%s: Coefficient value, second element, of row coeffients at "
+               "tuple %d is not an integer.\n", __FUNCTION__, i);
+        goto done;
+      }
+
+      i_col = FIX2INT(tuple[0]);
+      if (i_col <= 0 || i_col > lp->columns) {
+        report(lp, IMPORTANT, 
+               "%s: Column number, first element, of row coeffients at " \
+               "tuple %d is in the range 1..%d\n", 
+               __FUNCTION__, i, lp->columns);
+        goto done;
+      }
+      colno[i] = i_col;
+      row[i]   = NUM2DBL(tuple[1]);
+    }
+    p_row_coeff++;
   }
-  
-}
 
-/** A wrapper for get_verbose()
+  {
+    REAL *old_obj = journal_objective_begin(self, lp);
+    ret = set_obj_fnex(lp, count, row, colno) ? Qtrue : Qfalse ;
+    journal_objective_end(self, lp, old_obj);
+  }
 
-    get_verbose returns the current verbose level. Can be one of the
-    following values:
-       \a LPSolve::NEUTRAL,   \a LPSolve::CRITICAL, \a LPSolve::SEVERE,
-       \a LPSolve::IMPORTANT, \a LPSolve::NORMAL,   \a LPSolve::DETAILED, or
-       \a LPSolve::FULL
+ done:
+  free(row);
+  free(colno);
+  return ret;
 
-    How much information is reported depends on the verbose level. The
-    default verbose level is \a LPSOLVE::NORMAL. lp_solve determines
-    how verbose a given message is. For example specifying a wrong
-    row/column index values is considered as a \a LPSOLVE::SEVERE
-    error. All messages equal to and below the set level are reported.
-    The default reporting device is the console screen. It is possible
-    to set a used defined reporting routine via lpsolve_put_logfunc().
+}
 
-    In Ruby, you can also use accessor function verbose.
+/** Turn the parsed-model cache of read_LP and read_MPS on or off.
 
-    @param self self
-    @return a Ruby integer verbosity level.
+    With a cache directory set, read_LP and read_MPS hash the contents
+    of the model file. If a model with the same contents (and format
+    and model name) was read before, its binary snapshot is loaded from
+    the cache instead of parsing the file; otherwise the file is parsed
+    and a snapshot is stored. Entries are never invalidated, since a
+    changed file gets a different key; remove old files from the
+    directory to reclaim space.
 
+    In Ruby this is the class method LPSolve.model_cache_dir=.
+
+    @param klass the LPSolve class
+    @param dir the cache directory, created if needed, or \a nil to
+    turn the cache off.
+    @return \a dir
 */
-static VALUE lpsolve_get_verbose(VALUE self);
-LPSOLVE_0_IN_INT_OUT(get_verbose)
+static VALUE
+lpsolve_set_model_cache_dir(VALUE klass, VALUE dir)
+{
+  if (!NIL_P(dir)) {
+    dir = rb_str_new_frozen(StringValue(dir));
+    if (0 != mkdir(RSTRING_PTR(dir), 0777) && EEXIST != errno)
+      rb_sys_fail(RSTRING_PTR(dir));
+    rb_require("digest/sha2");
+  }
+  model_cache_dir = dir;
+  return dir;
+}
 
+/** Return the directory of the parsed-model cache, or \a nil if the
+    cache is off. @see lpsolve_set_model_cache_dir()
+*/
 static VALUE
-lpsolve_initialize(VALUE self, VALUE num_vars, VALUE num_constraints) 
+lpsolve_get_model_cache_dir(VALUE klass)
 {
-  int i_vars = NUM2INT(num_vars);
-  int i_constraints = NUM2INT(num_constraints);
-  lprec *lp = make_lp(i_vars, i_constraints);
-  DATA_PTR(self) = lp;
-  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
-  return self;
+  return model_cache_dir;
 }
 
-/** A wrapper for is_debug().
+/** A print stream set by set_output_io(). It is owned by a hidden
+    Ruby object kept in the LPSolve object, which also keeps the
+    target alive; lp_solve itself never closes it, and lpsolve_free()
+    detaches it before deleting the model.
+*/
+typedef struct {
+  rbstream_t rbs;
+  FILE *fp;
+} output_io_t;
 
-    Returns a flag if all intermediate results and the
-    branch-and-bound decisions must be printed while solving. This
-    function is meant for debugging purposes. The default is not to
-    debug.
+static void
+output_io_mark(void *p)
+{
+  rb_gc_mark(((output_io_t *) p)->rbs.target);
+}
 
-    Returns a flag if 
-    @param self self
+/* The target may already have been swept, so nothing may be written
+   to it any more. */
+static void
+output_io_free(void *p)
+{
+  output_io_t *p_out = (output_io_t *) p;
+  p_out->rbs.detached = TRUE;
+  fclose(p_out->fp);
+  free(p_out);
+}
 
-    @return true, false, or nil on error. If true is returned, all
-    intermediate results and the branch-and-bound decisions will be
-    printed while solving.
-*/
-static VALUE lpsolve_is_debug(VALUE self);
-LPSOLVE_0_IN_BOOL_OUT(is_debug);
+/* Flush and release the stream set by set_output_io(), re-raising any
+   exception its target raised. */
+static void
+output_io_close(VALUE self)
+{
+  ID id_output_io = rb_intern("output_io");
+  VALUE holder;
+  output_io_t *p_out;
+  int state;
+
+  if (!rb_ivar_defined(self, id_output_io)) return;
+  holder = rb_ivar_get(self, id_output_io);
+  if (NIL_P(holder)) return;
+  rb_ivar_set(self, id_output_io, Qnil);
+  Data_Get_Struct(holder, output_io_t, p_out);
+  fflush(p_out->fp);
+  state = p_out->rbs.state;
+  p_out->rbs.state = 0;
+  if (state) rb_jump_tag(state);
+}
 
-/** A wrapper for is_maxim().
+/** Send the output of the print functions (print_lp, print_duals,
+    print_solution, ...) to a Ruby String or to an object that responds
+    to write(), e.g. an IO or StringIO. The output is line buffered.
+    An exception raised by the target's write() is re-raised by the
+    next call to set_output_io().
 
     @param self self
-    @return boolean or nil on error.
+    @param io a String to append to, an IO-like object, or \a nil to
+    go back to stdout.
+    @return \a true unless we have an error.
+    @see lpsolve_capture_output()
 */
-static VALUE lpsolve_is_maxim(VALUE self);
-LPSOLVE_0_IN_BOOL_OUT(is_maxim);
+static VALUE
+lpsolve_set_output_io(VALUE self, VALUE io)
+{
+  output_io_t *p_out;
+  VALUE holder;
+  INIT_LP;
 
-/** A wrapper for is_SOS_var().
+  if (!NIL_P(io) && TYPE(io) != T_STRING 
+      && !rb_respond_to(io, rb_intern("write"))) {
+    report(lp, IMPORTANT, 
+           "%s: parameter 1 is not a String or IO.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
 
-    Returns if a variable is a SOS variable or not. By default a variable
-    is not SOS. A variable becomes a SOS variable via lpsolve_add_SOS().
+#ifndef HAVE_COOKIE_STREAMS
+  if (!NIL_P(io)) rb_notimplement();
+#endif
+  if (TYPE(io) == T_STRING) rb_check_frozen(io);
 
-    @param column the column number of the variable to be checked. It
-    should be between 1 and the number of columns in the lp.
-    @param self self
-    @return boolean or nil on error.
-*/
-static VALUE lpsolve_is_SOS_var(VALUE self, VALUE column);
-LPSOLVE_1_IN_BOOL_OUT(is_SOS_var, T_FIXNUM, "an integer", FIX2INT)
+  set_outputstream(lp, NULL);
+  output_io_close(self);
+  if (NIL_P(io)) return Qtrue;
 
-static void __WINAPI
-lpsolve_logfunction(lprec *lp, void *userhandle, char *buf)
-{
-  printf("***%s\n", buf);
+  p_out = ALLOC(output_io_t);
+  p_out->fp = rbstream_open(&p_out->rbs, io);
+  if (NULL == p_out->fp) {
+    free(p_out);
+    report(lp, IMPORTANT, "%s: could not create a stream.\n", __FUNCTION__);
+    return Qfalse;
+  }
+  setvbuf(p_out->fp, NULL, _IOLBF, BUFSIZ);
+  holder = Data_Wrap_Struct(0, output_io_mark, output_io_free, p_out);
+  rb_ivar_set(self, rb_intern("output_io"), holder);
+  set_outputstream(lp, p_out->fp);
+  return Qtrue;
 }
 
-/**
-   Constructs a new LP. Sets all variables to initial values.  The LP
-   has rows rows and columns columns. The matrix contains no values,
-   but space for one value. All arrays that depend on rows and columns
-   are allocated.
+/* State of a capture_output() call. */
+typedef struct {
+  lprec *lp;
+  FILE *saved_stream;
+  MYBOOL saved_owned;
+  rbstream_t rbs;
+  FILE *fp;
+} capture_t;
 
-   @param class_or_model_name either the class or module name which this
-   is to belong to (it will be equal to LPSolve or LPsolve). If you are 
-   calling from Ruby, this parameter will be taken care of automatically.
-   @param num_vars number of variables or columns
-   @param num_constraints number of constraints or rows
+static VALUE
+capture_output_restore(VALUE arg)
+{
+  capture_t *p_cap = (capture_t *) arg;
+  p_cap->lp->outstream   = p_cap->saved_stream;
+  p_cap->lp->streamowned = p_cap->saved_owned;
+  rbstream_close(&p_cap->rbs, p_cap->fp);
+  return Qnil;
+}
 
-   @return nil is returned if there was an error.
-*/
+/** Run the block and return, as a String, everything the print
+    functions wrote during it. Output goes to memory rather than a
+    temporary file where the platform allows it; the previous output
+    stream is restored afterwards, even if the block raises.
 
+    @param self self
+    @return the captured output.
+    @see lpsolve_set_output_io()
+*/
 static VALUE
-lpsolve_make_lp(VALUE class_or_model_name, VALUE num_constraints, 
-                VALUE num_vars) 
+lpsolve_capture_output(VALUE self)
 {
-  int i_constraints = NUM2INT(num_constraints);
-  int i_vars = NUM2INT(num_vars);
-  lprec *lp = make_lp(i_constraints, i_vars);
-  if (NULL == lp) {
+  capture_t cap;
+  volatile VALUE str = rb_str_new(NULL, 0);
+  INIT_LP;
+
+  cap.lp   = lp;
+  cap.fp   = rbstream_open(&cap.rbs, str);
+  if (NULL == cap.fp) {
+    report(lp, IMPORTANT, "%s: could not create a stream.\n", __FUNCTION__);
     return Qnil;
-  } else {
-    VALUE obj = lpsolve_alloc(rb_cLPSolve);
-    DATA_PTR(obj) = lp;
-    return obj;
   }
+  /* Swap the stream directly: set_outputstream() would close an owned
+     one. */
+  cap.saved_stream = lp->outstream;
+  cap.saved_owned  = lp->streamowned;
+  lp->outstream    = cap.fp;
+  lp->streamowned  = FALSE;
+  rb_ensure(rb_yield, self, capture_output_restore, (VALUE) &cap);
+  return str;
 }
 
-/** A wrapper for print_duals(). 
+/** A wrapper for set_outputfile(). 
 
-    @param self self
-    @return \a true unless we have an error.
+    @return \a true if we could set the output file.
 */
-LPSOLVE_0_IN_STATUS_OUT(print_duals)
+static VALUE lpsolve_set_outputfile(VALUE self, VALUE filename);
+LPSOLVE_1_STR_IN_BOOL_OUT(set_outputfile)
 
-/** A wrapper for print_debugdump(). 
+/** A wrapper for set_presolve(). 
 
-    The print_debugdump function creates a generic readable data dump
-    of key lp_solve model variables; principally for run difference and
-    debugging purposes This function is meant for debugging purposes.
+    @return \a true if no errors.
+*/
+static VALUE lpsolve_set_presolve(VALUE self, VALUE do_presolve, 
+                                  VALUE maxloops) 
+{
+  INIT_LP;
+  if (TYPE(do_presolve) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: Presolve parameter is not a number (bitmask).\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  if (TYPE(maxloops) != T_FIXNUM ) {
+    report(lp, IMPORTANT, 
+           "%s: maxloops parameter should be a number (bitmask).\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  set_presolve(lp, FIX2INT(do_presolve), FIX2INT(maxloops));
+  return Qtrue;
+}
 
-    @return \a true if we could write the output file.
+
+/** A wrapper for set_presolve(). 
+
+    @return \a true if no errors.
 */
-static VALUE lpsolve_print_debugdump(VALUE self, VALUE filename);
-LPSOLVE_1_STR_IN_BOOL_OUT(print_debugdump)
+static VALUE lpsolve_set_presolve1(VALUE self, VALUE do_presolve)
+{
+  int i_maxloops;
+  INIT_LP;
+  if (TYPE(do_presolve) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: Presolve parameter is not a number (bitmask).\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  i_maxloops = get_presolveloops(lp);
+  set_presolve(lp, FIX2INT(do_presolve), i_maxloops);
+  return Qtrue;
+}
 
-/** A wrapper for print_lp. 
+/** Presolve the model once and keep the reduced model.
+
+    lp_solve only presolves as part of solve(), and leaves the model
+    reduced afterwards. This solves once with presolve \a mode, then
+    turns presolve off, so that later solves, e.g. after set_rh or
+    set_mat with new data, work on the reduced model without paying for
+    presolve again. Use lpsolve_get_lp_index() to find the rows and
+    columns to change, and lpsolve_get_orig_solution() to get results
+    in the original numbering. Rows and columns presolve removed keep
+    the values of this solve.
+
+    Every reduction is worked out from the data at the time, and none
+    is undone by later changes. The default, PRESOLVE_LINDEP, only
+    drops rows that are linear combinations of others, which stays
+    valid as long as the right-hand sides of the rows involved keep
+    the same combination; changing one of them with set_rh can make a
+    dropped row violated without any sign of it. PRESOLVE_ROWS,
+    PRESOLVE_COLS and the like also fix columns and drop rows from the
+    bounds and objective. Only change what the chosen reductions leave
+    untouched, or presolve again.
 
     @param self self
-    @return \a true unless we have an error.
+    @param mode the presolve options, a bitmask of LPSolve::PRESOLVE_*
+    values; PRESOLVE_LINDEP by default.
+    @param maxloops the most presolve passes, -1 (until nothing
+    changes) by default.
+    @return the result of the solve, as for lpsolve_solve().
 */
-static VALUE lpsolve_print_lp(VALUE self);
-LPSOLVE_0_IN_STATUS_OUT(print_lp)
+static VALUE
+lpsolve_presolve_once(int argc, VALUE *argv, VALUE self)
+{
+  VALUE mode, maxloops, status;
+  int i_mode = PRESOLVE_LINDEP;
+  callback_error_t cb_err = { 0, Qnil };
+  INIT_LP;
+  rb_scan_args(argc, argv, "02", &mode, &maxloops);
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qnil;
+  if (!NIL_P(mode)) i_mode = NUM2INT(mode);
+  set_presolve(lp, i_mode, NIL_P(maxloops) ? -1 : NUM2INT(maxloops));
+  status = INT2FIX(callbacks_solve(self, lp, &cb_err));
+  rb_ivar_set(self, rb_intern("@status"), status);
+  set_presolve(lp, PRESOLVE_NONE, get_presolveloops(lp));
+  callbacks_raise(&cb_err);
+  return status;
+}
 
-static VALUE lpsolve_print(VALUE self);
-void print(lprec *lp);
-LPSOLVE_0_IN_STATUS_OUT(print)
+#if GET_RH_FIXED
+/** A wrapper for get_rh().
+
+    Get the value of the right hand side (RHS) vector (column 0) for
+    the specified row.
 
-/** A wrapper for print_constraints. 
     @param self self
-    @param num constraint number.
-    @return \a true unless we have an error.
-*/
-static VALUE lpsolve_print_constraints(VALUE self, VALUE num);
-LPSOLVE_1_IN_STATUS_OUT(print_constraints, FIX2INT(param1));
+    @param row_num the row number of the RHS to be retrieved
+    Must be between 0 and number of rows in the lp.
 
-/** A wrapper for print_logfunc
-    @return nil.
 */
 static VALUE
-lpsolve_put_logfunc(VALUE self, VALUE logfunc_name) 
+lpsolve_get_rh(VALUE self, VALUE row_num)
 {
-  lprec *lp;
-  rb_define_readonly_variable("@logfunc_name", &logfunc_name);
-  Data_Get_Struct(self, lprec, lp);
-  put_logfunc(lp, lpsolve_logfunction, NULL);
-  return Qnil;
+  LPSOLVE_1_IN_NUM_OUT(get_rh, T_FIXNUM, "an integer", FIX2INT);
 }
+#endif
 
-/** A wrapper for print_objective. 
-    @return nil.
-*/
-LPSOLVE_0_IN_STATUS_OUT(print_objective)
-
-/** A wrapper for print_tableau(). 
+/** A wrapper for set_rh().
 
-    The print_tableau function prints the tableau. This function only
-    works after a successful solve This function is meant for
-    debugging purposes. By default, the output is stdout. However this
-    can be changed via a call to set_outputstream, set_outputfile.
+    (Re)Set the value of the right hand side (RHS) vector (column 0) for 
+    the specified row.
 
     @param self self
-    @return \a true unless we have an error.
-*/
-LPSOLVE_0_IN_STATUS_OUT(print_tableau)
-
-/** A wrapper for read_LP. 
-
-  Create a LPSolve object and read an lp model from file.
+    @param row_num the row number for which the RHS is to be must be set. 
+    Must be between 0 and number of rows in the lp.
 
-  Returns anew LPSolve object. A Nil return value indicates an
-  error. Specifically file could not be opened or file has wrong
-  structure or not enough memory available to setup an lprec
-  structure.
+    @param value The value to set the RHS to.
 
+    @return \a true of no error, or \a nil if there was an error.
 */
 static VALUE
-lpsolve_read_LP(VALUE model, VALUE filename, VALUE verbosity, 
-                VALUE model_name) 
+lpsolve_set_rh(VALUE self, VALUE row_num, VALUE value) 
 {
-  lprec *lp;
-
-  if (TYPE(filename) != T_STRING) {
-    return Qnil;
-  }
-  
-  if (TYPE(verbosity) != T_FIXNUM) {
-    return Qnil;
-  }
-  
-  if (TYPE(model_name) != T_STRING) {
-      return Qnil;
-  }
-  
-  lp = read_LP(RSTRING_PTR(filename), verbosity, RSTRING_PTR(model_name));
-  if (NULL == lp) {
-    return Qnil;
-  } else {
-    VALUE obj = lpsolve_alloc(rb_cLPSolve);
-    DATA_PTR(obj) = lp;
-    return obj;
-  }
+  int i_row = NUM2INT(row_num);
+  REAL r_value = NUM2DBL(value);
+  INIT_LP;
+  if (!index_ok(lp, __FUNCTION__, i_row, -1)) return Qnil;
+  journal_note(self, lp, UNDO_RH, i_row, 0);
+  journal_done(self, set_rh(lp, i_row, r_value), 1);
+  return Qnil;
 }
 
-/** A wrapper for read_MPS.
+/** A wrapper for set_rh_range().
 
-  Create a LPSolve object and read an MPS model from a file.
+   Set a range on the constraint (row) identified by row.  Setting a
+   range on a row is the way to go instead of another constraint (row) to
+   the model. (Note that in either case, there are two API calls 
+   to set the lower and upper bound. 
 
-  Returns a new LPSolve Object. A Nil return value indicates an
-  error. Specifically file could not be opened or file has wrong
-  structure or not enough memory available to setup an lprec
-  structure.
+   Setting a range doesn't increase the model size, and that means
+   that the model stays smaller and will be solved faster.  If the row
+   previously had a less-than constraint, then the range means setting
+   a minimum on the constraint that is equal to the RHS value minus
+   the range. If the row has a greater-than constraint then the range
+   means setting a maximum on the constraint that is equal to the RHS
+   value plus the range.  Note that the range value is the difference
+   value and not the absolute value.  Set the value of the right hand
+   side (RHS) vector (column 0) for the specified row.
+
+    @param self self
+    @param row_num the row number for which the RHS is to be must be set. 
+    Must be between 0 and number of rows in the lp.
+
+    @param value The value to set the RHS to.
 
+    @return \a true of no error, or \a nil if there was an error.
 */
 static VALUE
-lpsolve_read_MPS(VALUE module, VALUE filename, VALUE verbosity) 
+lpsolve_set_rh_range(VALUE self, VALUE row_num, VALUE deltavalue) 
 {
-  lprec *lp;
-
-  if (TYPE(filename) != T_STRING) {
-    return Qnil;
-  }
-  
-  if (TYPE(verbosity) != T_FIXNUM) {
-      return Qnil;
-  }
-  
-  lp = read_MPS(RSTRING_PTR(filename), verbosity);
-  if (NULL == lp) {
-    return Qnil;
-  } else {
-    VALUE obj = lpsolve_alloc(rb_cLPSolve);
-    DATA_PTR(obj) = lp;
-    return obj;
-  }
+  int i_row = NUM2INT(row_num);
+  REAL r_delta = NUM2DBL(deltavalue);
+  INIT_LP;
+  if (!index_ok(lp, __FUNCTION__, i_row, -1)) return Qfalse;
+  journal_note(self, lp, UNDO_RH_RANGE, i_row, 0);
+  RETURN_BOOL(journal_done(self, set_rh_range(lp, i_row, r_delta), 1));
 }
 
-/** A wrapper for print_str
-
-    Prints a string. By default, the output is stdout. However this
-    can be changed via a call to lpsolve_set_outputfile().  Possibly
-    useful for debugging/demo purposes.
+/** A wrapper for set_row_name.
 
-    @param self self 
-    @param str the string to print
+    Set the name of a constraint (row) in the lp.
 
-    @return \a true if string was printed; false on error such as the
-    str parameter is not a string type.
+    @return \a true if the operation was successful, false if not.
 */
-static VALUE
-lpsolve_print_str(VALUE self, VALUE str)
+static VALUE 
+lpsolve_set_row_name(VALUE self, VALUE row_num, VALUE new_name) 
 {
-  lprec *lp;
-  Data_Get_Struct(self, lprec, lp);
+  INIT_LP;
 
-  if (TYPE(str) != T_STRING) {
-    report(lp, IMPORTANT, 
-           "%s: parameter 2 is not a string.\n",
-           __FUNCTION__);
+  if (TYPE(new_name) != T_STRING) {
     return Qfalse;
   }
-  
-  print_str(lp, RSTRING_PTR(str));
-  return Qtrue;
+
+  RETURN_BOOL(set_row_name(lp, FIX2INT(row_num), RSTRING_PTR(new_name)));
 }
 
-/** A wrapper for print_solution. 
+/** A wrapper for set_semicont().
 
-    Prints the solution (variables) of the lp. This can only be done
-    after a successful solve.  This function is meant for debugging
-    purposes. By default, the output is stdout. However this can be
-    changed via a call to lpsolve_set_outputfile().
+Set the type of the variable (column) to be semi-continuous or not. By
+default, a variables are not semi-continuous. Note that a
+semi-continuous variable should have a nonzero lower bound to for this
+to have different effect. Recall that the default lower bound on
+variables is zero. The lower bound may be set before or after setting
+the semi-continuous status. 
 
     @param self self
-    @param columns Number of columns to use in printing the solution.
-    if columns is negative we will only print those variables which are
-    nonzero.
 
-    @return \a true unless we have an error.
+    @param column_num column number of the variable
+
+    @param new_bool true if you want the column (variable) to be a
+    semi-continuous value, \a false or \a nil if you want the column
+    not to take on a floating-point value. If no parameter specified,
+    \a true is assumed
+
+    @return \a true if the operation was successful, \a false if there
+    was an error.
 */
-static VALUE lpsolve_print_solution(VALUE self, VALUE columns);
-static VALUE
-lpsolve_print_solution(VALUE self, VALUE columns) 
+LPSOLVE_SET_VARTYPE(set_semicont, UNDO_SEMICONT)
+
+/** 
+    return the status status code of the last solve.
+    @param self self
+    @return A return status number of the last solve.
+*/
+static VALUE lpsolve_set_status(VALUE self, VALUE newstatus) 
 {
-  lprec *lp;
-  int i_columns = FIX2INT(columns);
-  Data_Get_Struct(self, lprec, lp);
-  if (NULL == lp) return Qfalse;
-  if (i_columns < 0) {
-    int print_sol_save = lp->print_sol;
-    lp->print_sol = lp->print_sol | AUTOMATIC;
-    print_solution(lp, -i_columns);
-    lp->print_sol = print_sol_save;
-  } else {
-    print_solution(lp, i_columns);
-  }
-  return Qtrue;
+  INIT_LP;
+  if (FIXNUM_P(newstatus))
+    return rb_ivar_set(self, rb_intern("@status"), newstatus);
+  else
+    report(lp, IMPORTANT, 
+           "%s: status should be a Fixnum.\n", __FUNCTION__);
+  return Qnil;
 }
 
-/** wrapper for set_bb_depthlimit
 
-Sets the maximum branch-and-bound depth.
+/** A wrapper for set_timeout().
 
-Parameters
+    In Ruby, you can also use accessor function timeout=.
 
-lp
+    The solve() and lag_solve() methods may not last longer than this
+    time or the routines return with a timeout. The default timeout is
+    0, resulting in no timeout.  If a timout occurs, but there was
+    already an integer solution found (that is possibly not the best),
+    then solve will return LPSolve::SUBOPTIMAL. If there was no integer
+    solution found yet or there are no integers or the solvers is
+    still in the first phase where a REAL optimal solution is searched
+    for, then solve will return TIMEOUT.
 
-Pointer to previously created lp model. See return value of make_lp, copy_lp, read_lp, read_LP, read_mps, read_freemps, read_MPS, read_freeMPS, read_XLI
+    Set a timeout for solving .
+    @param self self
+    @param sec_timeout floating-point timeout value in seconds.
+    @return nil.
+*/
+static VALUE
+lpsolve_set_timeout(VALUE self, VALUE sec_timeout) 
+{
+  INIT_LP;
+  set_timeout(lp, NUM2DBL(sec_timeout));
+  return Qnil;
+}
 
-bb_maxlevel
+/** A wrapper for set_scaling().
+
+    Specifies which scaling algorithm must be used. 
+
+    @return nil.
+*/
+static VALUE
+lpsolve_set_scaling(VALUE self, VALUE new_scalemode) 
+{
+  INIT_LP;
+  set_scaling(lp, FIX2INT(new_scalemode));
+  return Qnil;
+}
 
-Specifies the maximum branch-and-bound depth. A positive value means
-that the depth is absoluut. A negative value means a relative B&B
-depth limit. The "order" of a MIP problem is defined to be 2x the
-number of binary variables plus the number of SC and SOS variables. A
-relative value of -x results in a maximum depth of x times the order
-of the MIP problem.
+/** A wrapper for set_simplextype().
 
-Remarks
+    In Ruby, you can also use accessor function simplextype=.
 
-The set_bb_depthlimit function sets the maximum branch-and-bound
-depth.  This is only useful if there are integer, semi-continious or
-SOS variables in the model so that the branch-and-bound algorithm must
-be used to solve them. The branch-and-bound algorithm will not go
-deeper than this level. When 0 then there is no limit to the
-depth. Limiting the depth will speed up solving time, but there is a
-chance that the found solution is not the most optimal one. Be aware
-of this. It can also result in not finding a solution at all.  The
-default is -50.
+    @param self
+    @param new_simplextype desired level of verbosity, an integer. @see 
+    lpsolve_get_simplextype() for simplex types.
+    @return nil on error. 
 */
-static VALUE lpsolve_set_bb_depthlimit(VALUE self, VALUE limit);
-LPSOLVE_1_IN_STATUS_OUT(set_bb_depthlimit, FIX2INT(param1));
+static VALUE lpsolve_set_simplextype(VALUE self, VALUE new_simplextype);
+LPSOLVE_1_IN_STATUS_OUT(set_simplextype, FIX2INT(param1))
 
-/** wrapper for set_bb_bb_rule
+/** A wrapper for set_solutionlimit().
 
-The set_bb_rule function specifies the branch-and-bound rule for
-choosing which non-integer variable is to be selected. This rule can
-influence solving times considerably. Depending on the model one rule
-can be best and for another model another rule.  The default is
-NODE_FIRSTSELECT (0).
+    Sets the solution number that must be returned.
 
- */
-static VALUE lpsolve_set_bb_rule(VALUE self, VALUE bb_rule);
-LPSOLVE_1_IN_STATUS_OUT(set_bb_rule, FIX2INT(param1));
+    This function is only valid if there are integer, semi-continious
+    or SOS variables in the model so that the branch-and-bound
+    algoritm is used. If there are more solutions with the same
+    objective value, then this number specifies which solution must be
+    returned. This can be used to retrieve all possible
+    solutions. Start with 1 till get_solutioncount 
 
-/** A wrapper for set_add_rowmode().
+    @param self
+    @param limit number of solutions needed
+    @return nil on error. 
 
-    Normally a model is built either column by column or row by row.
-    
-    The default \a on_off setting is \a false, which assumes model
-    building column by column.  So lpsolve_add_column(),
-    lpsolve_add_columnex(), and lpsolve_str_add_column() perform best
-    here.
+@return nil.
+*/
+static VALUE lpsolve_set_solutionlimit(VALUE self, VALUE limit);
+LPSOLVE_1_IN_STATUS_OUT(set_solutionlimit, FIX2INT(param1))
 
-    If the model is built row by row via lpsolve_add_constraint(),
-    lpsolve_add_constraintex(), or lpsolve_str_add_constraint() calls,
-    then these routines will be much faster if this routine is called
-    with \a on_off set \a true. The speed improvement is spectacular,
-    especially for bigger models, so it is advisable to call this
-    routine to set the mode.
+/** A wrapper for set_sensitivity
 
-    There are several restrictions with this mode. Only use this
-    function after lpsolve_make_lp() is called, not when the model is
-    read from a file. Also, if this function is used, first add the
-    objective function via set_obj_fn, set_obj_fnex, str_set_obj_fn
-    and after that add the constraints via add_constraint,
-    add_constraintex, str_add_constraint. Don't call other API
-    functions while in row entry mode. No other data matrix access is
-    allowed while in row entry mode. After adding the contraints, turn
-    row entry mode back off. Once turned off, you cannot switch back to
-    row entry mode. So in short: - turn row entry mode on - set the
-    objective function - create the constraints - turn row entry mode
-    off
+    Sets a flag if sensitivity analysis must be done when solving, so
+    that duals and reduced costs are available afterwards.
 
     @param self self
-    @param on_off \a true if are going to add by rows, \a false if not
-    or addign by columns.
-
-    @return \a true if changed from mode and \a false if this mode was
-    already set; \a nil if there was an error
+    @param sensitivity_bool analyse if true; don't if false.
+    @return \a true if the operation was successful, FALSE if there was an error.
 */
-static VALUE lpsolve_set_add_rowmode(VALUE self, VALUE on_off);
-LPSOLVE_1_BOOL_IN_BOOL_OUT(set_add_rowmode);
+static VALUE
+lpsolve_set_sensitivity(VALUE self, VALUE sensitivity_bool) 
+{
+  if (sensitivity_bool != Qtrue && sensitivity_bool != Qfalse) {
+    return Qfalse;
+  } else {
+    INIT_LP;
+    set_sensitivity(lp, Qtrue == sensitivity_bool);
+    /* lp_solve has no getter; solve_with_column_generation reads this. */
+    rb_ivar_set(self, rb_intern("sensitivity"), sensitivity_bool);
+    return Qtrue;
+  }
+}
 
-/** A wrapper for set_binary().
+/** A wrapper for set_trace
 
-    Set the type of the variable to be binary or floating point.
-    The default type of a variable is floating point. 
+    Sets a flag if pivot selection must be printed while solving.
 
     @param self self
+    @param print_bool print if true; don't print if false.
+    @return \a true if the operation was successful, FALSE if there was an error.
+*/
+static VALUE
+lpsolve_set_trace(VALUE self, VALUE print_bool) 
+{
+  if (print_bool != Qtrue && print_bool != Qfalse) {
+    return Qfalse;
+  } else {
+    INIT_LP;
+    set_trace(lp, Qtrue == print_bool);
+    return Qtrue;
+  }
+}
 
-    @param column_num column number.
-
-    @param new_bool \a true if you want the column (variable) to take
-    on a binary value, \a false or \a nil if you want the column to
-    take on a floating-point value. If no value is given we assume \a
-    true (set to binary).
+/** A wrapper for set_upbo().
 
-    @return \a true if the operation was successful, \a false if there
-    was an error.
+    @return \a true if no errors.
 */
-#if 0
-LPSOLVE_SET_VARTYPE(set_binary)
-#endif
+static VALUE
+lpsolve_set_upbo(VALUE self, VALUE column, VALUE val) 
+{
+  int i_col = NUM2INT(column);
+  REAL r_val = NUM2DBL(val);
+  INIT_LP;
+  if (!index_ok(lp, __FUNCTION__, -1, i_col)) return Qfalse;
+  journal_note(self, lp, UNDO_UPBO, 0, i_col);
+  RETURN_BOOL(journal_done(self, set_upbo(lp, i_col, r_val), 1));
+}
 
-/** A wrapper for set_bounds().
+/** A wrapper for set_var_branch().
 
-    The set_bounds function sets a lower and upper bound on the
-    variable identified by column.  Setting a bound on a variable is
-    the way to go instead of adding an extra constraint (row) to the
-    model. Setting a bound doesn't increase the model size that means
-    that the model stays smaller and will be solved faster.  Note that
-    the default lower bound of each variable is 0. So variables will
-    never take negative values if no negative lower bound is set. The
-    default upper bound of a variable is infinity (well not quite. It
-    is a very big number. The value of get_infinite).
+    Sets which branch of \a column branch-and-bound explores first,
+    overriding set_floorfirst() for that column.
 
-   @return \a true if no errors.
+    @param self self
+    @param column a column number.
+    @param mode LPSolve::BRANCH_CEILING, BRANCH_FLOOR, BRANCH_AUTOMATIC,
+    or BRANCH_DEFAULT to go back to set_floorfirst().
+    @return \a true if no errors.
 */
 static VALUE
-lpsolve_set_bounds(VALUE self, VALUE column_num, VALUE lower_bound, 
-                   VALUE upper_bound)
+lpsolve_set_var_branch(VALUE self, VALUE column, VALUE mode)
 {
   INIT_LP;
-  if (TYPE(column_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not an integer.\n",
+  if (TYPE(column) != T_FIXNUM || TYPE(mode) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: Parameters must be integers.\n",
            __FUNCTION__);
     return Qfalse;
   }
-
-  RETURN_BOOL(set_bounds(lp, FIX2INT(column_num), 
-                         NUM2DBL(lower_bound), NUM2DBL(upper_bound)));
+  if (!index_ok(lp, __FUNCTION__, -1, FIX2INT(column))) return Qfalse;
+  RETURN_BOOL(set_var_branch(lp, FIX2INT(column), FIX2INT(mode)));
 }
 
-/** A wrapper for set_col_name
-    Returns a Ruby string column name.
+static REAL *packed_doubles(VALUE values, volatile VALUE *p_buf, long *p_n);
+
+/** A wrapper for set_var_weights().
+
+    Gives lp_solve a fixed branching order: branch-and-bound branches on
+    the column with the lowest weight first. This is decided natively,
+    so unlike lpsolve_put_bb_nodefunc() it costs nothing per node.
+
+    In Ruby, you can also use set_var_priority.
+
+    @param self self
+    @param weights one weight per column, as an Array of numbers or a
+    String of packed native doubles.
+    @return \a true if no errors.
 */
 static VALUE
-lpsolve_set_col_name(VALUE self, VALUE column_num, VALUE new_name) 
+lpsolve_set_var_weights(VALUE self, VALUE weights)
 {
+  volatile VALUE buf;
+  REAL *p_weights;
+  long n;
   INIT_LP;
-
-  if (TYPE(column_num) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not an integer.\n",
-           __FUNCTION__);
-    return Qnil;
+  p_weights = packed_doubles(weights, &buf, &n);
+  if (n != get_Ncolumns(lp)) {
+    report(lp, IMPORTANT, "%s: Need one weight for each of the %d columns.\n",
+           __FUNCTION__, get_Ncolumns(lp));
+    return Qfalse;
   }
+  RETURN_BOOL(set_var_weights(lp, p_weights));
+}
 
-  if (TYPE(new_name) != T_STRING) {
-    report(lp, IMPORTANT, 
-           "%s: new name, parameter 2, is not a string.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
+/** A wrapper for set_verbose().
 
-  return set_col_name(lp, FIX2INT(column_num), RSTRING_PTR(new_name)) ?
-    Qtrue: Qfalse;
-}
+    In Ruby, you can also use accessor function verbose=.
 
-/** A wrapper for set_debug
+    @param self
+    @param new_verbosity desired level of verbosity, an integer. @see 
+    lpsolve_get_verbose() for verbosity levels.
+    @return \a true unless we have an error.
+*/
+static VALUE lpsolve_set_verbose(VALUE self, VALUE new_verbosity);
+LPSOLVE_1_IN_STATUS_OUT(set_verbose, FIX2INT(param1))
 
-    Sets a flag if all intermediate results and the branch-and-bound
-    decisions must be printed while solving.
+/** A wrapper for solve().
 
-    @return \a true if no errors, false if an error (e.g. you didn't
-    pass true or false).
+    Optionally stops early, as decided natively in lp_solve's abort
+    function; lpsolve_get_termination() then tells which policy fired.
+    The gap and stall policies only apply once an incumbent has been
+    found. An early stop returns LPSolve::SUBOPTIMAL when there is an
+    incumbent, as with set_timeout().
+
+    @param self self
+    @param deadline stop after this many seconds, or at this Time.
+    @param gap stop once the incumbent is within this relative gap,
+    |incumbent - bound| / (1 + |incumbent|), of the bound on the MIP
+    objective.
+    @param stall_nodes stop once this many branch-and-bound nodes
+    went by without the incumbent improving.
+    @param stall_seconds stop once this many seconds went by without
+    the incumbent improving.
+    @returns 0 if no error.
 */
 static VALUE
-lpsolve_set_debug(VALUE self, VALUE new_bool) 
+lpsolve_solve(int argc, VALUE *argv, VALUE self) 
 {
-  if (new_bool != Qtrue && new_bool != Qfalse) {
-    return Qfalse;
+  VALUE opts, val;
+  abortfunc_t *p_abort = NULL;
+  callback_error_t cb_err = { 0, Qnil };
+  INIT_LP;
+  rb_scan_args(argc, argv, "0:", &opts);
+  rb_ivar_set(self, rb_intern("@termination"), Qnil);
+  if (NULL != lp) { 
+    VALUE status;
+    if (!NIL_P(opts)) {
+      double now = monotonic_seconds();
+      p_abort = abortfunc_holder(self, lp);
+      p_abort->deadline      = HUGE_VAL;
+      p_abort->gap           = -1;
+      p_abort->stall_nodes   = 0;
+      p_abort->stall_seconds = 0;
+      if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("deadline"))))) {
+        if (rb_obj_is_kind_of(val, rb_cTime))
+          val = rb_funcall(val, rb_intern("-"), 1, 
+                           rb_funcall(rb_cTime, rb_intern("now"), 0));
+        p_abort->deadline = now + NUM2DBL(val);
+      }
+      if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("gap")))))
+        p_abort->gap = NUM2DBL(val);
+      if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("stall_nodes")))))
+        p_abort->stall_nodes = NUM2LL(val);
+      if (!NIL_P(val = rb_hash_aref(opts, 
+                                    ID2SYM(rb_intern("stall_seconds")))))
+        p_abort->stall_seconds = NUM2DBL(val);
+      p_abort->b_incumbent = FALSE;
+      p_abort->fired       = POLICY_NONE;
+      p_abort->b_policy    = TRUE;
+    }
+    status = INT2FIX(callbacks_solve(self, lp, &cb_err));
+    rb_ivar_set(self, rb_intern("@status"), status);
+    if (NULL != p_abort) {
+      static const char *names[] = 
+        { NULL, "deadline", "gap", "stall_nodes", "stall_seconds" };
+      p_abort->b_policy = FALSE;
+      if (POLICY_NONE != p_abort->fired)
+        rb_ivar_set(self, rb_intern("@termination"), 
+                    ID2SYM(rb_intern(names[p_abort->fired])));
+    }
+    callbacks_raise(&cb_err);
+    return status;
   } else {
-    INIT_LP;
-    set_debug(lp, Qtrue == new_bool);
-    return Qtrue;
+    return Qnil;
   }
 }
 
-/** A wrapper for set_int
-
-    Set the type of the variable to be integer or floating point.
-    The default type of a variable is floating point. 
-
-    The argument \a new_bool specifies what the status of the variable
-    becomes. From the moment there is at least one integer variable in
-    the model, the Branch and Bound algorithm is used to make these
-    variables integer. Note that solving times can be considerably
-    larger when there are integer variables. 
+/* State of a with_overrides() call. */
+typedef struct {
+  VALUE self;
+  VALUE opts;
+  lprec *lp;
+  undo_log_t log;
+  journal_t *p_journal;
+} overrides_t;
 
-    @param self self
+static int
+overrides_index(lprec *lp, VALUE key, MYBOOL b_row)
+{
+  int index = NUM2INT(key);
+  int last = b_row ? get_Nrows(lp) : get_Ncolumns(lp);
+  if (index < 1 || index > last)
+    rb_raise(rb_eIndexError, "%s %d is not between 1 and %d", 
+             b_row ? "row" : "column", index, last);
+  return index;
+}
 
-    @param column_num column number of variable
+static void
+overrides_change(overrides_t *p_ov, undo_kind_t kind, int row, int col,
+                 REAL value)
+{
+  if (!undo_change(p_ov->lp, &p_ov->log, kind, row, col, value))
+    rb_raise(rb_eArgError, "lp_solve rejected the change of %s %d",
+             (UNDO_RH == kind) ? "row" : "column", 
+             (UNDO_RH == kind) ? row : col);
+}
 
-    @param new_bool \a true if you want the column (variable) to be an
-    integer, \a false or \a nil if you want the column not to take on
-    a floating-point value.  If no parameter is given, we assumed it
-    to be true (set to integer).
+static int
+overrides_bounds_i(VALUE key, VALUE val, VALUE arg)
+{
+  overrides_t *p_ov = (overrides_t *) arg;
+  int col = overrides_index(p_ov->lp, key, FALSE);
+  VALUE lower, upper;
+  Check_Type(val, T_ARRAY);
+  if (RARRAY_LEN(val) != 2)
+    rb_raise(rb_eArgError, "bounds of column %d must be [lower, upper]", col);
+  lower = rb_ary_entry(val, 0);
+  upper = rb_ary_entry(val, 1);
+  if (!NIL_P(lower)) overrides_change(p_ov, UNDO_LOWBO, 0, col, NUM2DBL(lower));
+  if (!NIL_P(upper)) overrides_change(p_ov, UNDO_UPBO, 0, col, NUM2DBL(upper));
+  return ST_CONTINUE;
+}
 
-    @param new_bool
+static int
+overrides_rhs_i(VALUE key, VALUE val, VALUE arg)
+{
+  overrides_t *p_ov = (overrides_t *) arg;
+  int row = overrides_index(p_ov->lp, key, TRUE);
+  overrides_change(p_ov, UNDO_RH, row, 0, NUM2DBL(val));
+  return ST_CONTINUE;
+}
 
-    @return \a true if the operation was successful, \a false if there
-    was an error.
-*/
-LPSOLVE_SET_VARTYPE(set_int)
+static int
+overrides_obj_i(VALUE key, VALUE val, VALUE arg)
+{
+  overrides_t *p_ov = (overrides_t *) arg;
+  int col = overrides_index(p_ov->lp, key, FALSE);
+  overrides_change(p_ov, UNDO_MAT, 0, col, NUM2DBL(val));
+  return ST_CONTINUE;
+}
 
-/** A wrapper for set_lp_name
+static int
+overrides_types_i(VALUE key, VALUE val, VALUE arg)
+{
+  overrides_t *p_ov = (overrides_t *) arg;
+  int col = overrides_index(p_ov->lp, key, FALSE);
+  MYBOOL b_int;
+  if (SYMBOL_P(val) && SYM2ID(val) == rb_intern("int"))       b_int = TRUE;
+  else if (SYMBOL_P(val) && SYM2ID(val) == rb_intern("real")) b_int = FALSE;
+  else if (Qtrue == val || Qfalse == val)                     b_int = RTEST(val);
+  else rb_raise(rb_eArgError, "type of column %d must be :int or :real", col);
+  overrides_change(p_ov, UNDO_INT, 0, col, b_int ? 1.0 : 0.0);
+  return ST_CONTINUE;
+}
 
-    Set the name of the lp. Returns true if the operation was
-    successful. A return value of false indicates an error.
-*/
-static VALUE lpsolve_set_lp_name(VALUE self, VALUE model_name);
-LPSOLVE_1_STR_IN_BOOL_OUT(set_lp_name)
+static void
+overrides_each(overrides_t *p_ov, const char *key, 
+               int (*func)(VALUE, VALUE, VALUE))
+{
+  VALUE hash = rb_hash_aref(p_ov->opts, ID2SYM(rb_intern(key)));
+  if (NIL_P(hash)) return;
+  Check_Type(hash, T_HASH);
+  rb_hash_foreach(hash, func, (VALUE) p_ov);
+}
+
+static VALUE
+overrides_body(VALUE arg)
+{
+  overrides_t *p_ov = (overrides_t *) arg;
+  if (!NIL_P(p_ov->opts)) {
+    overrides_each(p_ov, "bounds", overrides_bounds_i);
+    overrides_each(p_ov, "rhs",    overrides_rhs_i);
+    overrides_each(p_ov, "obj",    overrides_obj_i);
+    overrides_each(p_ov, "types",  overrides_types_i);
+  }
+  return rb_yield(p_ov->self);
+}
 
-/** A wrapper for set_lowbo().
-    @return \a true if no errors.
-*/
 static VALUE
-lpsolve_set_lowbo(VALUE self, VALUE column, VALUE val) 
+overrides_restore(VALUE arg)
 {
-  INIT_LP;
-  if (TYPE(column) != T_FIXNUM) {
-    report(lp, IMPORTANT, 
-           "%s: column number, parameter 1, is not an integer.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
-  RETURN_BOOL(set_lowbo(lp, FIX2INT(column), NUM2DBL(val)));
+  overrides_t *p_ov = (overrides_t *) arg;
+  undo_rollback(p_ov->lp, &p_ov->log, 0);
+  free(p_ov->log.entries);
+  p_ov->p_journal->overrides--;
+  return Qnil;
 }
 
-/** A wrapper for set_mat().
-    @return \a true if no errors.
+/** Apply a few changes to the model, run the block, and put back
+    exactly the values that were changed, even if the block raises.
+
+    Nothing is copied: each change records the value it overwrote in
+    a native undo log, and only those entries are restored afterwards,
+    newest first. This suits many short requests against one large
+    shared model. The last solution stays available after the block.
+
+    In Ruby:
+    \verbatim
+      lp.with_overrides(bounds: {3 => [0, 10]}, rhs: {1 => 40.0},
+                        obj: {2 => -1.5}, types: {4 => :int}) do |lp|
+        lp.solve
+        lp.objective
+      end
+    \endverbatim
+
+    Each option is a Hash keyed by column number (row number for \a
+    :rhs). A bound given as nil is left alone; a type is \a :int or
+    \a :real.
+
+    The undo log refers to rows and columns by number, so methods that
+    renumber them or cannot be undone, such as del_column,
+    del_constraint, shift_horizon and presolve_once, fail inside the
+    block, as they do inside lpsolve_transaction().
+
+    @param self self
+    @return the value of the block.
 */
 static VALUE
-lpsolve_set_mat(VALUE self, VALUE row, VALUE column, VALUE val) 
+lpsolve_with_overrides(int argc, VALUE *argv, VALUE self)
 {
+  overrides_t ov;
   INIT_LP;
-  RETURN_BOOL(set_mat(lp, FIX2INT(row), FIX2INT(column), NUM2DBL(val)));
+  rb_need_block();
+  memset(&ov, 0, sizeof(ov));
+  rb_scan_args(argc, argv, "0:", &ov.opts);
+  ov.self = self;
+  ov.lp   = lp;
+  ov.p_journal = journal_get(self, TRUE);
+  ov.p_journal->overrides++;
+  return rb_ensure(overrides_body, (VALUE) &ov, overrides_restore, (VALUE) &ov);
 }
 
-/** A wrapper for set_maxim().
-
-    Sets the objective direction to maximize. The default is to
-    minimize, except when reading a model in via lpsolve_read_LP. 
+/** Run a block as a transaction on the model.
 
-    @return \a true unless we have an error.
-*/
-static VALUE lpsolve_set_maxim(VALUE self);
-LPSOLVE_0_IN_STATUS_OUT(set_maxim)
+    While the block runs, every change made through set_bounds,
+    set_lowbo, set_upbo, set_rh, set_rh_range, set_mat, set_obj_fnex,
+    str_set_obj_fn, set_int, set_binary, set_semicont, set_maxim,
+    set_minim, add_constraintex, str_add_constraint and str_add_column
+    records what it overwrote in a native journal. If the block raises,
+    the journal is played back, newest change first, and the model is
+    as it was before the block; the exception is then re-raised,
+    except for LPSolve::Rollback, which just rolls back. Otherwise the
+    changes are kept and the journal dropped. Either way the cost is
+    proportional to the number of changes, not to the model size.
 
-/** A wrapper for set_minim().
+    Transactions nest: an inner block that raises rolls back only its
+    own changes. Leaving the block with break or throw commits.
 
-    Sets the objective direction to minimize. The default is to
-    minimize, except when reading a model in via lpsolve_read_LP. 
+    Deleting rows or columns and adding SOS constraints cannot be
+    rolled back, so del_column, del_constraint and add_SOS fail inside
+    a transaction. Names and solver parameters are not journaled.
+    Rolling back a row added in row entry mode turns that mode off.
 
-    @return \a true unless we have an error.
+    @param self self
+    @return the value of the block, or \a nil after LPSolve::Rollback.
 */
-static VALUE lpsolve_set_minim(VALUE self);
-LPSOLVE_0_IN_STATUS_OUT(set_minim)
-
-/** A wrapper for set_mip_gap().
+static VALUE
+lpsolve_transaction(VALUE self)
+{
+  VALUE ret, err;
+  journal_t *p_journal;
+  long mark;
+  int state = 0;
 
-   Sets the MIP gap that specifies a tolerance for the branch and bound
-   algorithm. This tolerance is the difference between the best-found
-   solution yet and the current solution. If the difference is smaller
-   than this tolerance then the solution (and all the sub-solutions) is
-   rejected. This can result in faster solving times, but results in a
-   solution which is not the perfect solution. So be careful with this
-   tolerance.  The default mip_gap value is 1e-9
+  INIT_LP;
+  rb_need_block();
+  p_journal = journal_get(self, TRUE);
+
+  mark = p_journal->log.n;
+  p_journal->depth++;
+  ret = rb_protect(rb_yield, self, &state);
+  p_journal->depth--;
+
+  if (state) {
+    if (PROTECT_TAG_RAISE != state) {
+      /* break, return or throw: keep the changes. */
+      if (0 == p_journal->depth) p_journal->log.n = 0;
+      rb_jump_tag(state);
+    }
+    err = rb_errinfo();
+    undo_rollback(lp, &p_journal->log, mark);
+    if (!rb_obj_is_kind_of(err, rb_eLPSolveRollback)) rb_jump_tag(state);
+    rb_set_errinfo(Qnil);
+    return Qnil;
+  }
+  if (0 == p_journal->depth) p_journal->log.n = 0;
+  return ret;
+}
 
+/** A wrapper for str_add_column().
 
-   @param self self
-   @param abs_rel: set to true if the gap is absolute, or false for relative.
-   @param val: gap value. The default mip_gap is 1e-9.
-   @return \a true if no errors.
+    @return \a true if the operation was successful. A false value
+    indicates an error.
 */
 static VALUE
-lpsolve_set_mip_gap(VALUE self, VALUE abs_rel, VALUE val) 
+lpsolve_str_add_column(VALUE self, VALUE col_str)
 {
   INIT_LP;
-  if (abs_rel != Qtrue && abs_rel != Qfalse && abs_rel != Qnil) {
+  if (TYPE(col_str) != T_STRING) {
     report(lp, IMPORTANT,
-           "%s: Parameter is not a boolean or nil.\n",
+           "%s: Parameter 1 is not a string\n",
            __FUNCTION__);
     return Qfalse;
-  } else {
-    set_mip_gap(lp, Qtrue == abs_rel, NUM2DBL(val));
-    return Qtrue;
   }
+  if (!str_add_column(lp, RSTRING_PTR(col_str))) return Qfalse;
+  journal_note(self, lp, UNDO_ADD_COL, 0, lp->columns);
+  return Qtrue;
+}
+
+/** A wrapper for str_add_constraint().
+    @return boolean
+*/
+static VALUE
+lpsolve_str_add_constraint(VALUE self, VALUE constraint, 
+                          VALUE compare, VALUE num_constraints) 
+{
+  char *psz_constraint = RSTRING_PTR(constraint);
+  int  i_compare = NUM2INT(compare);
+  int  i_constraints = NUM2INT(num_constraints);
+  lprec *lp;
+  Data_Get_Struct(self, lprec, lp);
+  if (!str_add_constraint(lp, psz_constraint, i_compare, i_constraints))
+    return Qfalse;
+  journal_note(self, lp, UNDO_ADD_ROW, lp->rows, 0);
+  return Qtrue;
 }
 
 /** A wrapper for str_set_obj_fn().
 
-    Set the objective function (row 0) of the matrix.
+    Set the objective function (row 0) of the matrix via a string.
 
-    @return \a true unless we have an error, then \a nil or \a false.
+    @return \a true unless we have an error.
 */
 static VALUE
-lpsolve_set_obj_fnex(VALUE self, VALUE row_coeffs) 
+lpsolve_str_set_obj_fn(VALUE self, VALUE obj_fn) 
 {
-  REAL *row = NULL;
-  int *colno = NULL;
-  long int i, count;
-  VALUE ret = Qnil;
-  VALUE *p_row_coeff = NULL;
+  char *psz_obj_fn = RSTRING_PTR(obj_fn);
+  lprec *lp;
+  REAL *old_obj;
+  MYBOOL b_ret;
+  Data_Get_Struct(self, lprec, lp);
+  old_obj = journal_objective_begin(self, lp);
+  b_ret = str_set_obj_fn(lp, psz_obj_fn);
+  journal_objective_end(self, lp, old_obj);
+  RETURN_BOOL(b_ret);
+}
 
-  INIT_LP;
+/** A wrapper for time_elapsed(). 
 
-  /***FIXME: combine common parts of this with add_constraintex ****/
-  if (TYPE(row_coeffs) != T_ARRAY) {
-    report(lp, IMPORTANT, 
-           "%s: row coefficients parameter is not an array.\n",
-           __FUNCTION__);
-    return Qnil;
-  }
+    The time_elapsed function returns the time in seconds since solve
+    and lag_solve has started. In contrast to totaltime, the time does
+    not include the load time. If solving has not completed he value
+    will be the number of seconds of until the time of the call
+    rather than the time the solve completed.
 
-  count   = RARRAY_LEN(row_coeffs);
-  colno   = ALLOC_N(int, count);
-  row     = ALLOC_N(REAL, count);
+    @param  self self.
 
-  p_row_coeff = RARRAY_PTR(row_coeffs);
-  for (i = 0; i < count; i++) {
-    int i_col;
-    if (TYPE(*p_row_coeff) != T_ARRAY) {
-      report(lp, IMPORTANT, 
-             "%s: row coeffient element %d is not an array.\n", 
-             __FUNCTION__, i);
-      goto done;
-    }
-    if (RARRAY_LEN(*p_row_coeff) != 2) {
-      report(lp, IMPORTANT, 
-             "%s: row coeffient element %d is not an array tuple.\n", 
-             __FUNCTION__, i);
-      goto done;
-    } else {
-      VALUE *tuple = RARRAY_PTR(*p_row_coeff);
-      if (TYPE(tuple[0]) != T_FIXNUM) {
-        report(lp, IMPORTANT, 
-               "%s: Column number, first element, of row coefficients at " \
-               "tuple %d is not a integer.\n", __FUNCTION__, i);
-        goto done;
-      }
-      switch (TYPE(tuple[1])) {
-      case T_FIXNUM:
-      case T_FLOAT: break;
-      default:
-        report(lp, IMPORTANT, 
-               "%s: Coefficient value, second element, of row coeffients at "
-               "tuple %d is not an integer.\n", __FUNCTION__, i);
-        goto done;
-      }
+    @return \a Floating-point number for time since solve and
+    lag_solve has started
+*/
+static VALUE lpsolve_time_elapsed(VALUE self);
+LPSOLVE_0_IN_NUM_OUT(time_elapsed);
 
-      i_col = FIX2INT(tuple[0]);
-      if (i_col <= 0 || i_col > lp->columns) {
-        report(lp, IMPORTANT, 
-               "%s: Column number, first element, of row coeffients at " \
-               "tuple %d is in the range 1..%d\n", 
-               __FUNCTION__, i, lp->columns);
-        goto done;
-      }
-      colno[i] = i_col;
-      row[i]   = NUM2DBL(tuple[1]);
-    }
-    p_row_coeff++;
-  }
+/** \fn time_load Return the amount of time used to load in data
 
-  ret = set_obj_fnex(lp, count, row, colno) ? Qtrue : Qfalse ;
+    @param self self
 
- done:
-  free(row);
-  free(colno);
-  return ret;
+    @return A Ruby floating-point number indicating how long the
+    presolver solver took.
 
-}
+*/
+static VALUE lpsolve_time_load(VALUE self) ;
+LPSOLVE_0_IN_TIME_OUT(time_load, timecreate, timestart);
 
-/** A wrapper for set_outputfile(). 
+/** Return the amount of time used in the simplex solver
 
-    @return \a true if we could set the output file.
+    @param self self
+
+    @return A Ruby floating-point number indicating how long the
+    simplex solver took.
+
+    This only makes sense if a problem was solved. See also
+    the status instance variable.
+
+    In Ruby, you can also use accessor function simplextime
 */
-static VALUE lpsolve_set_outputfile(VALUE self, VALUE filename);
-LPSOLVE_1_STR_IN_BOOL_OUT(set_outputfile)
+static VALUE lpsolve_time_simplex(VALUE self) ;
+LPSOLVE_0_IN_TIME_OUT(time_simplex, timepresolved, timeend);
 
-/** A wrapper for set_presolve(). 
+/** \fn time_presolve
+    Return the amount of time used in the presolver
 
-    @return \a true if no errors.
+    @param self self
+
+    @return A Ruby floating-point number indicating how long the
+    presolver solver took.
+
+    This only makes sense if a problem was solved. See also
+    the status instance variable.
+
+    In Ruby, you can also use accessor function simplextime
 */
-static VALUE lpsolve_set_presolve(VALUE self, VALUE do_presolve, 
-                                  VALUE maxloops) 
-{
-  INIT_LP;
-  if (TYPE(do_presolve) != T_FIXNUM) {
-    report(lp, IMPORTANT, "%s: Presolve parameter is not a number (bitmask).\n",
-           __FUNCTION__);
-    return Qnil;
-  }
-  if (TYPE(maxloops) != T_FIXNUM ) {
-    report(lp, IMPORTANT, 
-           "%s: maxloops parameter should be a number (bitmask).\n",
-           __FUNCTION__);
-    return Qnil;
-  }
-  set_presolve(lp, FIX2INT(do_presolve), FIX2INT(maxloops));
-  return Qtrue;
-}
+static VALUE lpsolve_time_presolve(VALUE self) ;
+LPSOLVE_0_IN_TIME_OUT(time_presolve, timestart, timepresolved);
 
+/** Return the total amount elapsed time from start to finish.
 
-/** A wrapper for set_presolve(). 
+    @param self self
 
-    @return \a true if no errors.
+    @return A Ruby floating-point number indicating how long the
+    simplex solver took.
+
+    This only makes sense if a problem was solved. See also
+    the status instance variable.
 */
-static VALUE lpsolve_set_presolve1(VALUE self, VALUE do_presolve)
-{
-  int i_maxloops;
-  INIT_LP;
-  if (TYPE(do_presolve) != T_FIXNUM) {
-    report(lp, IMPORTANT, "%s: Presolve parameter is not a number (bitmask).\n",
-           __FUNCTION__);
-    return Qnil;
-  }
-  i_maxloops = get_presolveloops(lp);
-  set_presolve(lp, FIX2INT(do_presolve), i_maxloops);
-  return Qtrue;
-}
+static VALUE lpsolve_time_total(VALUE self) ;
+LPSOLVE_0_IN_TIME_OUT(time_total, timecreate, timeend);
 
-#if GET_RH_FIXED
-/** A wrapper for get_rh().
+/** A wrapper for solve_unscale().
 
-    Get the value of the right hand side (RHS) vector (column 0) for
-    the specified row.
+    The get_bb_rule function returns the branch-and-bound rule for
+    choosing which non-integer variable is to be selected. This rule
+    can influence solving times considerably. Depending on the model
+    one rule can be best and for another model another rule.  The
+    default is NODE_PSEUDONONINTSELECT + NODE_GREEDYMODE +
+    NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
 
     @param self self
-    @param row_num the row number of the RHS to be retrieved
-    Must be between 0 and number of rows in the lp.
+    @return  Returns the branch-and-bound rule.
 
 */
-static VALUE
-lpsolve_get_rh(VALUE self, VALUE row_num)
-{
-  LPSOLVE_1_IN_NUM_OUT(get_rh, T_FIXNUM, "an integer", FIX2INT);
-}
-#endif
+static VALUE lpsolve_unscale(VALUE self);
+LPSOLVE_0_IN_STATUS_OUT(unscale)
 
-/** A wrapper for set_rh().
+/** Return the model in LP format as a Ruby String.
 
-    (Re)Set the value of the right hand side (RHS) vector (column 0) for 
-    the specified row.
+    Nothing is written to disk; output is gathered as lp_solve
+    produces it. Note that row entry mode must be off, else this
+    function fails. @see lpsolve_set_add_rowmode()
 
     @param self self
-    @param row_num the row number for which the RHS is to be must be set. 
-    Must be between 0 and number of rows in the lp.
-
-    @param value The value to set the RHS to.
-
-    @return \a true of no error, or \a nil if there was an error.
+    @return the LP-format text, or \a nil if there was an error.
 */
 static VALUE
-lpsolve_set_rh(VALUE self, VALUE row_num, VALUE value) 
+lpsolve_to_lp_string(VALUE self)
 {
+  VALUE str = rb_str_buf_new(0);
   INIT_LP;
-  set_rh(lp, FIX2INT(row_num), NUM2DBL(value));
-  return Qnil;
+  return write_model_rb(lp, write_LP, str) ? str : Qnil;
 }
 
-/** A wrapper for set_rh_range().
-
-   Set a range on the constraint (row) identified by row.  Setting a
-   range on a row is the way to go instead of another constraint (row) to
-   the model. (Note that in either case, there are two API calls 
-   to set the lower and upper bound. 
+/** Return the model in (fixed) MPS format as a Ruby String.
 
-   Setting a range doesn't increase the model size, and that means
-   that the model stays smaller and will be solved faster.  If the row
-   previously had a less-than constraint, then the range means setting
-   a minimum on the constraint that is equal to the RHS value minus
-   the range. If the row has a greater-than constraint then the range
-   means setting a maximum on the constraint that is equal to the RHS
-   value plus the range.  Note that the range value is the difference
-   value and not the absolute value.  Set the value of the right hand
-   side (RHS) vector (column 0) for the specified row.
+    Nothing is written to disk; output is gathered as lp_solve
+    produces it. Note that row entry mode must be off, else this
+    function fails. @see lpsolve_set_add_rowmode()
 
     @param self self
-    @param row_num the row number for which the RHS is to be must be set. 
-    Must be between 0 and number of rows in the lp.
-
-    @param value The value to set the RHS to.
-
-    @return \a true of no error, or \a nil if there was an error.
+    @return the MPS-format text, or \a nil if there was an error.
 */
 static VALUE
-lpsolve_set_rh_range(VALUE self, VALUE row_num, VALUE deltavalue) 
+lpsolve_to_mps_string(VALUE self)
 {
+  VALUE str = rb_str_buf_new(0);
   INIT_LP;
-  RETURN_BOOL(set_rh_range(lp, FIX2INT(row_num), NUM2DBL(deltavalue)));
+  return write_model_rb(lp, write_MPS, str) ? str : Qnil;
 }
 
-/** A wrapper for set_row_name.
-
-    Set the name of a constraint (row) in the lp.
-
-    @return \a true if the operation was successful, false if not.
+/** A wrapper for lp_solve_version(). 
+    @return 4-tuple: [major_version, minor_version, release, build]
 */
-static VALUE 
-lpsolve_set_row_name(VALUE self, VALUE row_num, VALUE new_name) 
+static VALUE
+lpsolve_version(VALUE module_or_class) 
 {
-  INIT_LP;
-
-  if (TYPE(new_name) != T_STRING) {
-    return Qfalse;
-  }
-
-  RETURN_BOOL(set_row_name(lp, FIX2INT(row_num), RSTRING_PTR(new_name)));
+  int major_version;
+  int minor_version;
+  int release;
+  int build;
+  lp_solve_version(&major_version, &minor_version, &release, &build);
+  return rb_ary_new3(4, 
+                     INT2FIX(major_version), INT2FIX(minor_version),
+                     INT2FIX(release), INT2FIX(build));
 }
 
-/** A wrapper for set_semicont().
-
-Set the type of the variable (column) to be semi-continuous or not. By
-default, a variables are not semi-continuous. Note that a
-semi-continuous variable should have a nonzero lower bound to for this
-to have different effect. Recall that the default lower bound on
-variables is zero. The lower bound may be set before or after setting
-the semi-continuous status. 
-
-    @param self self
+/* Convert a basis given as a packed String of native ints or as an
+   Array of Integers to an int array for set_basis(). Its length tells
+   whether nonbasic variables are included. Return NULL after a report
+   if the length is wrong. */
+static int *
+basis_from_value(lprec *lp, VALUE basis, MYBOOL *p_nonbasic)
+{
+  long n_basic = 1 + get_Nrows(lp), n_full = n_basic + get_Ncolumns(lp);
+  long n, i;
+  int *bascolumn;
 
-    @param column_num column number of the variable
+  if (TYPE(basis) == T_STRING) {
+    if (0 != RSTRING_LEN(basis) % sizeof(int)) n = -1;
+    else n = RSTRING_LEN(basis) / sizeof(int);
+  } else {
+    Check_Type(basis, T_ARRAY);
+    n = RARRAY_LEN(basis);
+  }
+  if (n != n_basic && n != n_full) {
+    report(lp, IMPORTANT, 
+           "%s: basis must have %ld or %ld entries.\n",
+           __FUNCTION__, n_basic, n_full);
+    return NULL;
+  }
+  bascolumn = ALLOC_N(int, n_full);
+  if (TYPE(basis) == T_STRING) {
+    memcpy(bascolumn, RSTRING_PTR(basis), n * sizeof(int));
+  } else {
+    for (i = 0; i < n; i++) {
+      VALUE entry = rb_ary_entry(basis, i);
+      if (!FIXNUM_P(entry)) {
+        free(bascolumn);
+        rb_raise(rb_eTypeError, "basis entry %ld is not an Integer", i);
+      }
+      bascolumn[i] = FIX2INT(entry);
+    }
+  }
+  *p_nonbasic = (n == n_full);
+  return bascolumn;
+}
 
-    @param new_bool true if you want the column (variable) to be a
-    semi-continuous value, \a false or \a nil if you want the column
-    not to take on a floating-point value. If no parameter specified,
-    \a true is assumed
+/** A wrapper for get_basis().
 
-    @return \a true if the operation was successful, \a false if there
-    was an error.
-*/
-LPSOLVE_SET_VARTYPE(set_semicont)
+    Returns the current basis in memory, for a later set_basis() on
+    this or a similar model, e.g. to warm start a re-optimization
+    without writing a basis file. Entry 0 is unused; entries 1 to rows
+    (and on to rows + columns with \a nonbasic) give the basic (and
+    nonbasic) variables, negative if at their lower bound, as
+    documented for lp_solve's get_basis.
 
-/** 
-    return the status status code of the last solve.
     @param self self
-    @return A return status number of the last solve.
+    @param nonbasic if \a true, include the nonbasic variables.
+    @return the basis as a String of packed native ints (unpack it
+    with "i*"), or \a nil if there is no basis.
 */
-static VALUE lpsolve_set_status(VALUE self, VALUE newstatus) 
+static VALUE
+lpsolve_get_basis(int argc, VALUE *argv, VALUE self)
 {
+  VALUE nonbasic, basis = Qnil;
+  int size;
+  int *bascolumn;
   INIT_LP;
-  if (FIXNUM_P(newstatus))
-    return rb_ivar_set(self, rb_intern("@status"), newstatus);
-  else
-    report(lp, IMPORTANT, 
-           "%s: status should be a Fixnum.\n", __FUNCTION__);
-  return Qnil;
+  rb_scan_args(argc, argv, "01", &nonbasic);
+  size = 1 + get_Nrows(lp) + (RTEST(nonbasic) ? get_Ncolumns(lp) : 0);
+  bascolumn = ALLOC_N(int, size);
+  if (get_basis(lp, bascolumn, RTEST(nonbasic)))
+    basis = rb_str_new((char *) bascolumn, size * sizeof(int));
+  free(bascolumn);
+  return basis;
 }
 
+/** A wrapper for set_basis().
 
-/** A wrapper for set_timeout().
-
-    In Ruby, you can also use accessor function timeout=.
-
-    The solve() and lag_solve() methods may not last longer than this
-    time or the routines return with a timeout. The default timeout is
-    0, resulting in no timeout.  If a timout occurs, but there was
-    already an integer solution found (that is possibly not the best),
-    then solve will return LPSolve::SUBOPTIMAL. If there was no integer
-    solution found yet or there are no integers or the solvers is
-    still in the first phase where a REAL optimal solution is searched
-    for, then solve will return TIMEOUT.
+    Sets the starting basis of the next solve, e.g. the one from
+    get_basis() after the previous solve of a slightly different
+    model, so that solving restarts from there.
 
-    Set a timeout for solving .
     @param self self
-    @param sec_timeout floating-point timeout value in seconds.
-    @return nil.
+    @param basis a String from get_basis() or guess_basis(), or an
+    Array of Integers laid out the same way. Its length, 1 + rows or 1
+    + rows + columns, tells whether nonbasic variables are included.
+    @return \a true if the basis was accepted.
 */
 static VALUE
-lpsolve_set_timeout(VALUE self, VALUE sec_timeout) 
+lpsolve_set_basis(VALUE self, VALUE basis)
 {
+  MYBOOL b_nonbasic, b_ret;
+  int *bascolumn;
   INIT_LP;
-  set_timeout(lp, NUM2DBL(sec_timeout));
-  return Qnil;
+  bascolumn = basis_from_value(lp, basis, &b_nonbasic);
+  if (NULL == bascolumn) return Qfalse;
+  b_ret = set_basis(lp, bascolumn, b_nonbasic);
+  free(bascolumn);
+  RETURN_BOOL(b_ret);
 }
 
-/** A wrapper for set_scaling().
+/** A wrapper for guess_basis().
 
-    Specifies which scaling algorithm must be used. 
+    Derives a starting basis from a known primal point, e.g. last
+    period's solution, to be passed to set_basis().
 
-    @return nil.
+    @param self self
+    @param solution the value of each column, as an Array of numbers
+    or a String of packed native doubles (pack it with "d*").
+    @return the basis, with nonbasic variables, as a String of packed
+    native ints, or \a nil on error.
 */
 static VALUE
-lpsolve_set_scaling(VALUE self, VALUE new_scalemode) 
+lpsolve_guess_basis(VALUE self, VALUE solution)
 {
+  int rows, columns, j;
+  REAL *guessvector;
+  int *basisvector;
+  VALUE basis = Qnil;
   INIT_LP;
-  set_scaling(lp, FIX2INT(new_scalemode));
-  return Qnil;
-}
-
-/** A wrapper for set_simplextype().
 
-    In Ruby, you can also use accessor function simplextype=.
+  rows = get_Nrows(lp);
+  columns = get_Ncolumns(lp);
+  if (TYPE(solution) == T_STRING) {
+    if (RSTRING_LEN(solution) != (long) (columns * sizeof(double))) {
+      report(lp, IMPORTANT, "%s: solution must have %d doubles.\n",
+             __FUNCTION__, columns);
+      return Qnil;
+    }
+  } else {
+    Check_Type(solution, T_ARRAY);
+    if (RARRAY_LEN(solution) != columns) {
+      report(lp, IMPORTANT, "%s: solution must have %d values.\n",
+             __FUNCTION__, columns);
+      return Qnil;
+    }
+    for (j = 0; j < columns; j++) 
+      (void) NUM2DBL(rb_ary_entry(solution, j));
+  }
 
-    @param self
-    @param new_simplextype desired level of verbosity, an integer. @see 
-    lpsolve_get_simplextype() for simplex types.
-    @return nil on error. 
-*/
-static VALUE lpsolve_set_simplextype(VALUE self, VALUE new_simplextype);
-LPSOLVE_1_IN_STATUS_OUT(set_simplextype, FIX2INT(param1))
+  /* Element 0 is unused. */
+  guessvector = ALLOC_N(REAL, 1 + rows + columns);
+  basisvector = ALLOC_N(int, 1 + rows + columns);
+  memset(guessvector, 0, (1 + rows + columns) * sizeof(REAL));
+  for (j = 0; j < columns; j++) {
+    if (TYPE(solution) == T_STRING) {
+      double val;
+      memcpy(&val, RSTRING_PTR(solution) + j * sizeof(double), sizeof(val));
+      guessvector[j + 1] = val;
+    } else
+      guessvector[j + 1] = NUM2DBL(rb_ary_entry(solution, j));
+  }
+  if (guess_basis(lp, guessvector, basisvector))
+    basis = rb_str_new((char *) basisvector, 
+                       (1 + rows + columns) * sizeof(int));
+  free(guessvector);
+  free(basisvector);
+  return basis;
+}
 
-/** A wrapper for set_solutionlimit().
+/* Return the numbers in values, an Array of numbers or a String of
+   packed native doubles, as a REAL array in a String kept in *p_buf,
+   and their count in *p_n. */
+static REAL *
+packed_doubles(VALUE values, volatile VALUE *p_buf, long *p_n)
+{
+  REAL *p_vec;
+  long i, n;
+  if (TYPE(values) == T_STRING) {
+    if (0 != RSTRING_LEN(values) % sizeof(double))
+      rb_raise(rb_eArgError, "packed values must be whole doubles");
+    n = RSTRING_LEN(values) / sizeof(double);
+    *p_buf = rb_str_new(NULL, n * sizeof(REAL));
+    p_vec = (REAL *) RSTRING_PTR(*p_buf);
+    for (i = 0; i < n; i++) {
+      double val;
+      memcpy(&val, RSTRING_PTR(values) + i * sizeof(double), sizeof(val));
+      p_vec[i] = val;
+    }
+  } else {
+    Check_Type(values, T_ARRAY);
+    n = RARRAY_LEN(values);
+    *p_buf = rb_str_new(NULL, n * sizeof(REAL));
+    p_vec = (REAL *) RSTRING_PTR(*p_buf);
+    for (i = 0; i < n; i++) 
+      p_vec[i] = NUM2DBL(rb_ary_entry(values, i));
+  }
+  *p_n = n;
+  return p_vec;
+}
 
-    Sets the solution number that must be returned.
+/* Like packed_doubles(), for an Array of Integers or a String of
+   packed native ints. */
+static int *
+packed_ints(VALUE values, volatile VALUE *p_buf, long *p_n)
+{
+  int *p_vec;
+  long i, n;
+  if (TYPE(values) == T_STRING) {
+    if (0 != RSTRING_LEN(values) % sizeof(int))
+      rb_raise(rb_eArgError, "packed values must be whole ints");
+    n = RSTRING_LEN(values) / sizeof(int);
+    *p_buf = rb_str_new(RSTRING_PTR(values), n * sizeof(int));
+    p_vec = (int *) RSTRING_PTR(*p_buf);
+  } else {
+    Check_Type(values, T_ARRAY);
+    n = RARRAY_LEN(values);
+    *p_buf = rb_str_new(NULL, n * sizeof(int));
+    p_vec = (int *) RSTRING_PTR(*p_buf);
+    for (i = 0; i < n; i++) 
+      p_vec[i] = NUM2INT(rb_ary_entry(values, i));
+  }
+  *p_n = n;
+  return p_vec;
+}
 
-    This function is only valid if there are integer, semi-continious
-    or SOS variables in the model so that the branch-and-bound
-    algoritm is used. If there are more solutions with the same
-    objective value, then this number specifies which solution must be
-    returned. This can be used to retrieve all possible
-    solutions. Start with 1 till get_solutioncount 
+/** What lpsolve_sweep_rhs() and lpsolve_sweep_obj() vary. */
+typedef enum { SWEEP_RHS, SWEEP_OBJ } sweep_kind_t;
 
-    @param self
-    @param limit number of solutions needed
-    @return nil on error. 
+/* Solve lp once per value in values, with the right-hand side of row
+   \a index (SWEEP_RHS) or the objective coefficient of column \a
+   index (SWEEP_OBJ) set to it, and put back the old value afterwards. */
+static VALUE
+sweep(VALUE self, sweep_kind_t kind, VALUE index, VALUE values)
+{
+  volatile VALUE values_buf, basis_buf;
+  VALUE objective, status, breakpoints, result;
+  REAL *p_values, old_value;
+  int *prev_basis, *basis;
+  int i_index, basis_size, i_status = NOTRUN;
+  MYBOOL b_have_prev = FALSE;
+  callback_error_t cb_err = { 0, Qnil };
+  long i, n;
 
-@return nil.
-*/
-static VALUE lpsolve_set_solutionlimit(VALUE self, VALUE limit);
-LPSOLVE_1_IN_STATUS_OUT(set_solutionlimit, FIX2INT(param1))
+  INIT_LP;
+  if (TYPE(index) != T_FIXNUM) {
+    report(lp, IMPORTANT, "%s: index, parameter 1, is not an integer.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+  i_index = FIX2INT(index);
+  if ((SWEEP_RHS == kind && (i_index < 0 || i_index > get_Nrows(lp))) ||
+      (SWEEP_OBJ == kind && (i_index < 1 || i_index > get_Ncolumns(lp)))) {
+    report(lp, IMPORTANT, "%s: %s %d is out of range.\n", __FUNCTION__,
+           (SWEEP_RHS == kind) ? "row" : "column", i_index);
+    return Qnil;
+  }
+  p_values = packed_doubles(values, &values_buf, &n);
+
+  basis_size = 1 + get_Nrows(lp) + get_Ncolumns(lp);
+  basis_buf = rb_str_new(NULL, 2 * basis_size * sizeof(int));
+  prev_basis = (int *) RSTRING_PTR(basis_buf);
+  basis = prev_basis + basis_size;
+  objective   = rb_ary_new2(n);
+  status      = rb_ary_new2(n);
+  breakpoints = rb_ary_new();
+
+  old_value = (SWEEP_RHS == kind) ? get_rh(lp, i_index) 
+    : get_mat(lp, 0, i_index);
+  for (i = 0; i < n; i++) {
+    /* lp_solve restarts from the basis the previous solve ended with. */
+    if (SWEEP_RHS == kind) set_rh(lp, i_index, p_values[i]);
+    else set_mat(lp, 0, i_index, p_values[i]);
+    i_status = callbacks_solve(self, lp, &cb_err);
+    if (0 != cb_err.state) break;
+    rb_ary_push(status, INT2FIX(i_status));
+    switch (i_status) {
+    case OPTIMAL:
+    case SUBOPTIMAL:
+    case PRESOLVED:
+      rb_ary_push(objective, rb_float_new(get_objective(lp)));
+      break;
+    default:
+      rb_ary_push(objective, Qnil);
+    }
+    if (get_basis(lp, basis, TRUE)) {
+      int *swap;
+      if (b_have_prev && 0 != memcmp(basis, prev_basis, 
+                                     basis_size * sizeof(int)))
+        rb_ary_push(breakpoints, LONG2NUM(i));
+      swap = prev_basis; prev_basis = basis; basis = swap;
+      b_have_prev = TRUE;
+    } else
+      b_have_prev = FALSE;
+  }
+  if (SWEEP_RHS == kind) set_rh(lp, i_index, old_value);
+  else set_mat(lp, 0, i_index, old_value);
+  if (n > 0) rb_ivar_set(self, rb_intern("@status"), INT2FIX(i_status));
+  callbacks_raise(&cb_err);
+
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("objective")), objective);
+  rb_hash_aset(result, ID2SYM(rb_intern("status")), status);
+  rb_hash_aset(result, ID2SYM(rb_intern("breakpoints")), breakpoints);
+  return result;
+}
 
-/** A wrapper for set_trace
+/** Parametric analysis of a right-hand side.
 
-    Sets a flag if pivot selection must be printed while solving.
+    Solves the model once for each value of the right-hand side of \a
+    row, in order, all in native code. Each solve restarts from the
+    basis the previous one ended with, so a finely spaced sweep costs
+    a few pivots per point rather than a cold solve. The right-hand
+    side is put back afterwards; the solution of the last point stays
+    available through get_variables and friends.
 
     @param self self
-    @param print_bool print if true; don't print if false.
-    @return \a true if the operation was successful, FALSE if there was an error.
+    @param row the row, 0 to rows; 0 is the objective constant.
+    @param values the right-hand sides, an Array of numbers or a String
+    of packed native doubles.
+    @return a Hash with :objective, the objective value at each point
+    (\a nil where the model was not solved to optimality), :status,
+    the solve() result at each point, and :breakpoints, the indexes into
+    \a values of the points whose optimal basis differs from the one
+    before, which is where the piecewise-linear objective curve can
+    bend. Returns \a nil if \a row is out of range.
 */
 static VALUE
-lpsolve_set_trace(VALUE self, VALUE print_bool) 
+lpsolve_sweep_rhs(VALUE self, VALUE row, VALUE values)
 {
-  if (print_bool != Qtrue && print_bool != Qfalse) {
-    return Qfalse;
-  } else {
-    INIT_LP;
-    set_trace(lp, Qtrue == print_bool);
-    return Qtrue;
-  }
+  return sweep(self, SWEEP_RHS, row, values);
 }
 
-/** A wrapper for set_upbo().
+/** Parametric analysis of an objective coefficient.
 
-    @return \a true if no errors.
+    Like lpsolve_sweep_rhs(), but varies the objective coefficient of
+    \a column.
+
+    @param self self
+    @param column the column, 1 to columns.
+    @param values the coefficients, an Array of numbers or a String of
+    packed native doubles.
+    @return a Hash with :objective, :status and :breakpoints, as for
+    lpsolve_sweep_rhs(), or \a nil if \a column is out of range.
 */
 static VALUE
-lpsolve_set_upbo(VALUE self, VALUE column, VALUE val) 
+lpsolve_sweep_obj(VALUE self, VALUE column, VALUE values)
 {
-  INIT_LP;
-  RETURN_BOOL(set_upbo(lp, FIX2INT(column), NUM2DBL(val)));
+  return sweep(self, SWEEP_OBJ, column, values);
 }
 
-/** A wrapper for set_verbose().
+/** Roll a time-indexed model forward by one period.
 
-    In Ruby, you can also use accessor function verbose=.
+    The model must consist of equal periods laid out in order: period
+    p owns columns (p-1)*\a period_columns+1 to p*\a period_columns
+    and rows (p-1)*\a period_rows+1 to p*\a period_rows. A row may
+    refer to columns of its own period and of earlier ones, e.g. for
+    inventory carried over. When rows of later periods refer to the
+    first period's columns, what those columns contribute in the last
+    solution is moved into the right-hand side of the rows before the
+    columns are deleted, so e.g. the carried-in inventory is kept; that
+    needs a solved model, and the shift is refused otherwise.
 
-    @param self
-    @param new_verbosity desired level of verbosity, an integer. @see 
-    lpsolve_get_verbose() for verbosity levels.
-    @return \a true unless we have an error.
-*/
-static VALUE lpsolve_set_verbose(VALUE self, VALUE new_verbosity);
-LPSOLVE_1_IN_STATUS_OUT(set_verbose, FIX2INT(param1))
+    A new last period is appended as a copy of the current last one:
+    its columns take over the bounds, types and objective coefficients
+    of the last period's columns, and its rows the coefficients, type,
+    right-hand side and range of the last period's rows, with every
+    column index moved on by one period. Then the first period's rows
+    and columns are deleted. New rows and columns are not named.
 
-/** A wrapper for solve().
-    @returns 0 if no error.
-*/
+    If the model has been solved, the previous solution, moved back by
+    one period and with the new period starting where the old last
+    one ended, is turned into a starting basis with guess_basis(), so
+    the next solve restarts close to the old optimum.
 
-static VALUE lpsolve_solve(VALUE self) 
+    Not allowed inside lpsolve_transaction() or in row entry mode.
+
+    @param self self
+    @param period_columns the number of columns in each period.
+    @param period_rows the number of rows in each period.
+    @return \a true if the model was shifted, \a false on error. If
+    lp_solve fails part way, the model may be left partly shifted.
+*/
+static VALUE
+lpsolve_shift_horizon(VALUE self, VALUE period_columns, VALUE period_rows)
 {
+  volatile VALUE work_buf, carry_buf, x_buf = Qnil;
+  int n_cols = NUM2INT(period_columns), n_rows = NUM2INT(period_rows);
+  int rows, columns, periods, i, j, k, n;
+  REAL *val, *carry, *x = NULL;
+  MYBOOL b_carry = FALSE;
+  int *idx;
+  VALUE status;
+
   INIT_LP;
-  if (NULL != lp) { 
-    VALUE status = INT2FIX(solve(lp));
-    rb_ivar_set(self, rb_intern("@status"), status);
-    return status;
-  } else {
-    return Qnil;
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qfalse;
+  if (is_add_rowmode(lp)) {
+    report(lp, IMPORTANT, "%s: not allowed in row entry mode.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
+  rows = get_Nrows(lp);
+  columns = get_Ncolumns(lp);
+  periods = (n_cols > 0) ? columns / n_cols : 0;
+  if (n_cols <= 0 || n_rows < 0 || periods < 2 || 0 != columns % n_cols
+      || rows != periods * n_rows) {
+    report(lp, IMPORTANT, 
+           "%s: %d rows and %d columns are not periods of %d rows and "
+           "%d columns.\n", __FUNCTION__, rows, columns, n_rows, n_cols);
+    return Qfalse;
   }
-}
 
-/** A wrapper for str_add_column().
+  status = rb_ivar_get(self, rb_intern("@status"));
+  if (FIXNUM_P(status) && (OPTIMAL == FIX2INT(status) 
+                           || SUBOPTIMAL == FIX2INT(status))) {
+    x_buf = rb_str_new(NULL, (1 + columns) * sizeof(REAL));
+    x = (REAL *) RSTRING_PTR(x_buf);
+    if (!get_variables(lp, x + 1)) x = NULL;
+  }
+
+  n = 1 + ((rows > columns + n_cols) ? rows : columns + n_cols);
+  work_buf = rb_str_new(NULL, n * (sizeof(REAL) + sizeof(int)));
+  val = (REAL *) RSTRING_PTR(work_buf);
+  idx = (int *) (val + n);
+
+  /* What the first period's columns add to the rows that stay. */
+  carry_buf = rb_str_new(NULL, (1 + rows) * sizeof(REAL));
+  carry = (REAL *) RSTRING_PTR(carry_buf);
+  memset(carry, 0, (1 + rows) * sizeof(REAL));
+  for (j = 1; j <= n_cols; j++) {
+    n = get_columnex(lp, j, val, idx);
+    if (n < 0) goto fail;
+    for (k = 0; k < n; k++) {
+      if (idx[k] <= n_rows || 0.0 == val[k]) continue;
+      b_carry = TRUE;
+      if (NULL != x) carry[idx[k]] += val[k] * x[j];
+    }
+  }
+  if (b_carry && NULL == x) {
+    report(lp, IMPORTANT, "%s: later rows refer to the first period's "
+           "columns; solve first so their values can be carried over.\n",
+           __FUNCTION__);
+    return Qfalse;
+  }
+
+  /* The new period's columns, with just their objective coefficient;
+     their constraint coefficients come with the new rows. */
+  for (j = columns - n_cols + 1; j <= columns; j++) {
+    REAL obj = get_mat(lp, 0, j);
+    int zero = 0;
+    if (!add_columnex(lp, (0.0 != obj) ? 1 : 0, &obj, &zero)) goto fail;
+    k = get_Ncolumns(lp);
+    set_bounds(lp, k, get_lowbo(lp, j), get_upbo(lp, j));
+    if (is_int(lp, j)) set_int(lp, k, TRUE);
+    if (is_semicont(lp, j)) set_semicont(lp, k, TRUE);
+  }
+  for (i = rows - n_rows + 1; i <= rows; i++) {
+    REAL range = get_rh_range(lp, i);
+    n = get_rowex(lp, i, val, idx);
+    if (n < 0) goto fail;
+    for (k = 0; k < n; k++) idx[k] += n_cols;
+    if (!add_constraintex(lp, n, val, idx, get_constr_type(lp, i),
+                          get_rh(lp, i)))
+      goto fail;
+    if (fabs(range) < get_infinite(lp)) 
+      set_rh_range(lp, get_Nrows(lp), range);
+  }
+
+  for (i = n_rows + 1; i <= rows; i++)
+    if (0.0 != carry[i] && !set_rh(lp, i, get_rh(lp, i) - carry[i])) 
+      goto fail;
+
+  /* lp_solve has no public call to delete a block of rows or columns,
+     so the oldest period goes one at a time. */
+  for (i = 0; i < n_rows; i++) 
+    if (!del_constraint(lp, 1)) goto fail;
+  for (j = 0; j < n_cols; j++) 
+    if (!del_column(lp, 1)) goto fail;
+
+  if (NULL != x) {
+    /* Element 0 is unused. */
+    volatile VALUE guess_buf = rb_str_new(NULL, (1 + rows + columns) 
+                                          * (sizeof(REAL) + sizeof(int)));
+    REAL *guessvector = (REAL *) RSTRING_PTR(guess_buf);
+    int *basisvector = (int *) (guessvector + 1 + rows + columns);
+    memset(guessvector, 0, (1 + rows + columns) * sizeof(REAL));
+    for (j = 1; j <= columns - n_cols; j++) guessvector[j] = x[j + n_cols];
+    for (; j <= columns; j++) guessvector[j] = x[j];
+    if (guess_basis(lp, guessvector, basisvector)) 
+      set_basis(lp, basisvector, TRUE);
+  }
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  return Qtrue;
+
+ fail:
+  report(lp, IMPORTANT, "%s: lp_solve failed to change the model.\n",
+         __FUNCTION__);
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  return Qfalse;
+}
 
-    @return \a true if the operation was successful. A false value
-    indicates an error.
-*/
-static VALUE lpsolve_str_add_column(VALUE self, VALUE col_str);
-LPSOLVE_1_STR_IN_BOOL_OUT(str_add_column)
+/* A block of sparse rows or columns returned by a Ruby block, as a
+   Hash in compressed form: entries offsets[k] to offsets[k+1]-1 of
+   the index and :values arrays belong to row or column k. Each array
+   may be an Array or a packed String. The C arrays live in Strings
+   kept in bufs. */
+typedef struct {
+  long n;
+  int *offsets;
+  int *index;
+  REAL *values;
+  volatile VALUE bufs[3];
+} sparse_block_t;
 
-/** A wrapper for str_add_constraint().
-    @return boolean
-*/
 static VALUE
-lpsolve_str_add_constraint(VALUE self, VALUE constraint, 
-                          VALUE compare, VALUE num_constraints) 
+sparse_block_key(VALUE hash, const char *key)
 {
-  char *psz_constraint = RSTRING_PTR(constraint);
-  int  i_compare = NUM2INT(compare);
-  int  i_constraints = NUM2INT(num_constraints);
-  lprec *lp;
-  Data_Get_Struct(self, lprec, lp);
-  RETURN_BOOL(str_add_constraint(lp, psz_constraint, i_compare, i_constraints));
+  VALUE val = rb_hash_aref(hash, ID2SYM(rb_intern(key)));
+  if (NIL_P(val)) rb_raise(rb_eArgError, "missing :%s", key);
+  return val;
 }
 
-/** A wrapper for str_set_obj_fn().
-
-    Set the objective function (row 0) of the matrix via a string.
+/* Fill p_block from hash, whose index array is under index_key and
+   must hold numbers from lo to hi. Raise ArgumentError if the arrays
+   do not fit together. */
+static void
+sparse_block_parse(VALUE hash, const char *index_key, int lo, int hi,
+                   sparse_block_t *p_block)
+{
+  long n_offsets, n_index, n_values, k;
+  Check_Type(hash, T_HASH);
+  p_block->offsets = packed_ints(sparse_block_key(hash, "offsets"),
+                                 &p_block->bufs[0], &n_offsets);
+  p_block->index = packed_ints(sparse_block_key(hash, index_key),
+                               &p_block->bufs[1], &n_index);
+  p_block->values = packed_doubles(sparse_block_key(hash, "values"),
+                                   &p_block->bufs[2], &n_values);
+  if (n_index != n_values)
+    rb_raise(rb_eArgError, ":%s and :values differ in length", index_key);
+  if (n_offsets < 1 || 0 != p_block->offsets[0] 
+      || n_index != p_block->offsets[n_offsets - 1])
+    rb_raise(rb_eArgError, ":offsets must run from 0 to %ld", n_index);
+  for (k = 1; k < n_offsets; k++) 
+    if (p_block->offsets[k] < p_block->offsets[k - 1])
+      rb_raise(rb_eArgError, ":offsets must not decrease");
+  for (k = 0; k < n_index; k++) 
+    if (p_block->index[k] < lo || p_block->index[k] > hi)
+      rb_raise(rb_eArgError, ":%s entry %d is not in %d..%d", index_key,
+               p_block->index[k], lo, hi);
+  p_block->n = n_offsets - 1;
+}
 
-    @return \a true unless we have an error.
-*/
-static VALUE
-lpsolve_str_set_obj_fn(VALUE self, VALUE obj_fn) 
+/* Return the n numbers under key in hash as a REAL array kept in
+   *p_buf, or fill it with dflt if there is no such key. */
+static REAL *
+sparse_block_side(VALUE hash, const char *key, long n, REAL dflt,
+                  volatile VALUE *p_buf)
 {
-  char *psz_obj_fn = RSTRING_PTR(obj_fn);
-  lprec *lp;
-  Data_Get_Struct(self, lprec, lp);
-  RETURN_BOOL(str_set_obj_fn(lp, psz_obj_fn));
+  VALUE val = rb_hash_aref(hash, ID2SYM(rb_intern(key)));
+  REAL *p_vec;
+  long i, n_val;
+  if (NIL_P(val)) {
+    *p_buf = rb_str_new(NULL, n * sizeof(REAL));
+    p_vec = (REAL *) RSTRING_PTR(*p_buf);
+    for (i = 0; i < n; i++) p_vec[i] = dflt;
+    return p_vec;
+  }
+  p_vec = packed_doubles(val, p_buf, &n_val);
+  if (n_val != n)
+    rb_raise(rb_eArgError, ":%s needs %ld values, got %ld", key, n, n_val);
+  return p_vec;
 }
 
-/** A wrapper for time_elapsed(). 
+/** Solve with a cutting-plane loop.
 
-    The time_elapsed function returns the time in seconds since solve
-    and lag_solve has started. In contrast to totaltime, the time does
-    not include the load time. If solving has not completed he value
-    will be the number of seconds of until the time of the call
-    rather than the time the solve completed.
+    Solves the model, then yields the solution, the value of each
+    column as a String of packed native doubles (unpack it with "d*"),
+    to the block, which returns the rows violated by it: \a nil or an
+    empty block when there are none, else a Hash with
 
-    @param  self self.
+    - :offsets, :columns and :values, the rows in compressed sparse row
+      form: entries offsets[k] to offsets[k+1]-1 of :columns (1 to
+      columns) and :values belong to new row k;
+    - :rhs, optional, the right-hand side of each row; 0 by default;
+    - :types, optional, LPSolve::LE, GE or EQ for all rows or an array
+      of them; LE by default.
 
-    @return \a Floating-point number for time since solve and
-    lag_solve has started
-*/
-static VALUE lpsolve_time_elapsed(VALUE self);
-LPSOLVE_0_IN_NUM_OUT(time_elapsed);
+    Each array may be an Array or a packed native String. The rows are
+    added together and the model solved again, restarting from the
+    basis of the previous round, until the block returns no rows, a
+    solve fails or \a max_rounds solves have been made.
 
-/** \fn time_load Return the amount of time used to load in data
+    lp_solve can only enter row entry mode before the first solve, so
+    the cuts are appended with add_constraintex directly.
 
     @param self self
+    @param max_rounds the most solves to make, 100 by default.
+    @param drop_after if given, a cut whose row has been slack for
+    this many consecutive rounds is deleted before the next cuts are
+    added. Only rows added by this call are dropped.
+    @return a Hash with :status, the result of the last solve(), and
+    :rounds, one Hash per solve with :objective, :solve_time and
+    :separation_time (seconds), :cuts_added, :cuts_dropped and :rows.
+*/
+static VALUE
+lpsolve_solve_with_cuts(int argc, VALUE *argv, VALUE self)
+{
+  volatile VALUE x_buf, rhs_buf, types_buf, slack_buf = Qnil;
+  VALUE opts, val, rounds, result;
+  long max_rounds = 100, drop_after = 0, round, k;
+  int first_cut, n_cuts = 0, *slack_rounds = NULL, status = NOTRUN;
+  callback_error_t cb_err = { 0, Qnil };
 
-    @return A Ruby floating-point number indicating how long the
-    presolver solver took.
+  INIT_LP;
+  rb_need_block();
+  rb_scan_args(argc, argv, "0:", &opts);
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qnil;
+  if (!NIL_P(opts)) {
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("max_rounds")))))
+      max_rounds = NUM2LONG(val);
+    if (!NIL_P(val = rb_hash_aref(opts, ID2SYM(rb_intern("drop_after")))))
+      drop_after = NUM2LONG(val);
+  }
+  if (is_add_rowmode(lp)) set_add_rowmode(lp, FALSE);
+  first_cut = get_Nrows(lp) + 1;
+  rounds = rb_ary_new();
+
+  for (round = 0; round < max_rounds; round++) {
+    sparse_block_t cuts;
+    VALUE stats = rb_hash_new();
+    REAL *p_rhs, *p_activity;
+    int *p_types = NULL, i_type = LE, n_dropped = 0, i;
+    long n_types;
+    double t0;
+
+    t0 = monotonic_seconds();
+    status = callbacks_solve(self, lp, &cb_err);
+    rb_ivar_set(self, rb_intern("@status"), INT2FIX(status));
+    callbacks_raise(&cb_err);
+    rb_hash_aset(stats, ID2SYM(rb_intern("solve_time")),
+                 rb_float_new(monotonic_seconds() - t0));
+    rb_ary_push(rounds, stats);
+    if (OPTIMAL != status && SUBOPTIMAL != status) break;
+    rb_hash_aset(stats, ID2SYM(rb_intern("objective")), 
+                 rb_float_new(get_objective(lp)));
+
+    /* Count the rounds each cut has been slack. */
+    get_ptr_constraints(lp, &p_activity);
+    for (i = 0; i < n_cuts; i++) {
+      int row = first_cut + i;
+      REAL rh = get_rh(lp, row), tol = 1e-6 * (1 + fabs(rh));
+      REAL gap = rh - p_activity[row - 1];
+      if (GE == get_constr_type(lp, row)) gap = -gap;
+      slack_rounds[i] = (EQ != get_constr_type(lp, row) && gap > tol) 
+        ? slack_rounds[i] + 1 : 0;
+    }
 
-*/
-static VALUE lpsolve_time_load(VALUE self) ;
-LPSOLVE_0_IN_TIME_OUT(time_load, timecreate, timestart);
+    x_buf = rb_str_new(NULL, get_Ncolumns(lp) * sizeof(double));
+    {
+      REAL *p_x;
+      double *p_out = (double *) RSTRING_PTR(x_buf);
+      get_ptr_variables(lp, &p_x);
+      for (i = 0; i < get_Ncolumns(lp); i++) p_out[i] = p_x[i];
+    }
+    t0 = monotonic_seconds();
+    val = rb_yield(x_buf);
+    rb_hash_aset(stats, ID2SYM(rb_intern("separation_time")),
+                 rb_float_new(monotonic_seconds() - t0));
+    if (NIL_P(val)) break;
+    sparse_block_parse(val, "columns", 1, get_Ncolumns(lp), &cuts);
+    if (0 == cuts.n) break;
+    p_rhs = sparse_block_side(val, "rhs", cuts.n, 0.0, &rhs_buf);
+    val = rb_hash_aref(val, ID2SYM(rb_intern("types")));
+    if (FIXNUM_P(val)) i_type = FIX2INT(val);
+    else if (!NIL_P(val)) {
+      p_types = packed_ints(val, &types_buf, &n_types);
+      if (n_types != cuts.n)
+        rb_raise(rb_eArgError, ":types needs %ld values, got %ld", cuts.n,
+                 n_types);
+    }
+    for (k = 0; k < cuts.n; k++) {
+      int type = (NULL != p_types) ? p_types[k] : i_type;
+      if (LE != type && GE != type && EQ != type)
+        rb_raise(rb_eArgError, ":types entry %d is not LE, GE or EQ", type);
+    }
 
-/** Return the amount of time used in the simplex solver
+    /* Drop stale cuts, newest first so row numbers stay put. */
+    if (drop_after > 0) {
+      for (i = n_cuts - 1; i >= 0; i--) {
+        if (slack_rounds[i] >= drop_after
+            && del_constraint(lp, first_cut + i)) {
+          memmove(slack_rounds + i, slack_rounds + i + 1, 
+                  (n_cuts - i - 1) * sizeof(int));
+          n_cuts--;
+          n_dropped++;
+        }
+      }
+    }
 
-    @param self self
+    for (k = 0; k < cuts.n; k++) {
+      int start = cuts.offsets[k];
+      int type = (NULL != p_types) ? p_types[k] : i_type;
+      if (!add_constraintex(lp, cuts.offsets[k + 1] - start,
+                            cuts.values + start, cuts.index + start,
+                            type, p_rhs[k])) {
+        long bad = k;
+        /* Take back the rows of this batch added so far. */
+        while (k-- > 0) del_constraint(lp, get_Nrows(lp));
+        rb_raise(rb_eArgError, "lp_solve rejected cut %ld", bad);
+      }
+    }
+    slack_buf = rb_str_resize(NIL_P(slack_buf) ? rb_str_new(NULL, 0) 
+                              : slack_buf, (n_cuts + cuts.n) * sizeof(int));
+    slack_rounds = (int *) RSTRING_PTR(slack_buf);
+    memset(slack_rounds + n_cuts, 0, cuts.n * sizeof(int));
+    n_cuts += cuts.n;
+    rb_hash_aset(stats, ID2SYM(rb_intern("cuts_added")), LONG2NUM(cuts.n));
+    rb_hash_aset(stats, ID2SYM(rb_intern("cuts_dropped")), 
+                 INT2FIX(n_dropped));
+    rb_hash_aset(stats, ID2SYM(rb_intern("rows")), INT2FIX(get_Nrows(lp)));
+  }
 
-    @return A Ruby floating-point number indicating how long the
-    simplex solver took.
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("status")), INT2FIX(status));
+  rb_hash_aset(result, ID2SYM(rb_intern("rounds")), rounds);
+  return result;
+}
 
-    This only makes sense if a problem was solved. See also
-    the status instance variable.
+/* State of a solve_with_column_generation() call. */
+typedef struct {
+  VALUE self;
+  lprec *lp;
+  long max_iterations;
+  REAL tolerance;
+  MYBOOL b_sensitivity;
+} colgen_t;
 
-    In Ruby, you can also use accessor function simplextime
-*/
-static VALUE lpsolve_time_simplex(VALUE self) ;
-LPSOLVE_0_IN_TIME_OUT(time_simplex, timepresolved, timeend);
+static VALUE
+colgen_body(VALUE arg)
+{
+  colgen_t *p_cg = (colgen_t *) arg;
+  lprec *lp = p_cg->lp;
+  VALUE self = p_cg->self;
+  volatile VALUE duals_buf, lower_buf, upper_buf;
+  VALUE val, iterations, result;
+  long iteration, k;
+  int status = NOTRUN;
+  callback_error_t cb_err = { 0, Qnil };
+
+  iterations = rb_ary_new();
+  for (iteration = 0; iteration < p_cg->max_iterations; iteration++) {
+    sparse_block_t columns;
+    VALUE stats = rb_hash_new();
+    REAL *p_duals, *p_lower, *p_upper, best = 0.0;
+    REAL sense = is_maxim(lp) ? -1.0 : 1.0;
+    int rows = get_Nrows(lp), n_added = 0, i;
+    double t0;
+
+    t0 = monotonic_seconds();
+    status = callbacks_solve(self, lp, &cb_err);
+    rb_ivar_set(self, rb_intern("@status"), INT2FIX(status));
+    callbacks_raise(&cb_err);
+    rb_hash_aset(stats, ID2SYM(rb_intern("solve_time")),
+                 rb_float_new(monotonic_seconds() - t0));
+    rb_ary_push(iterations, stats);
+    if (OPTIMAL != status && SUBOPTIMAL != status) break;
+    rb_hash_aset(stats, ID2SYM(rb_intern("objective")), 
+                 rb_float_new(get_objective(lp)));
+    if (!get_ptr_sensitivity_rhs(lp, &p_duals, NULL, NULL)) {
+      report(lp, IMPORTANT, "%s: lp_solve returned no duals.\n",
+             "lpsolve_solve_with_column_generation");
+      break;
+    }
 
-/** \fn time_presolve
-    Return the amount of time used in the presolver
+    duals_buf = rb_str_new(NULL, rows * sizeof(double));
+    for (i = 0; i < rows; i++) 
+      ((double *) RSTRING_PTR(duals_buf))[i] = p_duals[i];
+    t0 = monotonic_seconds();
+    val = rb_yield(duals_buf);
+    rb_hash_aset(stats, ID2SYM(rb_intern("pricing_time")),
+                 rb_float_new(monotonic_seconds() - t0));
+    if (NIL_P(val)) break;
+    sparse_block_parse(val, "rows", 0, rows, &columns);
+    rb_hash_aset(stats, ID2SYM(rb_intern("columns_offered")), 
+                 LONG2NUM(columns.n));
+    if (0 == columns.n) break;
+    p_lower = sparse_block_side(val, "lower", columns.n, 0.0, &lower_buf);
+    p_upper = sparse_block_side(val, "upper", columns.n, get_infinite(lp),
+                                &upper_buf);
+
+    for (k = 0; k < columns.n; k++) {
+      int start = columns.offsets[k], end = columns.offsets[k + 1], e;
+      REAL reduced_cost = 0.0;
+      for (e = start; e < end; e++) {
+        int row = columns.index[e];
+        reduced_cost += (0 == row) ? columns.values[e] 
+          : -p_duals[row - 1] * columns.values[e];
+      }
+      /* Negative is better when minimizing, positive when maximizing. */
+      reduced_cost *= sense;
+      if (reduced_cost < best) best = reduced_cost;
+      if (reduced_cost >= -p_cg->tolerance) continue;
+      if (!add_columnex(lp, end - start, columns.values + start,
+                        columns.index + start))
+        rb_raise(rb_eArgError, "lp_solve rejected column %ld", k);
+      set_bounds(lp, get_Ncolumns(lp), p_lower[k], p_upper[k]);
+      n_added++;
+    }
+    rb_hash_aset(stats, ID2SYM(rb_intern("columns_added")), 
+                 INT2FIX(n_added));
+    rb_hash_aset(stats, ID2SYM(rb_intern("best_reduced_cost")), 
+                 rb_float_new(sense * best));
+    rb_hash_aset(stats, ID2SYM(rb_intern("columns")), 
+                 INT2FIX(get_Ncolumns(lp)));
+    if (0 == n_added) break;
+  }
 
-    @param self self
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("status")), INT2FIX(status));
+  rb_hash_aset(result, ID2SYM(rb_intern("iterations")), iterations);
+  return result;
+}
 
-    @return A Ruby floating-point number indicating how long the
-    presolver solver took.
+static VALUE
+colgen_restore(VALUE arg)
+{
+  colgen_t *p_cg = (colgen_t *) arg;
+  set_sensitivity(p_cg->lp, p_cg->b_sensitivity);
+  return Qnil;
+}
 
-    This only makes sense if a problem was solved. See also
-    the status instance variable.
+/** Solve with a column-generation loop.
 
-    In Ruby, you can also use accessor function simplextime
-*/
-static VALUE lpsolve_time_presolve(VALUE self) ;
-LPSOLVE_0_IN_TIME_OUT(time_presolve, timestart, timepresolved);
+    Solves the restricted master problem, then yields all row duals at
+    once, as a String of packed native doubles with one entry per row
+    (unpack it with "d*"), to the pricing block. The block returns
+    candidate columns: \a nil or an empty block when there are none,
+    else a Hash with
 
-/** Return the total amount elapsed time from start to finish.
+    - :offsets, :rows and :values, the columns in compressed sparse
+      column form: entries offsets[k] to offsets[k+1]-1 of :rows (0 to
+      rows, 0 being the objective) and :values belong to column k;
+    - :lower and :upper, optional bounds for each column, 0 and
+      infinity by default.
 
-    @param self self
+    Each array may be an Array or a packed native String. The reduced
+    cost of each candidate is worked out from the duals; those that
+    would improve the objective by more than \a tolerance are added in
+    one go and the master solved again, restarting from the basis of
+    the previous round. The loop ends when no candidate improves, a
+    solve fails or \a max_iterations solves have been made.
 
-    @return A Ruby floating-point number indicating how long the
-    simplex solver took.
+    Sensitivity analysis is turned on while the loop runs, as duals
+    need it, and set back as it was afterwards.
 
-    This only makes sense if a problem was solved. See also
-    the status instance variable.
+    @param self self
+    @param max_iterations the most solves to make, 1000 by default.
+    @param tolerance how much a reduced cost must improve the
+    objective to count, 1e-9 by default.
+    @return a Hash with :status, the result of the last solve(), and
+    :iterations, one Hash per solve with :objective, :solve_time and
+    :pricing_time (seconds), :columns_offered, :columns_added,
+    :best_reduced_cost and :columns.
 */
-static VALUE lpsolve_time_total(VALUE self) ;
-LPSOLVE_0_IN_TIME_OUT(time_total, timecreate, timeend);
+static VALUE
+lpsolve_solve_with_column_generation(int argc, VALUE *argv, VALUE self)
+{
+  colgen_t cg;
+  VALUE opts, val;
 
-/** A wrapper for solve_unscale().
+  INIT_LP;
+  rb_need_block();
+  rb_scan_args(argc, argv, "0:", &opts);
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qnil;
+  cg.self = self;
+  cg.lp = lp;
+  cg.max_iterations = 1000;
+  cg.tolerance = 1e-9;
+  if (!NIL_P(opts)) {
+    val = rb_hash_aref(opts, ID2SYM(rb_intern("max_iterations")));
+    if (!NIL_P(val)) cg.max_iterations = NUM2LONG(val);
+    val = rb_hash_aref(opts, ID2SYM(rb_intern("tolerance")));
+    if (!NIL_P(val)) cg.tolerance = NUM2DBL(val);
+  }
+  if (is_add_rowmode(lp)) set_add_rowmode(lp, FALSE);
+  cg.b_sensitivity = RTEST(rb_ivar_get(self, rb_intern("sensitivity")));
+  set_sensitivity(lp, TRUE);
+  return rb_ensure(colgen_body, (VALUE) &cg, colgen_restore, (VALUE) &cg);
+}
 
-    The get_bb_rule function returns the branch-and-bound rule for
-    choosing which non-integer variable is to be selected. This rule
-    can influence solving times considerably. Depending on the model
-    one rule can be best and for another model another rule.  The
-    default is NODE_PSEUDONONINTSELECT + NODE_GREEDYMODE +
-    NODE_DYNAMICMODE + NODE_RCOSTFIXING (17445).
+/* Fill obj, 1 + columns REALs with element 0 unused, from an
+   objective given as an Array of [column, coefficient] pairs or as a
+   String of packed native doubles, one per column. */
+static void
+lexicographic_objective(lprec *lp, VALUE spec, long k, REAL *obj)
+{
+  int columns = get_Ncolumns(lp), j;
+  long i;
+  memset(obj, 0, (1 + columns) * sizeof(REAL));
+  if (TYPE(spec) == T_STRING) {
+    if (RSTRING_LEN(spec) != (long) (columns * sizeof(double)))
+      rb_raise(rb_eArgError, "objective %ld must have %d packed doubles",
+               k, columns);
+    for (j = 0; j < columns; j++) {
+      double val;
+      memcpy(&val, RSTRING_PTR(spec) + j * sizeof(double), sizeof(val));
+      obj[j + 1] = val;
+    }
+    return;
+  }
+  Check_Type(spec, T_ARRAY);
+  for (i = 0; i < RARRAY_LEN(spec); i++) {
+    VALUE pair = rb_ary_entry(spec, i);
+    Check_Type(pair, T_ARRAY);
+    if (RARRAY_LEN(pair) != 2)
+      rb_raise(rb_eArgError, "objective %ld: entry %ld is not a pair", k, i);
+    j = NUM2INT(rb_ary_entry(pair, 0));
+    if (j < 1 || j > columns)
+      rb_raise(rb_eArgError, "objective %ld: column %d is not in 1..%d", k,
+               j, columns);
+    obj[j] = NUM2DBL(rb_ary_entry(pair, 1));
+  }
+}
 
-    @param self self
-    @return  Returns the branch-and-bound rule.
+/** Lexicographic multi-objective solve.
 
-*/
-static VALUE lpsolve_unscale(VALUE self);
-LPSOLVE_0_IN_STATUS_OUT(unscale)
+    Optimizes \a objectives one after the other, in the direction the
+    model is set to (set_maxim/set_minim). After each stage, the
+    optimum found becomes a constraint on that objective, relaxed by
+    the stage's tolerance, before the next objective is optimized.
+    Each stage restarts from the basis the previous one ended with,
+    and the whole run is one native call.
 
-/** A wrapper for lp_solve_version(). 
-    @return 4-tuple: [major_version, minor_version, release, build]
+    Afterwards the objective-bound rows are deleted and the original
+    objective put back, so the model is as it was; deleting rows makes
+    lpsolve_get_variables() meaningless until the next solve, so the
+    final solution is part of the result.
+
+    @param self self
+    @param objectives the objectives in priority order, each an Array
+    of [column, coefficient] pairs or a String of packed native doubles
+    with one coefficient per column.
+    @param tolerances how much each objective may give up for the
+    later ones, relative to its optimum (with a floor of 1 on the
+    magnitude): a number for all stages or an Array, 0 meaning none.
+    @return a Hash with :status, the result of the last solve(),
+    :objectives, the optimum of each stage solved, and :variables, the
+    final values of the columns as a String of packed native doubles;
+    or \a nil if the model is in a transaction or with_overrides()
+    block, or a stage's bound row could not be added. The model's
+    objective constant plays no part in the stages.
 */
 static VALUE
-lpsolve_version(VALUE module_or_class) 
+lpsolve_solve_lexicographic(VALUE self, VALUE objectives, VALUE tolerances)
 {
-  int major_version;
-  int minor_version;
-  int release;
-  int build;
-  lp_solve_version(&major_version, &minor_version, &release, &build);
-  return rb_ary_new3(4, 
-                     INT2FIX(major_version), INT2FIX(minor_version),
-                     INT2FIX(release), INT2FIX(build));
+  volatile VALUE obj_buf, row_buf, x_buf = Qnil;
+  VALUE optima, result;
+  REAL *p_saved, *p_obj, *p_row, constant;
+  int columns, first_row, *p_colno, status = NOTRUN, j, nz;
+  MYBOOL b_added = TRUE;
+  callback_error_t cb_err = { 0, Qnil };
+  long n, k;
+
+  INIT_LP;
+  if (journal_refuse(self, lp, __FUNCTION__)) return Qnil;
+  Check_Type(objectives, T_ARRAY);
+  n = RARRAY_LEN(objectives);
+  if (TYPE(tolerances) == T_ARRAY && RARRAY_LEN(tolerances) < n - 1)
+    rb_raise(rb_eArgError, "need a tolerance for each objective but the last");
+  if (is_add_rowmode(lp)) set_add_rowmode(lp, FALSE);
+  columns = get_Ncolumns(lp);
+
+  /* Slot 0 keeps the model's own objective; then one per stage. */
+  obj_buf = rb_str_new(NULL, (n + 1) * (1 + columns) * sizeof(REAL));
+  p_saved = (REAL *) RSTRING_PTR(obj_buf);
+  get_row(lp, 0, p_saved);
+  for (k = 0; k < n; k++)
+    lexicographic_objective(lp, rb_ary_entry(objectives, k), k,
+                            p_saved + (k + 1) * (1 + columns));
+  for (k = 0; k + 1 < n; k++)
+    (void) NUM2DBL((TYPE(tolerances) == T_ARRAY) 
+                   ? rb_ary_entry(tolerances, k) : tolerances);
+  row_buf = rb_str_new(NULL, columns * (sizeof(REAL) + sizeof(int)));
+  p_row = (REAL *) RSTRING_PTR(row_buf);
+  p_colno = (int *) (p_row + columns);
+
+  /* get_objective() counts the model's objective constant, which is
+     no part of the stage objectives; take it out until the end. */
+  constant = get_rh(lp, 0);
+  set_rh(lp, 0, 0.0);
+  first_row = get_Nrows(lp) + 1;
+  optima = rb_ary_new2(n);
+  for (k = 0; k < n; k++) {
+    REAL optimum, tol, slack;
+    p_obj = p_saved + (k + 1) * (1 + columns);
+    set_obj_fn(lp, p_obj);
+    status = callbacks_solve(self, lp, &cb_err);
+    if (0 != cb_err.state) break;
+    if (OPTIMAL != status && SUBOPTIMAL != status) break;
+    optimum = get_objective(lp);
+    rb_ary_push(optima, rb_float_new(optimum));
+    if (k + 1 == n) break;
+
+    tol = NUM2DBL((TYPE(tolerances) == T_ARRAY) 
+                  ? rb_ary_entry(tolerances, k) : tolerances);
+    slack = fabs(tol) * ((fabs(optimum) > 1.0) ? fabs(optimum) : 1.0);
+    for (nz = 0, j = 1; j <= columns; j++) {
+      if (0.0 != p_obj[j]) {
+        p_row[nz] = p_obj[j];
+        p_colno[nz++] = j;
+      }
+    }
+    if (is_maxim(lp)) 
+      b_added = add_constraintex(lp, nz, p_row, p_colno, GE, optimum - slack);
+    else
+      b_added = add_constraintex(lp, nz, p_row, p_colno, LE, optimum + slack);
+    if (!b_added) {
+      report(lp, IMPORTANT, "%s: cannot bound objective %ld.\n",
+             __FUNCTION__, k);
+      break;
+    }
+  }
+
+  if (OPTIMAL == status || SUBOPTIMAL == status) {
+    REAL *p_x;
+    x_buf = rb_str_new(NULL, columns * sizeof(double));
+    get_ptr_variables(lp, &p_x);
+    for (j = 0; j < columns; j++) 
+      ((double *) RSTRING_PTR(x_buf))[j] = p_x[j];
+  }
+  for (j = get_Nrows(lp); j >= first_row; j--) del_constraint(lp, j);
+  set_obj_fn(lp, p_saved);
+  set_rh(lp, 0, constant);
+  rb_ivar_set(self, rb_intern("@status"), INT2FIX(SOLVE_NOT_CALLED));
+  callbacks_raise(&cb_err);
+  if (!b_added) return Qnil;
+
+  result = rb_hash_new();
+  rb_hash_aset(result, ID2SYM(rb_intern("status")), INT2FIX(status));
+  rb_hash_aset(result, ID2SYM(rb_intern("objectives")), optima);
+  rb_hash_aset(result, ID2SYM(rb_intern("variables")), x_buf);
+  return result;
 }
 
 /** A wrapper for write_basis(). 
@@ -2542,7 +8403,12 @@ LPSOLVE_1_STR_IN_BOOL_OUT(write_basis)
      
      @param filename place to write LP file. If this is nil, then
      output is written the location specified by set_outputstream, or
-     of that has not been set stdout.
+     of that has not been set stdout. A filename ending in ".gz" (or
+     ".zst" when built with Zstandard) is compressed as it is written;
+     without the library needed for that, nothing is written and the
+     reason is reported. This can also be an IO or any other object
+     that responds to write(); output is then passed to it in chunks
+     as it is produced.
 
      @return \a true if we could write the output file.
 */
@@ -2561,12 +8427,16 @@ static VALUE lpsolve_write_lp(int argc, VALUE *argv, VALUE self)
     case 1: 
       if (filename == Qnil)
         RETURN_BOOL(write_lp(lp, NULL));
-      else if (TYPE(filename) != T_STRING) {
-        report(lp, IMPORTANT, "%s: Parameter is not nil or a string filename.\n",
+      else if (TYPE(filename) == T_STRING)
+        RETURN_BOOL(write_model(lp, RSTRING_PTR(filename), MODEL_LP));
+      else if (rb_respond_to(filename, rb_intern("write")))
+        RETURN_BOOL(write_model_rb(lp, write_LP, filename));
+      else {
+        report(lp, IMPORTANT, 
+               "%s: Parameter is not nil, a string filename or an IO.\n",
                __FUNCTION__);
         return Qnil;
-      } else
-        RETURN_BOOL(write_lp(lp, RSTRING_PTR(filename)));
+      }
     default:
       rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", 
                i_scanned);
@@ -2585,7 +8455,12 @@ static VALUE lpsolve_write_lp(int argc, VALUE *argv, VALUE self)
      
      @param filename place to write MPS file. If this is nil, then
      output is written the location specified by set_outputstream, or
-     of that has not been set stdout.
+     of that has not been set stdout. A filename ending in ".gz" (or
+     ".zst" when built with Zstandard) is compressed as it is written;
+     without the library needed for that, nothing is written and the
+     reason is reported. This can also be an IO or any other object
+     that responds to write(); output is then passed to it in chunks
+     as it is produced.
 
      @return \a true if we could write the output file.
 */
@@ -2605,12 +8480,16 @@ static VALUE lpsolve_write_mps(int argc, VALUE *argv, VALUE self)
     case 1: 
       if (filename == Qnil)
         RETURN_BOOL(write_mps(lp, NULL));
-      else if (TYPE(filename) != T_STRING) {
-        report(lp, IMPORTANT, "%s: Parameter is not nil or a string filename.\n",
+      else if (TYPE(filename) == T_STRING)
+        RETURN_BOOL(write_model(lp, RSTRING_PTR(filename), MODEL_MPS));
+      else if (rb_respond_to(filename, rb_intern("write")))
+        RETURN_BOOL(write_model_rb(lp, write_MPS, filename));
+      else {
+        report(lp, IMPORTANT, 
+               "%s: Parameter is not nil, a string filename or an IO.\n",
                __FUNCTION__);
         return Qnil;
-      } else
-        RETURN_BOOL(write_mps(lp, RSTRING_PTR(filename)));
+      }
     default:
       rb_raise(rb_eArgError, "wrong number of arguments (%d for 0 or 1)", 
                i_scanned);
@@ -2618,6 +8497,240 @@ static VALUE lpsolve_write_mps(int argc, VALUE *argv, VALUE self)
     return Qfalse;
   }
 
+/** Write the solution of the last solve, streaming it straight from
+    lp_solve's result arrays without building Ruby objects.
+
+    In Ruby:
+    \verbatim
+      lp.write_solution(path_or_io, format: :csv, 
+                        include: [:primal, :dual, :reduced_cost, :slack])
+    \endverbatim
+
+    \a format is one of:
+    - \a :csv: a header line "type,index,name,value,dual,slack", then
+      one line per variable ("var", value and reduced cost) and per
+      constraint ("row", activity, dual and slack). Parts not included
+      are left empty.
+    - \a :ndjson: the same records as JSON objects, one per line.
+    - \a :binary: a fixed header (magic "LPSOLN\r\n", version, byte
+      order marker, include flags, columns, rows, status, objective)
+      followed by the included arrays as native doubles, in the order
+      primal, reduced_cost, activity, dual, slack.
+
+    \a include lists any of \a :primal, \a :reduced_cost, \a
+    :activity, \a :dual and \a :slack. Duals and reduced costs are
+    only available if set_sensitivity(true) was called before solve;
+    asking for them otherwise is an error. By default, \a :primal and
+    \a :slack are written, plus \a :dual and \a :reduced_cost when
+    they are available.
+
+    @param self self
+    @param filename file to write, compressed if the name ends in ".gz"
+    (or ".zst" when built with Zstandard), or an IO or any other object
+    that responds to write().
+    @return \a true if the solution was written completely.
+*/
+static VALUE 
+lpsolve_write_solution(int argc, VALUE *argv, VALUE self)
+{
+  VALUE filename, opts, format = Qnil, parts = Qnil;
+  solution_format_t i_format = SOLUTION_CSV;
+  int include = 0, i_status;
+  MYBOOL b_ret;
+  FILE *fp;
+  INIT_LP;
+
+  rb_scan_args(argc, argv, "1:", &filename, &opts);
+  if (!NIL_P(opts)) {
+    format = rb_hash_aref(opts, ID2SYM(rb_intern("format")));
+    parts  = rb_hash_aref(opts, ID2SYM(rb_intern("include")));
+  }
+
+  if (!NIL_P(format)) {
+    ID id = SYMBOL_P(format) ? SYM2ID(format) : 0;
+    if (id == rb_intern("csv"))         i_format = SOLUTION_CSV;
+    else if (id == rb_intern("ndjson")) i_format = SOLUTION_NDJSON;
+    else if (id == rb_intern("binary")) i_format = SOLUTION_BINARY;
+    else rb_raise(rb_eArgError, "format must be :csv, :ndjson or :binary");
+  }
+
+  if (NIL_P(parts)) {
+    include = SOLUTION_PRIMAL | SOLUTION_SLACK;
+    if (solution_has_duals(lp)) 
+      include |= SOLUTION_DUAL | SOLUTION_REDUCED_COST;
+  } else {
+    long i;
+    Check_Type(parts, T_ARRAY);
+    for (i = 0; i < RARRAY_LEN(parts); i++) {
+      VALUE part = rb_ary_entry(parts, i);
+      ID id = SYMBOL_P(part) ? SYM2ID(part) : 0;
+      if (id == rb_intern("primal"))            include |= SOLUTION_PRIMAL;
+      else if (id == rb_intern("reduced_cost")) include |= SOLUTION_REDUCED_COST;
+      else if (id == rb_intern("activity"))     include |= SOLUTION_ACTIVITY;
+      else if (id == rb_intern("dual"))         include |= SOLUTION_DUAL;
+      else if (id == rb_intern("slack"))        include |= SOLUTION_SLACK;
+      else rb_raise(rb_eArgError, "unknown solution part %"PRIsVALUE, 
+                    rb_inspect(part));
+    }
+  }
+
+  if (!solution_ready(self, lp, include, __FUNCTION__)) return Qfalse;
+  i_status = FIX2INT(rb_ivar_get(self, rb_intern("@status")));
+
+  if (TYPE(filename) == T_STRING) {
+    fp = model_fopen(RSTRING_PTR(filename), "wb");
+    if (NULL == fp) {
+      report(lp, IMPORTANT, "%s: Cannot open %s for writing.\n",
+             __FUNCTION__, RSTRING_PTR(filename));
+      return Qfalse;
+    }
+    if (SOLUTION_BINARY != i_format)
+      setvbuf(fp, NULL, _IOFBF, LPSOLVE_STREAM_BUFSIZE);
+    b_ret = solution_write(lp, fp, i_format, include, i_status);
+    if (0 != fclose(fp)) b_ret = FALSE;
+    RETURN_BOOL(b_ret);
+  } else if (rb_respond_to(filename, rb_intern("write"))) {
+    rbstream_t rbs;
+    fp = rbstream_open(&rbs, filename);
+    if (NULL == fp) {
+      report(lp, IMPORTANT, "%s: Cannot open an output stream.\n",
+             __FUNCTION__);
+      return Qfalse;
+    }
+    b_ret = solution_write(lp, fp, i_format, include, i_status);
+    if (0 != rbstream_close(&rbs, fp)) b_ret = FALSE;
+    RETURN_BOOL(b_ret);
+  } else {
+    report(lp, IMPORTANT, "%s: Parameter is not a string filename or an IO.\n",
+           __FUNCTION__);
+    return Qnil;
+  }
+}
+
+/** Write the solution of the last solve as an Apache Arrow IPC file.
+
+    The file is produced natively from lp_solve's result arrays in
+    column-oriented record batches, so it can be memory-mapped by
+    Arrow readers without copying. No Arrow library is needed.
+
+    In Ruby:
+    \verbatim
+      lp.write_arrow(path_or_io, table: :variables, batch_size: 65536)
+    \endverbatim
+
+    With \a table: \a :variables (the default) the columns are index
+    (int32), name (utf8), value and reduced_cost (float64); with \a
+    :constraints they are index, name, activity, dual and slack. Duals
+    and reduced costs are null unless set_sensitivity(true) was called
+    before solve.
+
+    @param self self
+    @param filename file to write, or an IO or any other object that
+    responds to write().
+    @return \a true if the file was written completely.
+*/
+static VALUE 
+lpsolve_write_arrow(int argc, VALUE *argv, VALUE self)
+{
+  VALUE filename, opts, table = Qnil, batch_size = Qnil;
+  arrow_column_t cols[5];
+  int n_cols, i_batch_size = 65536, rows, i;
+  MYBOOL b_row = FALSE, b_ret;
+  REAL *p_variables, *p_constraints, *p_duals = NULL, *p_slacks = NULL;
+  FILE *fp;
+  INIT_LP;
+
+  rb_scan_args(argc, argv, "1:", &filename, &opts);
+  if (!NIL_P(opts)) {
+    table      = rb_hash_aref(opts, ID2SYM(rb_intern("table")));
+    batch_size = rb_hash_aref(opts, ID2SYM(rb_intern("batch_size")));
+  }
+  if (!NIL_P(table)) {
+    ID id = SYMBOL_P(table) ? SYM2ID(table) : 0;
+    if (id == rb_intern("constraints"))    b_row = TRUE;
+    else if (id != rb_intern("variables")) 
+      rb_raise(rb_eArgError, "table must be :variables or :constraints");
+  }
+  if (!NIL_P(batch_size)) {
+    i_batch_size = NUM2INT(batch_size);
+    if (i_batch_size < 1) rb_raise(rb_eArgError, "batch_size must be positive");
+  }
+#ifdef WORDS_BIGENDIAN
+  rb_notimplement();
+#endif
+
+  if (!solution_ready(self, lp, 0, __FUNCTION__)) return Qfalse;
+  get_ptr_variables(lp, &p_variables);
+  get_ptr_constraints(lp, &p_constraints);
+  if (!get_ptr_sensitivity_rhs(lp, &p_duals, NULL, NULL))
+    p_duals = NULL;
+
+  rows = get_Nrows(lp);
+  memset(cols, 0, sizeof(cols));
+  cols[0].name = "index";
+  cols[0].type = ARROW_INDEX;
+  cols[1].name = "name";
+  cols[1].type = ARROW_NAME;
+  if (b_row) {
+    p_slacks = ALLOC_N(REAL, rows + 1);
+    for (i = 0; i < rows; i++)
+      p_slacks[i] = get_rh(lp, i + 1) - p_constraints[i];
+    cols[2].name = "activity";
+    cols[2].type = ARROW_DOUBLE;
+    cols[2].values = p_constraints;
+    cols[3].name = "dual";
+    cols[3].type = ARROW_DOUBLE;
+    cols[3].values = p_duals;
+    cols[3].nullable = TRUE;
+    cols[4].name = "slack";
+    cols[4].type = ARROW_DOUBLE;
+    cols[4].values = p_slacks;
+    n_cols = 5;
+  } else {
+    cols[2].name = "value";
+    cols[2].type = ARROW_DOUBLE;
+    cols[2].values = p_variables;
+    cols[3].name = "reduced_cost";
+    cols[3].type = ARROW_DOUBLE;
+    cols[3].values = (NULL != p_duals) ? p_duals + rows : NULL;
+    cols[3].nullable = TRUE;
+    n_cols = 4;
+  }
+
+  if (TYPE(filename) == T_STRING) {
+    fp = fopen(RSTRING_PTR(filename), "wb");
+    if (NULL == fp) {
+      report(lp, IMPORTANT, "%s: Cannot open %s for writing.\n",
+             __FUNCTION__, RSTRING_PTR(filename));
+      free(p_slacks);
+      return Qfalse;
+    }
+    b_ret = arrow_write(lp, fp, cols, n_cols, b_row, i_batch_size);
+    if (0 != fclose(fp)) b_ret = FALSE;
+  } else if (rb_respond_to(filename, rb_intern("write"))) {
+    rbstream_t rbs;
+    fp = rbstream_open(&rbs, filename);
+    if (NULL == fp) {
+      report(lp, IMPORTANT, "%s: Cannot open an output stream.\n",
+             __FUNCTION__);
+      free(p_slacks);
+      return Qfalse;
+    }
+    b_ret = arrow_write(lp, fp, cols, n_cols, b_row, i_batch_size);
+    /* Free first: rbstream_close() re-raises exceptions of write(). */
+    free(p_slacks);
+    p_slacks = NULL;
+    if (0 != rbstream_close(&rbs, fp)) b_ret = FALSE;
+  } else {
+    report(lp, IMPORTANT, "%s: Parameter is not a string filename or an IO.\n",
+           __FUNCTION__);
+    free(p_slacks);
+    return Qnil;
+  }
+  free(p_slacks);
+  RETURN_BOOL(b_ret);
+}
+
 extern void init_lpsolve_constants();
 /*#include "lpconsts.h" */
 
@@ -2629,14 +8742,28 @@ extern void init_lpsolve_constants();
 void Init_lpsolve()
 {
   rb_cLPSolve = rb_define_class("LPSolve", rb_cObject);
+  rb_gc_register_address(&model_cache_dir);
   rb_define_alloc_func(rb_cLPSolve, lpsolve_alloc);
+  rb_eLPSolveRollback = rb_define_class_under(rb_cLPSolve, "Rollback",
+                                              rb_eStandardError);
 
   init_lpsolve_constants();
   
   /* Class functions */
+  rb_define_module_function(rb_cLPSolve, "load_binary", 
+                            lpsolve_load_binary, 1);
   rb_define_module_function(rb_cLPSolve, "make_lp",  lpsolve_make_lp, 2);
+  rb_define_singleton_method(rb_cLPSolve, "model_cache_dir",
+                             lpsolve_get_model_cache_dir, 0);
+  rb_define_singleton_method(rb_cLPSolve, "model_cache_dir=",
+                             lpsolve_set_model_cache_dir, 1);
   rb_define_module_function(rb_cLPSolve, "read_LP",  lpsolve_read_LP, 3);
   rb_define_module_function(rb_cLPSolve, "read_MPS", lpsolve_read_MPS, 2);
+  rb_define_module_function(rb_cLPSolve, "read_many", lpsolve_read_many, -1);
+  rb_define_module_function(rb_cLPSolve, "from_matrix_market", 
+                            lpsolve_from_matrix_market, -1);
+  rb_define_module_function(rb_cLPSolve, "from_triplets_csv", 
+                            lpsolve_from_triplets_csv, -1);
   rb_define_module_function(rb_cLPSolve, "version",  lpsolve_version, 0);
 
   /* Class Methods */
@@ -2644,8 +8771,11 @@ void Init_lpsolve()
                    lpsolve_add_constraintex, 4);
   rb_define_method(rb_cLPSolve, "add_SOS",          lpsolve_add_SOS, 4);
   rb_define_method(rb_cLPSolve, "default_basis",    lpsolve_default_basis, 0);
+  rb_define_method(rb_cLPSolve, "get_basis",        lpsolve_get_basis, -1);
+  rb_define_method(rb_cLPSolve, "guess_basis",      lpsolve_guess_basis, 1);
   rb_define_method(rb_cLPSolve, "del_column",       lpsolve_del_column, 1);
   rb_define_method(rb_cLPSolve, "del_constraint",   lpsolve_del_constraint, 1);
+  rb_define_method(rb_cLPSolve, "flush_log",        lpsolve_flush_log, 0);
   rb_define_method(rb_cLPSolve, "get_bb_depthlimit",
                    lpsolve_get_bb_depthlimit, 0);
   rb_define_method(rb_cLPSolve, "get_bb_rule",      lpsolve_get_bb_rule, 0);
@@ -2664,6 +8794,11 @@ void Init_lpsolve()
   rb_define_method(rb_cLPSolve, "get_nonzeros",     lpsolve_get_nonzeros, 0);
   rb_define_method(rb_cLPSolve, "get_mat",          lpsolve_get_mat, 2);
   rb_define_method(rb_cLPSolve, "get_objective",    lpsolve_get_objective, 0);
+  rb_define_method(rb_cLPSolve, "get_index_map",    lpsolve_get_index_map, 0);
+  rb_define_method(rb_cLPSolve, "get_lp_index",     lpsolve_get_lp_index, 1);
+  rb_define_method(rb_cLPSolve, "get_orig_index",   lpsolve_get_orig_index, 1);
+  rb_define_method(rb_cLPSolve, "get_orig_solution", 
+                   lpsolve_get_orig_solution, 0);
   rb_define_method(rb_cLPSolve, "get_origcol_name",
                    lpsolve_get_origcol_name, 1);
   rb_define_method(rb_cLPSolve, "get_origrow_name",
@@ -2683,24 +8818,33 @@ void Init_lpsolve()
   rb_define_method(rb_cLPSolve, "get_solutionlimit",
                    lpsolve_get_solutionlimit, 0);
   rb_define_method(rb_cLPSolve, "get_status",       lpsolve_get_status, 0);
+  rb_define_method(rb_cLPSolve, "get_termination",  lpsolve_get_termination, 0);
   rb_define_method(rb_cLPSolve, "get_statustext",   lpsolve_get_statustext, -1);
   rb_define_method(rb_cLPSolve, "get_timeout",      lpsolve_get_timeout, 0);
   rb_define_method(rb_cLPSolve, "get_total_iter",   lpsolve_get_total_iter, 0);
   rb_define_method(rb_cLPSolve, "get_upbo",         lpsolve_get_upbo, 1);
+  rb_define_method(rb_cLPSolve, "get_var_branch",   lpsolve_get_var_branch, 1);
   rb_define_method(rb_cLPSolve, "get_var_dualresult", 
                    lpsolve_get_var_dualresult, 1);
   rb_define_method(rb_cLPSolve, "get_var_primalresult", 
                    lpsolve_get_var_primalresult, 1);
+  rb_define_method(rb_cLPSolve, "get_var_priority", lpsolve_get_var_priority, 1);
   rb_define_method(rb_cLPSolve, "get_variables",    lpsolve_get_variables, 0);
   rb_define_method(rb_cLPSolve, "get_verbose",      lpsolve_get_verbose, 0);
   rb_define_method(rb_cLPSolve, "initialize",       lpsolve_initialize, 2);
+  rb_define_method(rb_cLPSolve, "initialize_copy",  lpsolve_initialize_copy, 1);
   rb_define_method(rb_cLPSolve, "is_debug",         lpsolve_is_debug, 0);
   rb_define_method(rb_cLPSolve, "is_maxim",         lpsolve_is_maxim, 0);
   rb_define_method(rb_cLPSolve, "is_SOS_var",       lpsolve_is_SOS_var, 1);
   rb_define_method(rb_cLPSolve, "presolve=",        lpsolve_set_presolve1, 1);
+  rb_define_method(rb_cLPSolve, "presolve_once",    lpsolve_presolve_once, -1);
+  rb_define_method(rb_cLPSolve, "marshal_dump",     lpsolve_marshal_dump, 0);
+  rb_define_method(rb_cLPSolve, "marshal_load",     lpsolve_marshal_load, 1);
   rb_define_method(rb_cLPSolve, "print",            lpsolve_print, 0);
+  rb_define_method(rb_cLPSolve, "print_sparse",     lpsolve_print_sparse, -1);
   rb_define_method(rb_cLPSolve, "print_debugdump",  
                    lpsolve_print_debugdump, 1);
+  rb_define_method(rb_cLPSolve, "capture_output",   lpsolve_capture_output, 0);
   rb_define_method(rb_cLPSolve, "print_constraints",
                    lpsolve_print_constraints, 1);
   rb_define_method(rb_cLPSolve, "print_duals",      lpsolve_print_duals, 0);
@@ -2709,10 +8853,16 @@ void Init_lpsolve()
   rb_define_method(rb_cLPSolve, "print_str",        lpsolve_print_str, 1);
   rb_define_method(rb_cLPSolve, "print_solution",   lpsolve_print_solution, 1);
   rb_define_method(rb_cLPSolve, "print_tableau",    lpsolve_print_tableau, 0);
-  rb_define_method(rb_cLPSolve, "put_logfunc",      lpsolve_put_logfunc, 1);
+  rb_define_method(rb_cLPSolve, "put_bb_branchfunc", 
+                   lpsolve_put_bb_branchfunc, 0);
+  rb_define_method(rb_cLPSolve, "put_bb_nodefunc",  lpsolve_put_bb_nodefunc, 0);
+  rb_define_method(rb_cLPSolve, "put_logfunc",      lpsolve_put_logfunc, -1);
+  rb_define_method(rb_cLPSolve, "put_msgfunc",      lpsolve_put_msgfunc, -1);
+  rb_define_method(rb_cLPSolve, "save_binary",      lpsolve_save_binary, 1);
   rb_define_method(rb_cLPSolve, "set_add_rowmode",  lpsolve_set_add_rowmode, 1);
   rb_define_method(rb_cLPSolve, "set_bb_depthlimit",
                    lpsolve_set_bb_depthlimit, 1);
+  rb_define_method(rb_cLPSolve, "set_basis",        lpsolve_set_basis, 1);
   rb_define_method(rb_cLPSolve, "set_bb_rule",      lpsolve_set_bb_rule, 1);
   rb_define_method(rb_cLPSolve, "set_binary",       lpsolve_set_binary, 2);
   rb_define_method(rb_cLPSolve, "set_bounds",       lpsolve_set_bounds, 3);
@@ -2727,11 +8877,13 @@ void Init_lpsolve()
   rb_define_method(rb_cLPSolve, "set_lp_name",      lpsolve_set_lp_name, 1);
   rb_define_method(rb_cLPSolve, "set_obj_fnex",     lpsolve_set_obj_fnex, 1);
   rb_define_method(rb_cLPSolve, "set_outputfile",   lpsolve_set_outputfile, 1);
+  rb_define_method(rb_cLPSolve, "set_output_io",    lpsolve_set_output_io, 1);
   rb_define_method(rb_cLPSolve, "set_presolve",     lpsolve_set_presolve, 2);
   rb_define_method(rb_cLPSolve, "set_rh",           lpsolve_set_rh, 2);
   rb_define_method(rb_cLPSolve, "set_rh_range",     lpsolve_set_rh_range, 2);
   rb_define_method(rb_cLPSolve, "set_row_name",     lpsolve_set_row_name, 2);
   rb_define_method(rb_cLPSolve, "set_semicont",     lpsolve_set_semicont, 2);
+  rb_define_method(rb_cLPSolve, "set_sensitivity",  lpsolve_set_sensitivity, 1);
   rb_define_method(rb_cLPSolve, "set_scaling",      lpsolve_set_scaling, 1);
   rb_define_method(rb_cLPSolve, "set_simplextype",  lpsolve_set_simplextype, 1);
   rb_define_method(rb_cLPSolve, "set_solutionlimit",
@@ -2740,26 +8892,44 @@ void Init_lpsolve()
   rb_define_method(rb_cLPSolve, "set_timeout",      lpsolve_set_timeout, 1);
   rb_define_method(rb_cLPSolve, "set_trace",        lpsolve_set_trace, 1);
   rb_define_method(rb_cLPSolve, "set_upbo",         lpsolve_set_upbo, 2);
+  rb_define_method(rb_cLPSolve, "set_var_branch",   lpsolve_set_var_branch, 2);
+  rb_define_method(rb_cLPSolve, "set_var_weights",  lpsolve_set_var_weights, 1);
   rb_define_method(rb_cLPSolve, "set_verbose",      lpsolve_set_verbose, 1);
-  rb_define_method(rb_cLPSolve, "solve",            lpsolve_solve, 0);
+  rb_define_method(rb_cLPSolve, "shift_horizon",    lpsolve_shift_horizon, 2);
+  rb_define_method(rb_cLPSolve, "solve",            lpsolve_solve, -1);
+  rb_define_method(rb_cLPSolve, "solve_lexicographic", 
+                   lpsolve_solve_lexicographic, 2);
+  rb_define_method(rb_cLPSolve, "solve_with_column_generation", 
+                   lpsolve_solve_with_column_generation, -1);
+  rb_define_method(rb_cLPSolve, "solve_with_cuts",  lpsolve_solve_with_cuts, -1);
   rb_define_method(rb_cLPSolve, "str_add_column",   lpsolve_str_add_column, 
                    1);
   rb_define_method(rb_cLPSolve, "str_add_constraint", 
                    lpsolve_str_add_constraint, 3);
   rb_define_method(rb_cLPSolve, "str_set_obj_fn", 
                    lpsolve_str_set_obj_fn, 1);
+  rb_define_method(rb_cLPSolve, "sweep_obj",        lpsolve_sweep_obj, 2);
+  rb_define_method(rb_cLPSolve, "sweep_rhs",        lpsolve_sweep_rhs, 2);
   rb_define_method(rb_cLPSolve, "time_elapsed",     lpsolve_time_elapsed, 0);
   rb_define_method(rb_cLPSolve, "time_load",        lpsolve_time_load, 0);
   rb_define_method(rb_cLPSolve, "time_presolve",    lpsolve_time_presolve, 0);
   rb_define_method(rb_cLPSolve, "time_simplex",     lpsolve_time_simplex, 0);
   rb_define_method(rb_cLPSolve, "time_total",       lpsolve_time_total, 0);
+  rb_define_method(rb_cLPSolve, "to_lp_string",     lpsolve_to_lp_string, 0);
+  rb_define_method(rb_cLPSolve, "to_mps_string",    lpsolve_to_mps_string, 0);
+  rb_define_method(rb_cLPSolve, "transaction",      lpsolve_transaction, 0);
   rb_define_method(rb_cLPSolve, "unscale",          lpsolve_unscale, 0);
   rb_define_method(rb_cLPSolve, "version",          lpsolve_version, 0);
   rb_define_method(rb_cLPSolve, "write_basis",      lpsolve_write_basis, 1);
   rb_define_method(rb_cLPSolve, "write_lp",         lpsolve_write_lp, -1);
+  rb_define_method(rb_cLPSolve, "with_overrides",   lpsolve_with_overrides, -1);
+  rb_define_method(rb_cLPSolve, "write_arrow",      lpsolve_write_arrow, -1);
+  rb_define_method(rb_cLPSolve, "write_solution",   lpsolve_write_solution, -1);
   rb_define_method(rb_cLPSolve, "write_mps",        lpsolve_write_mps, -1);
 
   /* Aliases accessors. */
+  rb_define_alias(rb_cLPSolve, "basis",          "get_basis");
+  rb_define_alias(rb_cLPSolve, "basis=",         "set_basis");
   rb_define_alias(rb_cLPSolve, "bb_rule",        "get_bb_rule");
   rb_define_alias(rb_cLPSolve, "bb_rule=",       "set_bb_rule");
   rb_define_alias(rb_cLPSolve, "bb_depthlimit",  "get_bb_depthlimit");
@@ -2784,11 +8954,13 @@ void Init_lpsolve()
   rb_define_alias(rb_cLPSolve, "status",         "get_status");
   rb_define_alias(rb_cLPSolve, "status=",        "set_status");
   rb_define_alias(rb_cLPSolve, "statustext",     "get_statustext");
+  rb_define_alias(rb_cLPSolve, "termination",    "get_termination");
   rb_define_alias(rb_cLPSolve, "simplextype",    "get_simplextype");
   rb_define_alias(rb_cLPSolve, "simplextype=",   "set_simplextype");
   rb_define_alias(rb_cLPSolve, "solutioncount",  "get_solutioncount");
   rb_define_alias(rb_cLPSolve, "solutionlimit",  "get_solutionlimit");
   rb_define_alias(rb_cLPSolve, "solutionlimit=", "set_solutionlimit");
+  rb_define_alias(rb_cLPSolve, "set_var_priority", "set_var_weights");
   rb_define_alias(rb_cLPSolve, "sos_var?",       "is_SOS_var");
   rb_define_alias(rb_cLPSolve, "timeout",        "get_timeout");
   rb_define_alias(rb_cLPSolve, "timeout=",       "set_timeout");
@@ -2933,3 +9105,146 @@ void print(lprec *lp)
   }
   fflush(lp->outstream);
 }
+
+/* Print a bound or right-hand side, using "Inf" for infinity. */
+static void
+print_bound(lprec *lp, const char *label, REAL val)
+{
+  if (val >= lp->infinite)
+    fprintf(lp->outstream, "  %s = Inf", label);
+  else if (val <= -lp->infinite)
+    fprintf(lp->outstream, "  %s = -Inf", label);
+  else
+    fprintf(lp->outstream, "  %s = %g", label, val);
+}
+
+/* A sparse version of print(): only nonzeros are visited, and only
+   the first max_rows rows and max_cols columns are listed. */
+void print_sparse(lprec *lp, int max_rows, int max_cols)
+{
+  int   i, j, n;
+  int   rows = lp->rows, columns = lp->columns;
+  long  nonzeros = 0, obj_nonzeros = 0, omitted = 0;
+  int   col_min_nz = -1, col_max_nz = 0, empty_columns = 0, int_columns = 0;
+  REAL  abs_min = 0.0, abs_max = 0.0;
+  int   *row_nz, *nzrow;
+  REAL  *column;
+
+  if(lp->outstream == NULL)
+    return;
+
+  if(lp->matA->is_roworder) {
+    report(lp, IMPORTANT, "REPORT_lp: Cannot print lp while in row entry mode.\n");
+    return;
+  }
+
+  if (max_rows < 0 || max_rows > rows) max_rows = rows;
+  if (max_cols < 0 || max_cols > columns) max_cols = columns;
+
+  row_nz = calloc(rows + 1, sizeof(int));
+  nzrow  = malloc((rows + 1) * sizeof(int));
+  column = malloc((rows + 1) * sizeof(REAL));
+  if (NULL == row_nz || NULL == nzrow || NULL == column) {
+    report(lp, IMPORTANT, "%s: Out of memory.\n", __FUNCTION__);
+    free(row_nz); free(nzrow); free(column);
+    return;
+  }
+
+  fprintf(lp->outstream, "Model name: %s\n", get_lp_name(lp));
+  fprintf(lp->outstream, "%simize, %d rows, %d columns\n\n", 
+          (is_maxim(lp) ? "Max" : "Min"), rows, columns);
+
+  for(j = 1; j <= columns; j++) {
+    int col_nz = 0;
+    n = get_columnex(lp, j, column, nzrow);
+    if (j <= max_cols) {
+      fprintf(lp->outstream, "%s %s", get_col_name(lp, j), 
+              is_int(lp, j) ? "Int" : "Real");
+      print_bound(lp, "lowbo", get_lowbo(lp, j));
+      print_bound(lp, "upbo", get_upbo(lp, j));
+      if (is_SOS_var(lp, j)) fprintf(lp->outstream, "  SOS");
+      fprintf(lp->outstream, "\n");
+    }
+    for (i = 0; i < n; i++) {
+      REAL abs_val = fabs(column[i]);
+      if (0 == nzrow[i]) {
+        obj_nonzeros++;
+        if (j <= max_cols)
+          fprintf(lp->outstream, "    %-16s %12g\n", "(objective)", column[i]);
+        continue;
+      }
+      col_nz++;
+      row_nz[nzrow[i]]++;
+      if (0 == nonzeros || abs_val < abs_min) abs_min = abs_val;
+      if (abs_val > abs_max) abs_max = abs_val;
+      nonzeros++;
+      if (j > max_cols) continue;
+      if (nzrow[i] <= max_rows)
+        fprintf(lp->outstream, "    %-16s %12g\n", 
+                get_row_name(lp, nzrow[i]), column[i]);
+      else
+        omitted++;
+    }
+    if (j <= max_cols && omitted > 0) {
+      fprintf(lp->outstream, "    ... %ld more\n", omitted);
+      omitted = 0;
+    }
+    if (0 == col_nz) empty_columns++;
+    if (col_min_nz < 0 || col_nz < col_min_nz) col_min_nz = col_nz;
+    if (col_nz > col_max_nz) col_max_nz = col_nz;
+    if (is_int(lp, j)) int_columns++;
+  }
+  if (max_cols < columns)
+    fprintf(lp->outstream, "... %d more columns\n", columns - max_cols);
+
+  fprintf(lp->outstream, "\nRows:\n");
+  for(i = 1; i <= max_rows; i++) {
+    fprintf(lp->outstream, "%s: %d nonzeros ", get_row_name(lp, i), row_nz[i]);
+    if(is_constr_type(lp, i, GE))
+      fprintf(lp->outstream, ">= ");
+    else if(is_constr_type(lp, i, LE))
+      fprintf(lp->outstream, "<= ");
+    else
+      fprintf(lp->outstream, " = ");
+    fprintf(lp->outstream, "%g", get_rh(lp, i));
+    if(is_constr_type(lp, i, GE) && get_rh_upper(lp, i) < lp->infinite)
+      print_bound(lp, "upbo", get_rh_upper(lp, i));
+    else if(is_constr_type(lp, i, LE) && get_rh_lower(lp, i) > -lp->infinite)
+      print_bound(lp, "lowbo", get_rh_lower(lp, i));
+    fprintf(lp->outstream, "\n");
+  }
+  if (max_rows < rows)
+    fprintf(lp->outstream, "... %d more rows\n", rows - max_rows);
+
+  {
+    int row_min_nz = (rows > 0) ? row_nz[1] : 0, row_max_nz = 0;
+    int empty_rows = 0;
+    for(i = 1; i <= rows; i++) {
+      if (row_nz[i] < row_min_nz) row_min_nz = row_nz[i];
+      if (row_nz[i] > row_max_nz) row_max_nz = row_nz[i];
+      if (0 == row_nz[i]) empty_rows++;
+    }
+    fprintf(lp->outstream, "\nStatistics:\n");
+    fprintf(lp->outstream, "  Nonzeros: %ld constraint, %ld objective", 
+            nonzeros, obj_nonzeros);
+    if (rows > 0 && columns > 0)
+      fprintf(lp->outstream, " (density %.4g%%)", 
+              100.0 * nonzeros / ((double) rows * columns));
+    fprintf(lp->outstream, "\n");
+    if (nonzeros > 0)
+      fprintf(lp->outstream, "  |Coefficient| range: [%g, %g]\n", 
+              abs_min, abs_max);
+    fprintf(lp->outstream, "  Nonzeros per row: %d to %d, %d empty rows\n",
+            row_min_nz, row_max_nz, empty_rows);
+    fprintf(lp->outstream, 
+            "  Nonzeros per column: %d to %d, %d empty columns\n",
+            (col_min_nz < 0) ? 0 : col_min_nz, col_max_nz, empty_columns);
+    fprintf(lp->outstream, "  Integer columns: %d, SOS constraints: %d\n",
+            int_columns, (NULL != lp->SOS) ? lp->SOS->sos_count : 0);
+  }
+
+  free(row_nz);
+  free(nzrow);
+  free(column);
+  fflush(lp->outstream);
+}
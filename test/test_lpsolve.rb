@@ -410,6 +410,751 @@ class TestLPSolve < Test::Unit::TestCase
     # assert(lp.write_mps())
   end
 
+  # Check to_lp_string(), to_mps_string() and writing to an IO
+  def test_write_string
+    require 'stringio'
+    lp = LPSolve.read_MPS("../example/model.mps", LPSolve::IMPORTANT)
+    assert(lp.write_lp("foo.lp"))
+    assert_equal(File.read("foo.lp"), lp.to_lp_string)
+    assert(lp.write_mps("foo.mps"))
+    assert_equal(File.read("foo.mps"), lp.to_mps_string)
+    io = StringIO.new
+    assert(lp.write_lp(io))
+    assert_equal(lp.to_lp_string, io.string)
+    io = StringIO.new
+    assert(lp.write_mps(io))
+    assert_equal(lp.to_mps_string, io.string)
+    assert_equal(nil, lp.write_lp(5))
+  end
+
+  # Check set_output_io() and capture_output()
+  def test_output_io
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    out = lp.capture_output { lp.print_str("print_str() test\n") }
+    assert_equal("print_str() test\n", out)
+    out = lp.capture_output { lp.print_lp }
+    assert_match(/LP model/, out)
+    assert_equal("", lp.capture_output { })
+
+    require 'stringio'
+    io = StringIO.new
+    assert(lp.set_output_io(io))
+    lp.print_str("one\n")
+    assert_equal("two\n", lp.capture_output { lp.print_str("two\n") })
+    lp.print_str("three\n")
+    assert(lp.set_output_io(nil))
+    assert_equal("one\nthree\n", io.string)
+    assert_equal(false, lp.set_output_io(5))
+
+    assert_raise(RuntimeError) { lp.set_output_io("frozen".freeze) }
+    buf = String.new
+    assert(lp.set_output_io(buf))
+    lp.print_str("four\n")
+    buf.freeze
+    lp.print_str("five\n")
+    assert_raise(RuntimeError) { lp.set_output_io(nil) }
+    assert_equal("four\n", buf)
+    assert(lp.set_output_io(nil))
+  end
+
+  # Check print_sparse()
+  def test_print_sparse
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    out = lp.capture_output { assert(lp.print_sparse) }
+    assert_match(/^Model name: LP model$/, out)
+    assert_match(/^Statistics:$/, out)
+    assert_no_match(/more (rows|columns)/, out)
+    out = lp.capture_output { assert(lp.print_sparse(1, 1)) }
+    assert_match(/^\.\.\. #{lp.Nrows - 1} more rows$/, out)
+    assert_match(/^\.\.\. #{lp.Ncolumns - 1} more columns$/, out)
+    assert_equal(false, lp.print_sparse("1"))
+  end
+
+  # Check write_solution() in its three formats
+  def test_write_solution
+    require 'stringio'
+    require 'json'
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_sensitivity(true)
+    assert_equal(0, lp.solve)
+
+    io = StringIO.new
+    assert(lp.write_solution(io))
+    lines = io.string.split("\n")
+    assert_equal("type,index,name,value,dual,slack", lines[0])
+    assert_equal(1 + lp.Ncolumns + lp.Nrows, lines.size)
+    var = lines[1].split(",")
+    assert_equal(["var", "1", lp.get_col_name(1)], var[0..2])
+    assert_in_delta(lp.variables[0], var[3].to_f, 0.0001)
+
+    io = StringIO.new
+    assert(lp.write_solution(io, format: :ndjson, include: [:primal]))
+    records = io.string.split("\n").map { |line| JSON.parse(line) }
+    assert_equal(lp.Ncolumns, records.size)
+    assert_equal(["index", "name", "type", "value"], records[0].keys.sort)
+
+    io = StringIO.new
+    assert(lp.write_solution(io, format: :binary, include: [:primal, :dual]))
+    data = io.string
+    assert_equal("LPSOLN\r\n", data[0, 8])
+    assert_equal(8 * (lp.Ncolumns + lp.Nrows), data.size - 40)
+    assert_in_delta(lp.objective, data[32, 8].unpack("d")[0], 0.0001)
+
+    plain = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP")
+    plain.set_int(1, true)
+    assert_equal(0, plain.solve)
+    io = StringIO.new
+    assert(plain.write_solution(io))
+    assert_equal(1 + plain.Ncolumns + plain.Nrows, io.string.split("\n").size)
+
+    assert_raise(ArgumentError) { lp.write_solution(io, format: :xml) }
+    assert_raise(ArgumentError) { lp.write_solution(io, include: [:foo]) }
+    assert_equal(nil, lp.write_solution(5))
+
+    # A call that fails leaves an existing file alone
+    File.open("foo.sol", "w") { |f| f.write("keep") }
+    plain.set_verbose(LPSolve::NEUTRAL)
+    assert_equal(false, plain.write_solution("foo.sol", include: [:dual]))
+    assert_equal("keep", File.read("foo.sol"))
+  ensure
+    File.delete("foo.sol") if File.exist?("foo.sol")
+  end
+
+  # Check read_many()
+  def test_read_many
+    paths = ["../example/model.mps", "no-such-file.mps", "../example/model.lp",
+             "../example/lp.mps"]
+    models = LPSolve.read_many(paths, threads: 2)
+    assert_equal(paths.size, models.size)
+    assert_equal(LPSolve, models[0].class)
+    assert_equal(LPSolve.read_MPS(paths[0], LPSolve::IMPORTANT).to_mps_string,
+                 models[0].to_mps_string)
+    assert_kind_of(SystemCallError, models[1])
+    assert_kind_of(RuntimeError, models[2])
+    assert_equal(LPSolve, models[3].class)
+
+    models = LPSolve.read_many(["../example/model.lp"] * 3, format: :lp)
+    assert_equal([LPSolve] * 3, models.map(&:class))
+    assert_equal([], LPSolve.read_many([]))
+    assert_raise(ArgumentError) { LPSolve.read_many(paths, format: :xli) }
+  end
+
+  # Check from_matrix_market() and from_triplets_csv() against model.lp
+  def test_sparse_import
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.solve
+    File.open("foo.mtx", "w") do |f|
+      f.puts "%%MatrixMarket matrix coordinate real general"
+      f.puts "% model.lp"
+      f.puts "3 2 6"
+      f.puts "1 1 120", "1 2 210", "2 1 110", "2 2 30", "3 1 1", "3 2 1"
+    end
+    File.open("foo.csv", "w") do |f|
+      f.puts "row,col,value"
+      f.puts "0,0,120", "0,1,200", "1,0,110", "1,1,30", "2,0,1", "2,1,1",
+             "0,1,10"
+    end
+    opts = {:obj => [143, 60], :rhs => [15000, 4000, 75], :maximize => true}
+    [LPSolve.from_matrix_market("foo.mtx", **opts),
+     LPSolve.from_triplets_csv("foo.csv", base: 0, **opts)].each do |copy|
+      assert_equal(LPSolve, copy.class)
+      assert_equal([3, 2], [copy.Nrows, copy.Ncolumns])
+      assert_equal(0, copy.solve)
+      assert_in_delta(lp.objective, copy.objective, 0.0001)
+    end
+    copy = LPSolve.from_triplets_csv("foo.csv", base: 0, rows: 4, 
+                                     constr_type: LPSolve::GE)
+    assert_equal([4, 2], [copy.Nrows, copy.Ncolumns])
+    assert_match(/>= 0;/, copy.to_lp_string)
+    assert_raise(ArgumentError) do
+      LPSolve.from_matrix_market("foo.mtx", obj: [1, 2, 3])
+    end
+    assert_equal(nil, LPSolve.from_matrix_market("foo.csv"))
+    File.open("foo.mtx", "w") do |f|
+      f.puts "%%MatrixMarket matrix coordinate real general", "3 2 7"
+      f.puts "1 1 120", "1 2 210", "2 1 110", "2 2 30", "3 1 1", "3 2 1"
+    end
+    assert_equal(nil, LPSolve.from_matrix_market("foo.mtx"))
+    assert_raise(ArgumentError) { LPSolve.from_triplets_csv("foo.csv", base: -1) }
+    assert_equal(nil, LPSolve.from_matrix_market("no-such-file.mtx"))
+  ensure
+    File.delete("foo.mtx") if File.exist?("foo.mtx")
+    File.delete("foo.csv") if File.exist?("foo.csv")
+  end
+
+  # Check the framing of write_arrow() output
+  def test_write_arrow
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_sensitivity(true)
+    assert_equal(0, lp.solve)
+    assert(lp.write_arrow("foo.arrow"))
+    data = File.binread("foo.arrow")
+    assert_equal("ARROW1\0\0", data[0, 8])
+    assert_equal("ARROW1", data[-6, 6])
+    footer_length = data[-10, 4].unpack("l<")[0]
+    assert_equal(0, footer_length % 8)
+    assert_equal([-1], data[8, 4].unpack("l<"))
+    assert(data.include?("reduced_cost"))
+
+    require 'stringio'
+    io = StringIO.new
+    assert(lp.write_arrow(io, table: :constraints, batch_size: 1))
+    assert_equal("ARROW1", io.string[-6, 6])
+    assert(io.string.include?("slack"))
+    assert_raise(ArgumentError) { lp.write_arrow(io, table: :foo) }
+    assert_raise(ArgumentError) { lp.write_arrow(io, batch_size: 0) }
+
+    unsolved = LPSolve.read_LP("../example/model.lp", LPSolve::NEUTRAL, "LP")
+    assert_equal(false, unsolved.write_arrow("foo.arrow"))
+    assert_equal(data, File.binread("foo.arrow"))
+  ensure
+    File.delete("foo.arrow") if File.exist?("foo.arrow")
+  end
+
+  # Check get_basis(), set_basis() and guess_basis() for warm starts
+  def test_basis
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    assert_equal(0, lp.solve)
+    size = 1 + lp.Nrows + lp.Ncolumns
+    basis = lp.get_basis(true)
+    assert_equal(size, basis.unpack("i*").size)
+    assert_equal(1 + lp.Nrows, lp.get_basis.unpack("i*").size)
+
+    warm = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    assert(warm.set_basis(basis))
+    assert_equal(0, warm.solve)
+    assert_in_delta(lp.objective, warm.objective, 0.0001)
+    assert(warm.total_iter <= lp.total_iter)
+    assert(warm.set_basis(basis.unpack("i*")))
+    assert_equal(false, warm.set_basis([1, 2]))
+
+    guess = warm.guess_basis(lp.variables)
+    assert_equal(size, guess.unpack("i*").size)
+    assert_equal(guess, warm.guess_basis(lp.variables.pack("d*")))
+    assert(warm.set_basis(guess))
+    assert_equal(0, warm.solve)
+    assert_in_delta(lp.objective, warm.objective, 0.0001)
+    assert_equal(nil, warm.guess_basis([1.0]))
+  end
+
+  # Check dup and clone
+  def test_dup
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_col_name(1, "xx")
+    lp.set_mip_gap(true, 0.5)
+    copy = lp.dup
+    assert_equal(lp.to_lp_string, copy.to_lp_string)
+    assert_equal("xx", copy.get_col_name(1))
+    assert_equal(0.5, copy.get_mip_gap(true))
+
+    copy.set_upbo(1, 10)
+    assert_not_equal(lp.to_lp_string, copy.to_lp_string)
+    assert_equal(0, lp.solve)
+    assert_equal(0, copy.solve)
+    assert(copy.objective < lp.objective)
+
+    warm = lp.clone
+    assert_not_equal(0, warm.status)
+    assert_equal(0, warm.solve)
+    assert_in_delta(lp.objective, warm.objective, 0.0001)
+    assert(warm.total_iter <= lp.total_iter)
+  end
+
+  # Check with_overrides() restores exactly what it changed
+  def test_with_overrides
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    before = lp.to_lp_string
+    assert_equal(0, lp.solve)
+    base = lp.objective
+
+    objective = lp.with_overrides(bounds: {1 => [nil, 10]}, rhs: {3 => 50},
+                                  obj: {2 => 70}, types: {1 => :int}) do |m|
+      assert_same(lp, m)
+      assert_equal(10, m.get_upbo(1))
+      assert_not_equal(before, m.to_lp_string)
+      m.solve
+      m.objective
+    end
+    assert(objective < base)
+    assert_equal(before, lp.to_lp_string)
+
+    assert_raise(IndexError) do
+      lp.with_overrides(rhs: {1 => 1, 99 => 1}) { flunk }
+    end
+    assert_raise(RuntimeError) do
+      lp.with_overrides(obj: {1 => 0}) { raise "boom" }
+    end
+    assert_equal(before, lp.to_lp_string)
+    assert_equal(0, lp.solve)
+    assert_in_delta(base, lp.objective, 0.0001)
+
+    # Deleting would renumber what the undo log refers to.
+    lp.set_verbose(LPSolve::NEUTRAL)
+    lp.with_overrides(rhs: {3 => 50.0}) do
+      assert_equal(false, lp.del_constraint(1))
+      assert_equal(false, lp.del_column(1))
+      assert_equal(3, lp.Nrows)
+    end
+    assert_equal(before, lp.to_lp_string)
+    assert(lp.del_constraint(1))
+  end
+
+  # Check transaction() rolls back on exceptions and commits otherwise
+  def test_transaction
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    before = lp.to_lp_string
+    rows = lp.get_Nrows
+
+    assert_raise(RuntimeError) do
+      lp.transaction do |m|
+        assert_same(lp, m)
+        m.set_upbo(1, 10)
+        m.set_rh(1, 50)
+        m.set_int(2, true)
+        m.set_obj_fnex([[1, 5]])
+        m.add_constraintex("extra", [[1, 1], [2, 1]], LPSolve::LE, 7)
+        m.set_minim
+        assert(!m.del_column(1))
+        assert(!m.set_upbo(lp.Ncolumns + 1, 1))
+        assert(!m.set_mat(lp.Nrows + 1, 1, 1))
+        raise "boom"
+      end
+    end
+    assert_equal(rows, lp.get_Nrows)
+    assert_equal(before, lp.to_lp_string)
+
+    assert_nil(lp.transaction { |m| m.set_lowbo(1, 3); raise LPSolve::Rollback })
+    assert_equal(before, lp.to_lp_string)
+
+    result = lp.transaction do |m|
+      m.set_upbo(1, 10)
+      m.transaction { |inner| inner.set_upbo(2, 20); raise LPSolve::Rollback }
+      :done
+    end
+    assert_equal(:done, result)
+    assert_equal(10, lp.get_upbo(1))
+    assert_not_equal(20, lp.get_upbo(2))
+
+    # break, throw and a failed outer block after an inner break.
+    lp.transaction { |m| m.set_upbo(2, 30); break }
+    assert_equal(30, lp.get_upbo(2))
+    catch(:out) { lp.transaction { |m| m.set_upbo(2, 40); throw :out } }
+    assert_equal(40, lp.get_upbo(2))
+    assert_raise(RuntimeError) do
+      lp.transaction do |m|
+        m.transaction { |inner| inner.set_upbo(2, 50); break }
+        assert_equal(50, m.get_upbo(2))
+        raise "boom"
+      end
+    end
+    assert_equal(40, lp.get_upbo(2))
+    assert(lp.del_column(1))
+  end
+
+  # Check sweep_rhs() and sweep_obj()
+  def test_sweep
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    before = lp.to_lp_string
+    values = (0..15).map { |i| 5.0 * i }
+    curve = lp.sweep_rhs(3, values)
+    assert_equal(values.size, curve[:objective].size)
+    assert_equal([0] * values.size, curve[:status])
+    assert(curve[:objective].each_cons(2).all? { |a, b| a <= b + 0.0001 })
+    assert(!curve[:breakpoints].empty?)
+    assert_equal(before, lp.to_lp_string)
+
+    assert_equal(0, lp.solve)
+    base = lp.objective
+    packed = lp.sweep_obj(1, [143.0, 200.0].pack("d*"))
+    assert_in_delta(base, packed[:objective][0], 0.0001)
+    assert(packed[:objective][1] > base)
+    assert_equal(before, lp.to_lp_string)
+    assert_nil(lp.sweep_rhs(99, [1.0]))
+  end
+
+  # Check shift_horizon()
+  def test_shift_horizon
+    # Three periods of (produce, stock) with a stock balance row each.
+    lp = LPSolve.new(0, 6)
+    lp.set_verbose(LPSolve::IMPORTANT)
+    lp.set_obj_fnex([[1, 2], [2, 1], [3, 2], [4, 1], [5, 2], [6, 1]])
+    lp.add_constraintex("b1", [[2, 1], [1, -1]], LPSolve::EQ, -3)
+    lp.add_constraintex("b2", [[4, 1], [2, -1], [3, -1]], LPSolve::EQ, -4)
+    lp.add_constraintex("b3", [[6, 1], [4, -1], [5, -1]], LPSolve::EQ, -5)
+    lp.set_upbo(5, 8)
+    lp.set_int(6, true)
+    assert_equal(0, lp.solve)
+
+    assert(!lp.shift_horizon(4, 1))
+    assert(lp.shift_horizon(2, 1))
+    assert_equal(6, lp.get_Ncolumns)
+    assert_equal(3, lp.get_Nrows)
+    assert_equal(-5, lp.get_rh(2))
+    assert_equal(-5, lp.get_rh(3))
+    assert_equal(1, lp.get_mat(3, 6))
+    assert_equal(-1, lp.get_mat(3, 4))
+    assert_equal(-1, lp.get_mat(3, 5))
+    assert_equal(-1, lp.get_mat(1, 1))
+    assert_equal(1, lp.get_mat(1, 2))
+    assert_equal(8, lp.get_upbo(5))
+    assert_match(/^int /, lp.to_lp_string)
+    assert_equal(0, lp.solve)
+    assert_in_delta(2 * (4 + 5 + 5), lp.objective, 0.0001)
+
+    # Stock carried out of the first period is kept in the second.
+    lp = LPSolve.new(0, 4)
+    lp.set_verbose(LPSolve::IMPORTANT)
+    lp.set_obj_fnex([[1, 2], [2, 1], [3, 2], [4, 1]])
+    lp.add_constraintex("b1", [[2, 1], [1, -1]], LPSolve::EQ, -3)
+    lp.add_constraintex("b2", [[4, 1], [2, -1], [3, -1]], LPSolve::EQ, -4)
+    lp.set_lowbo(2, 2)
+    assert(!lp.shift_horizon(2, 1))
+    assert_equal(0, lp.solve)
+    assert(lp.shift_horizon(2, 1))
+    assert_equal(-2, lp.get_rh(1))
+    assert_equal(0, lp.solve)
+    assert_in_delta(2 * (2 + 4), lp.objective, 0.0001)
+  end
+
+  # Check solve_with_cuts()
+  def test_solve_with_cuts
+    lp = LPSolve.new(0, 2)
+    lp.set_verbose(LPSolve::IMPORTANT)
+    lp.set_obj_fnex([[1, 1], [2, 1]])
+    lp.set_maxim
+    lp.set_upbo(1, 10)
+    lp.set_upbo(2, 10)
+    seen = []
+    result = lp.solve_with_cuts(max_rounds: 5) do |x|
+      x, y = x.unpack("d*")
+      seen << x + y
+      if x + y > 5.0001
+        {offsets: [0, 2], columns: [1, 2], values: [1.0, 1.0], rhs: [5.0]}
+      end
+    end
+    assert_equal(0, result[:status])
+    assert_equal([20, 5], seen.map(&:round))
+    assert_equal(2, result[:rounds].size)
+    assert_equal(1, result[:rounds][0][:cuts_added])
+    assert_in_delta(5, result[:rounds][1][:objective], 0.0001)
+    assert_equal(1, lp.get_Nrows)
+
+    assert_raise(ArgumentError) do
+      lp.solve_with_cuts { {offsets: [0, 3], columns: [1], values: [1.0],
+                            rhs: [1.0]} }
+    end
+    assert_raise(ArgumentError) do
+      lp.solve_with_cuts { {offsets: [0, 1, 2], columns: [1, 2], 
+                            values: [1.0, 1.0], types: [LPSolve::LE, 42]} }
+    end
+    assert_equal(1, lp.get_Nrows)
+    lp.transaction do
+      assert_nil(lp.solve_with_cuts { nil })
+    end
+  end
+
+  # Check solve_with_column_generation()
+  def test_solve_with_column_generation
+    lp = LPSolve.new(0, 1)
+    lp.set_verbose(LPSolve::IMPORTANT)
+    lp.set_obj_fnex([[1, 3]])
+    lp.add_constraintex("demand", [[1, 1]], LPSolve::GE, 4)
+    prices = []
+    result = lp.solve_with_column_generation do |duals|
+      prices << duals.unpack("d*")
+      {offsets: [0, 2], rows: [0, 1], values: [1.0, 1.0]}
+    end
+    assert_equal(0, result[:status])
+    assert_equal([[3], [1]], prices.map { |d| d.map(&:round) })
+    assert_equal(2, result[:iterations].size)
+    assert_equal(1, result[:iterations][0][:columns_added])
+    assert_equal(0, result[:iterations][1][:columns_added])
+    assert_equal(2, lp.get_Ncolumns)
+    assert_in_delta(4, lp.objective, 0.0001)
+
+    # Sensitivity analysis was off before, so it is off again.
+    lp.set_verbose(LPSolve::NEUTRAL)
+    assert_equal(0, lp.solve)
+    assert(!lp.write_solution(StringIO.new, include: [:dual]))
+
+    lp.transaction do
+      assert_nil(lp.solve_with_column_generation { nil })
+    end
+  end
+
+  # Check presolve_once() and get_orig_solution()
+  def test_presolve_once
+    build = lambda do
+      lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+      lp.add_constraintex("cap", [[1, 1]], LPSolve::LE, 100)
+      lp
+    end
+    lp = build.call
+    assert_equal(0, lp.presolve_once)
+    assert_equal(LPSolve::PRESOLVE_NONE, lp.get_presolve)
+    assert_equal(4, lp.Norig_rows)
+    assert_equal(lp.Norig_columns, lp.Ncolumns)
+    map = lp.get_index_map
+    assert_equal(lp.Nrows, map[:rows].unpack("i*").size)
+    assert_equal(4, map[:orig_rows].unpack("i*").size)
+    assert_equal(lp.get_orig_index(1), map[:rows].unpack("i*")[0])
+    assert_equal([1, 2], map[:columns].unpack("i*"))
+    assert_equal([1, 2], map[:orig_columns].unpack("i*"))
+
+    row = lp.get_lp_index(3)
+    assert(row > 0)
+    lp.set_rh(row, 50)
+    assert_equal(0, lp.solve)
+    result = lp.get_orig_solution
+
+    fresh = build.call
+    fresh.set_rh(3, 50)
+    assert_equal(0, fresh.solve)
+    assert_in_delta(fresh.objective, result[:objective], 0.0001)
+    fresh.variables.zip(result[:variables].unpack("d*")).each do |a, b|
+      assert_in_delta(a, b, 0.0001)
+    end
+
+    lp.set_verbose(LPSolve::NEUTRAL)
+    lp.transaction do
+      assert_nil(lp.presolve_once)
+    end
+  end
+
+  # Check solve_lexicographic()
+  def test_solve_lexicographic
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    before = lp.to_lp_string
+    result = lp.solve_lexicographic([[[1, 1], [2, 1]], 
+                                     [143.0, 60.0].pack("d*")], [0])
+    assert_equal(0, result[:status])
+    assert_in_delta(75, result[:objectives][0], 0.0001)
+    assert_in_delta(6315.625, result[:objectives][1], 0.0001)
+    x, y = result[:variables].unpack("d*")
+    assert_in_delta(75, x + y, 0.0001)
+    assert_in_delta(21.875, x, 0.0001)
+    assert_equal(before, lp.to_lp_string)
+    assert_raise(ArgumentError) { lp.solve_lexicographic([[[3, 1]]], 0) }
+
+    # The objective constant is left out of the stages and put back.
+    lp.set_rh(0, 1000)
+    before = lp.to_lp_string
+    result = lp.solve_lexicographic([[[1, 1], [2, 1]]], 0)
+    assert_in_delta(75, result[:objectives][0], 0.0001)
+    assert_equal(before, lp.to_lp_string)
+  end
+
+  # Check put_logfunc() and flush_log()
+  def test_put_logfunc_batches
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    batches = []
+    lp.put_logfunc(level: LPSolve::DETAILED, batch: 4) { |b| batches << b }
+    assert_equal(0, lp.solve)
+    assert(!batches.empty?)
+    assert(batches.all? { |b| b.size.between?(1, 5) })
+    assert(batches.flatten.all? { |line| !line.end_with?("\n") })
+
+    logger = Object.new
+    def logger.add(severity, message) (@lines ||= []) << [severity, message] end
+    def logger.lines; @lines end
+    lp.put_logfunc(logger, severity: 2)
+    lp.solve
+    assert(logger.lines.all? { |severity, _| 2 == severity })
+
+    lp.put_logfunc { |b| raise "boom" }
+    assert_raise(RuntimeError) { lp.solve }
+    before = lp.to_lp_string
+    assert_raise(RuntimeError) { lp.sweep_rhs(3, [50.0, 60.0, 70.0]) }
+    assert_equal(before, lp.to_lp_string)
+    assert_raise(RuntimeError) { lp.solve_lexicographic([[[1, 1]]], 0) }
+    assert_equal(before, lp.to_lp_string)
+    lp.put_logfunc(nil)
+    assert_equal(0, lp.solve)
+    assert_raise(TypeError) { lp.put_logfunc(42) }
+  end
+
+  # Check put_msgfunc()
+  def test_put_msgfunc
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_int(1, true)
+    lp.set_int(2, true)
+    events = []
+    lp.put_msgfunc(interval: 0, incumbent: true) { |event| events << event }
+    assert_equal(0, lp.solve)
+    assert(!events.empty?)
+    assert(events.all? { |e| e[:nodes] >= 0 && e[:elapsed] >= 0 })
+    found = events.select { |e| e[:incumbent] }
+    assert(!found.empty?)
+    assert_equal(2, found.last[:incumbent].unpack("d*").size)
+
+    lp.put_msgfunc(LPSolve::MSG_MILPBETTER | LPSolve::MSG_MILPFEASIBLE) do
+      raise "stop"
+    end
+    assert_raise(RuntimeError) { lp.solve }
+    before = lp.to_lp_string
+    assert_raise(RuntimeError) { lp.sweep_obj(1, [143.0, 100.0]) }
+    assert_equal(before, lp.to_lp_string)
+    rounds = 0
+    assert_raise(RuntimeError) { lp.solve_with_cuts { rounds += 1; nil } }
+    assert_equal(0, rounds)
+    lp.put_msgfunc
+    assert_equal(0, lp.solve)
+  end
+
+  # Check set_var_branch(), set_var_weights() and put_bb_*func()
+  def test_branching
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_int(1, true)
+    lp.set_int(2, true)
+    assert_equal(0, lp.solve)
+    best = lp.objective
+
+    assert lp.set_var_priority([2.0, 1.0])
+    assert_equal(1, lp.get_var_priority(2))
+    assert_equal(false, lp.set_var_weights([1.0]))
+    assert lp.set_var_branch(1, LPSolve::BRANCH_FLOOR)
+    assert_equal(LPSolve::BRANCH_FLOOR, lp.get_var_branch(1))
+    assert_nil(lp.get_var_branch(3))
+    assert_nil(lp.get_var_priority("1"))
+    assert_equal(false, lp.set_var_branch(0, LPSolve::BRANCH_FLOOR))
+    assert_equal(0, lp.solve)
+    assert_in_delta(best, lp.objective, 0.0001)
+
+    nodes = []
+    lp.put_bb_nodefunc do |x, vartype|
+      nodes << [x.unpack("d*").size, vartype]
+      nil
+    end
+    lp.put_bb_branchfunc { |column| column == 2 }
+    assert_equal(0, lp.solve)
+    assert_in_delta(best, lp.objective, 0.0001)
+    assert(nodes.all? { |n| n == [2, LPSolve::BB_INT] })
+
+    lp.put_bb_nodefunc { |x, vartype| raise "no node" }
+    before = lp.to_lp_string
+    assert_raise(RuntimeError) { lp.sweep_obj(1, [143.0, 100.0]) }
+    assert_equal(before, lp.to_lp_string)
+    lp.put_bb_nodefunc
+    lp.put_bb_branchfunc
+    assert_equal(0, lp.solve)
+  end
+
+  # Check the early termination options of solve()
+  def test_solve_policies
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.set_int(1, true)
+    lp.set_int(2, true)
+    assert_equal(0, lp.solve)
+    assert_nil(lp.termination)
+    best = lp.objective
+
+    assert_equal(0, lp.solve(deadline: 60, stall_nodes: 1_000_000,
+                             stall_seconds: 60))
+    assert_nil(lp.termination)
+    assert_in_delta(best, lp.objective, 0.0001)
+
+    status = lp.solve(deadline: Time.now - 1)
+    assert_equal(:deadline, lp.termination)
+    assert_not_equal(0, status)
+
+    assert_equal(0, lp.solve)
+    assert_nil(lp.get_termination)
+
+    # Jeroslow's parity problem: an incumbent with y = 1 turns up after
+    # a dive, but proving it optimal takes exponentially many nodes, so
+    # only a policy ends the search.
+    n = 25
+    parity = lambda do
+      lp = LPSolve.new(0, n + 1)
+      lp.set_verbose(LPSolve::IMPORTANT)
+      lp.set_obj_fnex([[n + 1, 1]])
+      lp.add_constraintex("parity", (1..n).map { |j| [j, 2] } + [[n + 1, 1]],
+                          LPSolve::EQ, n)
+      (1..n).each { |j| lp.set_binary(j, true) }
+      lp
+    end
+    lp = parity.call
+    lp.solve(gap: 1e30, deadline: 60)
+    assert_equal(:gap, lp.termination)
+    lp = parity.call
+    lp.solve(stall_nodes: 1, deadline: 60)
+    assert_equal(:stall_nodes, lp.termination)
+  end
+
+  # Check save_binary() and load_binary()
+  def test_binary_snapshot
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    lp.add_SOS("SOS1", 1, 1, [[1, 1], [2, 2]])
+    lp.set_int(2, true)
+    lp.set_mip_gap(true, 0.5)
+    assert(lp.save_binary("foo.lpsnap"))
+    copy = LPSolve.load_binary("foo.lpsnap")
+    assert_equal(LPSolve, copy.class)
+    assert_equal(lp.to_lp_string, copy.to_lp_string)
+    assert_equal(0.5, copy.get_mip_gap(true))
+    assert copy.maxim?
+    lp.solve
+    copy.solve
+    assert_in_delta(lp.objective, copy.objective, 0.0001)
+    assert_equal(nil, LPSolve.load_binary("foo.lp"))
+    assert_equal(nil, LPSolve.load_binary("no-such-file.lpsnap"))
+    data = File.binread("foo.lpsnap")
+    File.binwrite("foo.lpsnap", data[0, data.size - 8])
+    assert_equal(nil, LPSolve.load_binary("foo.lpsnap"))
+  ensure
+    File.delete("foo.lpsnap") if File.exist?("foo.lpsnap")
+  end
+
+  # Check Marshal.dump() and Marshal.load()
+  def test_marshal
+    lp = LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    copy = Marshal.load(Marshal.dump(lp))
+    assert_equal(LPSolve, copy.class)
+    assert_equal(lp.to_lp_string, copy.to_lp_string)
+    assert_equal(0, lp.solve)
+    copy = Marshal.load(Marshal.dump(lp))
+    # A loaded model has no solution yet (SOLVE_NOT_CALLED).
+    assert_equal(-10, copy.status)
+    assert_equal(0, copy.solve)
+    assert_in_delta(lp.objective, copy.objective, 0.0001)
+    assert(copy.total_iter <= lp.total_iter)
+  end
+
+  # Check the parsed-model cache of read_LP() and read_MPS()
+  def test_model_cache
+    LPSolve.model_cache_dir = "foo-cache"
+    assert_equal("foo-cache", LPSolve.model_cache_dir)
+    lp = LPSolve.read_MPS("../example/model.mps", LPSolve::IMPORTANT)
+    assert_equal(1, Dir["foo-cache/*.lpsnap"].size)
+    cached = LPSolve.read_MPS("../example/model.mps", LPSolve::IMPORTANT)
+    assert_equal(lp.to_mps_string, cached.to_mps_string)
+    LPSolve.read_LP("../example/model.lp", LPSolve::IMPORTANT, "LP model")
+    assert_equal(2, Dir["foo-cache/*.lpsnap"].size)
+    assert_equal(nil, LPSolve.read_MPS("no-such-file.mps", LPSolve::IMPORTANT))
+  ensure
+    LPSolve.model_cache_dir = nil
+    Dir["foo-cache/*"].each { |f| File.delete(f) }
+    Dir.rmdir("foo-cache") if File.directory?("foo-cache")
+  end
+
+  # Check reading and writing gzip-compressed models
+  def test_compressed
+    lp = LPSolve.read_MPS("../example/model.mps", LPSolve::IMPORTANT)
+    assert(lp.write_mps("foo.mps.gz"))
+    assert(lp.write_lp("foo.lp.gz"))
+    gz_lp = LPSolve.read_MPS("foo.mps.gz", LPSolve::IMPORTANT)
+    assert_equal(LPSolve, gz_lp.class)
+    assert_equal(lp.to_mps_string, gz_lp.to_mps_string)
+    gz_lp = LPSolve.read_LP("foo.lp.gz", LPSolve::IMPORTANT, "LP model")
+    assert_equal(LPSolve, gz_lp.class)
+    assert_equal(lp.get_column(1), gz_lp.get_column(1))
+    assert_equal(nil, LPSolve.read_MPS("no-such-file.mps.gz", 
+                                       LPSolve::IMPORTANT))
+  ensure
+    File.delete("foo.mps.gz") if File.exist?("foo.mps.gz")
+    File.delete("foo.lp.gz") if File.exist?("foo.lp.gz")
+  end
+
   # Check set_row_name(), set_orig_row_name() and get_row_name()
   def test_row_name
     # Test Invalid parameter type, should be a string.